@@ -6,10 +6,23 @@
 #include <ctime>
 #include <cstdlib>
 #include <string>
+#include <memory>
 #include <iostream>
 #include <fstream>
 #include <io.h>
 #include <fcntl.h>
+#include "CubeCore.h"
+#include "CubeEvents.h"
+#include "CubeClock.h"
+#include "CubeGL.h"
+#include "CubeImpostor.h"
+#include "CubePresent.h"
+#include "CubeRenderBackend.h"
+#include "CubeRenderThreads.h"
+#include "CubeReplay.h"
+#include "CubeScheduler.h"
+#include "CubeSnapshot.h"
+#include "CubeTopology.h"
 
 #pragma comment(lib, "opengl32.lib")
 #pragma comment(lib, "glu32.lib")
@@ -18,34 +31,37 @@
 
 #define REGISTRY_KEY "Software\\BouncingCubeScreensaver"
 
-struct Cube {
-    float x, y, z;  // Screen space coordinates in pixels
-    float vx, vy, vz;  // Velocity in pixels per frame
-    float rotationMatrix[16];  // 4x4 rotation matrix to preserve orientation
-    float rotationAxisX, rotationAxisY, rotationAxisZ;  // Current rotation axis
-    float rotationSpeed;  // Angular velocity
-    COLORREF color;
-    bool celebratingCorner;
-    int celebrationTimer;
-    bool active;  // Whether this cube is currently visible
-};
+// Windows 10 1803 and later; older SDKs lack the name
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
 struct Monitor {
     RECT bounds;
     HDC hdc;
     HGLRC hglrc;
     HWND hwnd;
+    bool primary;
+    int refreshHz;  // Of the current display mode; frames are scheduled at this rate
+    InstancedGLBackend instanced;  // Every cube in one draw; not valid without GLSL and instanced arrays
+    RetainedGLBackend retained;  // Otherwise the mesh alone; not valid where hglrc lacks buffer objects
+    ImpostorRenderBackend impostor;  // --impostor: the frame drawn from sprites in memory
+    std::vector<unsigned int> present;  // --impostor: BGRA copy of a changed rectangle for SetDIBitsToDevice
 };
 
 // Global cube that moves between monitors
 Cube globalCube;
+Cube g_PreviousCube;  // globalCube one physics step earlier, for render interpolation
+FixedStepClock g_PhysicsClock;
+DisplayTopology g_Topology;  // Monitor layout, rebuilt on WM_DISPLAYCHANGE
+PresentTracker g_Presents;  // What each monitor last presented, so unchanged ones are skipped
 
 std::vector<Monitor> monitors;
 float g_CubeSize = 0.1f;  // Default cube scale for 3D rendering
 bool g_EnableCelebration = false;  // Default celebration setting
 bool g_MirrorMode = false;  // Default mirror mode disabled for multi-monitor support
-const float SPEED_MULTIPLIER = 1.0f;
-const int CELEBRATION_DURATION = 60;
+unsigned long long g_Seed = 0;  // Random seed for the cube's bounce stream
+bool g_SeedFromCommandLine = false;  // --seed given, so runs are reproducible
 
 // Command line arguments
 bool g_PreviewMode = false;
@@ -53,32 +69,24 @@ HWND g_PreviewHWND = NULL;
 HANDLE g_ExitEvent = NULL;
 bool g_StandaloneMode = false;
 DWORD g_StartupTime = 0;  // Track startup time to ignore initial mouse movements
+LARGE_INTEGER g_LastFrameCounter = {};  // Performance counter at the last AdvanceFrame
+LARGE_INTEGER g_CounterFrequency = {};
+DWORD g_DisplayOffTime = 0;  // Nonzero while the display is off and physics is paused
+std::string g_RecordPath;  // --record: replay log written on exit, played back by BouncingCubeBench replay
+ReplayRecorder g_Recorder;
+SteadySchedulerClock g_SchedulerClock;
+FrameScheduler g_Scheduler(g_SchedulerClock);  // One deadline per monitor at its refresh rate
+HANDLE g_FrameTimer = NULL;  // Waitable timer set to the scheduler's next deadline
+bool g_RenderThreads = true;  // Every monitor renders and presents on its own thread; off with --singleThread
+bool g_Impostor = false;  // --impostor: no OpenGL; cubes blitted from a sprite atlas and presented through GDI
+std::vector<std::unique_ptr<CubeSpriteAtlasLoader> > g_SpriteAtlases;  // --impostor: one per monitor height
+
+// GUID_CONSOLE_DISPLAY_STATE, spelled out to avoid depending on INITGUID
+const GUID g_DisplayStateGuid = { 0x6fe69556, 0x704a, 0x47a0, { 0x8f, 0x24, 0xc2, 0x8d, 0x93, 0x6f, 0xda, 0x47 } };
 
 // Forward declaration
 void ParseCommandLine(LPWSTR cmdLine);
 
-void MultiplyMatrix4x4(float result[16], const float a[16], const float b[16]) {
-    for (int i = 0; i < 4; i++) {
-        for (int j = 0; j < 4; j++) {
-            result[i * 4 + j] = 0;
-            for (int k = 0; k < 4; k++) {
-                result[i * 4 + j] += a[i * 4 + k] * b[k * 4 + j];
-            }
-        }
-    }
-}
-
-void CreateRotationMatrix(float matrix[16], float angle, float x, float y, float z) {
-    float c = cos(angle * 3.14159f / 180.0f);
-    float s = sin(angle * 3.14159f / 180.0f);
-    float ic = 1.0f - c;
-    
-    matrix[0] = c + x*x*ic;     matrix[1] = x*y*ic - z*s;   matrix[2] = x*z*ic + y*s;   matrix[3] = 0;
-    matrix[4] = y*x*ic + z*s;   matrix[5] = c + y*y*ic;     matrix[6] = y*z*ic - x*s;   matrix[7] = 0;
-    matrix[8] = z*x*ic - y*s;   matrix[9] = z*y*ic + x*s;   matrix[10] = c + z*z*ic;    matrix[11] = 0;
-    matrix[12] = 0;             matrix[13] = 0;             matrix[14] = 0;             matrix[15] = 1;
-}
-
 void LoadSettings() {
     HKEY hKey;
     if (RegOpenKeyEx(HKEY_CURRENT_USER, REGISTRY_KEY, 0, KEY_READ, &hKey) == ERROR_SUCCESS) {
@@ -101,76 +109,136 @@ void LoadSettings() {
     }
 }
 
-float GetCubeSizeInPixels() {
-    return g_CubeSize * 500.0f;  // Scale factor to convert to reasonable pixel size
-}
-
 BOOL CALLBACK MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData) {
-    MONITORINFO mi = { sizeof(MONITORINFO) };
-    if (GetMonitorInfo(hMonitor, &mi)) {
+    MONITORINFOEXA mi;
+    mi.cbSize = sizeof(mi);
+    if (GetMonitorInfoA(hMonitor, (MONITORINFO*)&mi)) {
         Monitor mon;
         mon.bounds = mi.rcMonitor;  // Use full monitor bounds instead of work area
         mon.hwnd = NULL;
         mon.hdc = NULL;
         mon.hglrc = NULL;
+        mon.primary = (mi.dwFlags & MONITORINFOF_PRIMARY) != 0;
+        
+        // 0 and 1 mean the hardware's default rate
+        DEVMODEA mode = {};
+        mode.dmSize = sizeof(mode);
+        mon.refreshHz = 60;
+        if (EnumDisplaySettingsA(mi.szDevice, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+            mon.refreshHz = (int)mode.dmDisplayFrequency;
+        }
         
         monitors.push_back(mon);
     }
     return TRUE;
 }
 
-void InitializeCube() {
-    // Get total desktop bounds
-    RECT physicsBounds = {0};
-    for (const auto& mon : monitors) {
-        if (mon.bounds.left < physicsBounds.left) physicsBounds.left = mon.bounds.left;
-        if (mon.bounds.top < physicsBounds.top) physicsBounds.top = mon.bounds.top;
-        if (mon.bounds.right > physicsBounds.right) physicsBounds.right = mon.bounds.right;
-        if (mon.bounds.bottom > physicsBounds.bottom) physicsBounds.bottom = mon.bounds.bottom;
+// Precompute everything the frame loop needs about the current monitors
+void RebuildTopology() {
+    std::vector<WorldBounds> layout;
+    int primary = 0;
+    for (size_t i = 0; i < monitors.size(); i++) {
+        WorldBounds bounds = { monitors[i].bounds.left, monitors[i].bounds.top, monitors[i].bounds.right, monitors[i].bounds.bottom };
+        layout.push_back(bounds);
+        if (monitors[i].primary) primary = (int)i;
     }
+    g_Topology.Build(layout, primary, g_MirrorMode, GetCubeSizeInPixels(g_CubeSize));
+}
+
+void InitializeCube() {
+    RebuildTopology();
     
     // Start cube in center of primary monitor
-    if (!monitors.empty()) {
-        POINT origin = {0, 0};
-        HMONITOR hPrimary = MonitorFromPoint(origin, MONITOR_DEFAULTTOPRIMARY);
-        
-        const Monitor* primary = &monitors[0];  // fallback
-        for (const auto& mon : monitors) {
-            MONITORINFO mi = { sizeof(MONITORINFO) };
-            HMONITOR hMon = MonitorFromRect(&mon.bounds, MONITOR_DEFAULTTONEAREST);
-            if (hMon == hPrimary) {
-                primary = &mon;
-                break;
-            }
+    if (g_Topology.OutputCount() > 0) {
+        ResetCube(globalCube, 0.0f, 0.0f, g_Seed, 0);
+        PlaceCubeOnPrimary(globalCube, g_Topology);
+    }
+}
+
+// `name` in the per-user BouncingCube folder, or `fallback` in the working
+// directory if there is no such folder
+std::string GetDataPath(const char* name, const char* fallback) {
+    char folder[MAX_PATH];
+    DWORD length = GetEnvironmentVariableA("LOCALAPPDATA", folder, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) return fallback;
+    std::string path = std::string(folder) + "\\BouncingCube";
+    CreateDirectoryA(path.c_str(), NULL);
+    return path + "\\" + name;
+}
+
+// Per-user file the world is saved to on exit and resumed from on startup. The
+// preview and fullscreen instances share it, so whichever runs next picks up
+// the cube where the other left it.
+std::string GetSnapshotPath() {
+    return GetDataPath("world.snap", "BouncingCube.snap");
+}
+
+// --impostor: load each monitor height's sprite atlas from its cache file, or
+// build and cache it, in the background. Monitors are rasterized exactly
+// until theirs is ready.
+void StartSpriteAtlases() {
+    for (size_t i = 0; i < g_Topology.OutputCount(); i++) {
+        CubeSpriteKey key = { g_CubeSize, g_Topology.Output(i).height, SPRITE_GRID };
+        bool started = false;
+        for (size_t a = 0; a < g_SpriteAtlases.size(); a++) {
+            started = started || (g_SpriteAtlases[a]->Key().cubeSize == key.cubeSize &&
+                                  g_SpriteAtlases[a]->Key().outputHeight == key.outputHeight);
         }
-        globalCube.x = (primary->bounds.left + primary->bounds.right) / 2.0f;
-        globalCube.y = (primary->bounds.top + primary->bounds.bottom) / 2.0f;
-        globalCube.z = 0.0f;
-        
-        float angle = (static_cast<float>(rand()) / RAND_MAX) * 2.0f * 3.14159f;
-        float speed = 2.0f + (static_cast<float>(rand()) / RAND_MAX) * 3.0f;
-        globalCube.vx = cos(angle) * speed * SPEED_MULTIPLIER;
-        globalCube.vy = sin(angle) * speed * SPEED_MULTIPLIER;
-        globalCube.vz = 0;
-        
-        // Initialize rotation matrix as identity
-        for (int i = 0; i < 16; i++) globalCube.rotationMatrix[i] = 0.0f;
-        globalCube.rotationMatrix[0] = globalCube.rotationMatrix[5] = globalCube.rotationMatrix[10] = globalCube.rotationMatrix[15] = 1.0f;
-        
-        // Random rotation axis (normalized)
-        float axisX = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisY = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisZ = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisLength = sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
-        globalCube.rotationAxisX = axisX / axisLength;
-        globalCube.rotationAxisY = axisY / axisLength;
-        globalCube.rotationAxisZ = axisZ / axisLength;
-        globalCube.rotationSpeed = ((rand() % 2 == 0) ? 1 : -1) * (0.5f + (static_cast<float>(rand()) / RAND_MAX) * 2.0f);
-        globalCube.color = RGB(rand() % 128 + 128, rand() % 128 + 128, rand() % 128 + 128);
-        globalCube.celebratingCorner = false;
-        globalCube.celebrationTimer = 0;
-        globalCube.active = true;
+        if (started) continue;
+        char name[64];
+        sprintf_s(name, sizeof(name), "sprites-%g-%d.atlas", key.cubeSize, key.outputHeight);
+        g_SpriteAtlases.push_back(std::unique_ptr<CubeSpriteAtlasLoader>(new CubeSpriteAtlasLoader()));
+        g_SpriteAtlases.back()->Start(key, GetDataPath(name, name));
+    }
+}
+
+// The atlas for monitors of this height, NULL while it is still loading
+const CubeSpriteAtlas* ReadySpriteAtlas(int outputHeight) {
+    for (size_t a = 0; a < g_SpriteAtlases.size(); a++) {
+        const CubeSpriteKey& key = g_SpriteAtlases[a]->Key();
+        if (key.cubeSize == g_CubeSize && key.outputHeight == outputHeight) return g_SpriteAtlases[a]->Ready();
+    }
+    return NULL;
+}
+
+void SaveWorldSnapshot() {
+    if (g_SeedFromCommandLine || g_Topology.OutputCount() == 0) return;
+    CubeSoA world;
+    world.Resize(1);
+    world.SetCube(0, globalCube);
+    world.stepsSinceNormalize = globalCube.stepsSinceNormalize;
+    CubeSnapshotInfo info = { g_Seed, g_Topology.LayoutHash(), g_Topology.PhysicsBounds(), g_CubeSize };
+    WriteCubeSnapshot(GetSnapshotPath().c_str(), world, info);
+}
+
+// Pick up the cube saved by the last activation. A run with --seed starts fresh
+// so it stays reproducible.
+bool ResumeWorldSnapshot() {
+    if (g_SeedFromCommandLine) return false;
+    CubeSoA world;
+    CubeSnapshotInfo info;
+    if (!ReadCubeSnapshot(GetSnapshotPath().c_str(), world, info) || world.Size() == 0) return false;
+    
+    Cube cube;
+    world.GetCube(0, cube);
+    const WorldBounds& bounds = g_Topology.PhysicsBounds();
+    if (info.layoutHash != g_Topology.LayoutHash()) {
+        // Monitors changed since the save: keep the cube at the same relative spot
+        float savedWidth = (float)(info.bounds.right - info.bounds.left);
+        float savedHeight = (float)(info.bounds.bottom - info.bounds.top);
+        if (savedWidth <= 0 || savedHeight <= 0) return false;
+        cube.x = bounds.left + (cube.x - info.bounds.left) / savedWidth * (bounds.right - bounds.left);
+        cube.y = bounds.top + (cube.y - info.bounds.top) / savedHeight * (bounds.bottom - bounds.top);
     }
+    KeepCubeOnDesktop(cube, g_Topology);
+    
+    globalCube = cube;
+    g_Seed = info.seed;
+    return true;
+}
+
+static void* LoadWglProc(const char* name) {
+    return (void*)wglGetProcAddress(name);
 }
 
 void InitOpenGL(HWND hwnd, Monitor& mon) {
@@ -222,135 +290,38 @@ void InitOpenGL(HWND hwnd, Monitor& mon) {
     }
     glLog << L"wglMakeCurrent succeeded" << std::endl;
     
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_COLOR_MATERIAL);
+    // The scheduler decides when frames are drawn; the swap interval only says
+    // whether a swap waits for vblank. Render threads each set their own. Here
+    // one thread presents every monitor, and waiting on each vblank in turn
+    // would hold a fast monitor to a slow one's rate, so only a lone monitor waits.
+    typedef BOOL (WINAPI* SwapIntervalProc)(int);
+    SwapIntervalProc swapInterval = (SwapIntervalProc)wglGetProcAddress("wglSwapIntervalEXT");
+    if (swapInterval) {
+        swapInterval(monitors.size() == 1 ? 1 : 0);
+        glLog << L"Swap interval set" << std::endl;
+    }
     
-    float lightPos[] = {0.0f, 0.0f, 1.0f, 0.0f};
-    float lightAmb[] = {0.2f, 0.2f, 0.2f, 1.0f};
-    float lightDiff[] = {0.8f, 0.8f, 0.8f, 1.0f};
+    SetupCubeLighting();
     
-    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmb);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiff);
+    // The cube mesh goes to the GPU once; every frame after that only streams
+    // an instance per cube, or failing that sends a matrix and a color per cube
+    if (mon.instanced.Create(LoadWglProc, g_CubeSize)) {
+        glLog << L"Cube mesh uploaded to vertex buffers, drawn instanced" << std::endl;
+    } else if (mon.retained.Create(LoadWglProc, g_CubeSize)) {
+        glLog << L"Cube mesh uploaded to vertex buffers" << std::endl;
+    } else {
+        glLog << L"No vertex buffer objects, drawing in immediate mode" << std::endl;
+    }
     
     glLog << L"OpenGL initialization completed successfully" << std::endl;
     glLog.close();
 }
 
-void DrawCube(const Cube& cube, const Monitor& mon) {
-    float aspect = (float)(mon.bounds.right - mon.bounds.left) / (mon.bounds.bottom - mon.bounds.top);
-    
-    float monitorWidth = (float)(mon.bounds.right - mon.bounds.left);
-    float monitorHeight = (float)(mon.bounds.bottom - mon.bounds.top);
-    float relPosX = (cube.x - mon.bounds.left) / monitorWidth;
-    float relPosY = (cube.y - mon.bounds.top) / monitorHeight;
-    
-    float relX = (relPosX * 4.0f * aspect) - (2.0f * aspect);
-    float relY = -((relPosY * 4.0f) - 2.0f);
-    
-    float cubeScale = g_CubeSize;
-    
-    glPushMatrix();
-    glTranslatef(relX, relY, -5.0f);
-    glMultMatrixf(cube.rotationMatrix);
-    
-    float r = GetRValue(cube.color) / 255.0f;
-    float g = GetGValue(cube.color) / 255.0f;
-    float b = GetBValue(cube.color) / 255.0f;
-    
-    if (cube.celebratingCorner) {
-        float pulse = (sin(cube.celebrationTimer * 0.3f) + 1.0f) / 2.0f;
-        r = r * 0.5f + pulse * 0.5f;
-        g = g * 0.5f + pulse * 0.5f;
-        b = b * 0.5f + pulse * 0.5f;
-        glScalef(1.0f + pulse * 0.2f, 1.0f + pulse * 0.2f, 1.0f + pulse * 0.2f);
-    }
-    
-    glColor3f(r, g, b);
-    
-    glBegin(GL_QUADS);
-    // Front face
-    glNormal3f(0.0f, 0.0f, 1.0f);
-    glVertex3f(-cubeScale, -cubeScale, cubeScale);
-    glVertex3f(cubeScale, -cubeScale, cubeScale);
-    glVertex3f(cubeScale, cubeScale, cubeScale);
-    glVertex3f(-cubeScale, cubeScale, cubeScale);
-    
-    // Back face
-    glNormal3f(0.0f, 0.0f, -1.0f);
-    glVertex3f(-cubeScale, -cubeScale, -cubeScale);
-    glVertex3f(-cubeScale, cubeScale, -cubeScale);
-    glVertex3f(cubeScale, cubeScale, -cubeScale);
-    glVertex3f(cubeScale, -cubeScale, -cubeScale);
-    
-    // Top face
-    glNormal3f(0.0f, 1.0f, 0.0f);
-    glVertex3f(-cubeScale, cubeScale, -cubeScale);
-    glVertex3f(-cubeScale, cubeScale, cubeScale);
-    glVertex3f(cubeScale, cubeScale, cubeScale);
-    glVertex3f(cubeScale, cubeScale, -cubeScale);
-    
-    // Bottom face
-    glNormal3f(0.0f, -1.0f, 0.0f);
-    glVertex3f(-cubeScale, -cubeScale, -cubeScale);
-    glVertex3f(cubeScale, -cubeScale, -cubeScale);
-    glVertex3f(cubeScale, -cubeScale, cubeScale);
-    glVertex3f(-cubeScale, -cubeScale, cubeScale);
-    
-    // Right face
-    glNormal3f(1.0f, 0.0f, 0.0f);
-    glVertex3f(cubeScale, -cubeScale, -cubeScale);
-    glVertex3f(cubeScale, cubeScale, -cubeScale);
-    glVertex3f(cubeScale, cubeScale, cubeScale);
-    glVertex3f(cubeScale, -cubeScale, cubeScale);
-    
-    // Left face
-    glNormal3f(-1.0f, 0.0f, 0.0f);
-    glVertex3f(-cubeScale, -cubeScale, -cubeScale);
-    glVertex3f(-cubeScale, -cubeScale, cubeScale);
-    glVertex3f(-cubeScale, cubeScale, cubeScale);
-    glVertex3f(-cubeScale, cubeScale, -cubeScale);
-    glEnd();
-    
-    glPopMatrix();
-}
-
-void UpdateCube() {
+// Standalone-mode trace of the physics bounds and cube
+void LogCubeDebug() {
     if (!globalCube.active) return;
     
-    globalCube.x += globalCube.vx;
-    globalCube.y += globalCube.vy;
-    
-    float rotMatrix[16];
-    CreateRotationMatrix(rotMatrix, globalCube.rotationSpeed, 
-                        globalCube.rotationAxisX, globalCube.rotationAxisY, globalCube.rotationAxisZ);
-    
-    float newMatrix[16];
-    MultiplyMatrix4x4(newMatrix, rotMatrix, globalCube.rotationMatrix);
-    
-    for (int i = 0; i < 16; i++) {
-        globalCube.rotationMatrix[i] = newMatrix[i];
-    }
-    
-    // Get bounds for physics (either primary monitor only or total desktop)
-    RECT physicsBounds;
-    
-    
-    if (g_MirrorMode) {
-        // Primary monitor only
-        HMONITOR hPrimary = MonitorFromPoint({0, 0}, MONITOR_DEFAULTTOPRIMARY);
-        MONITORINFO mi = { sizeof(mi) };
-        GetMonitorInfo(hPrimary, &mi);
-        physicsBounds = mi.rcMonitor;
-    } else {
-        // All monitors - use system metrics for the virtual screen
-        physicsBounds.left = GetSystemMetrics(SM_XVIRTUALSCREEN);
-        physicsBounds.top = GetSystemMetrics(SM_YVIRTUALSCREEN);
-        physicsBounds.right = physicsBounds.left + GetSystemMetrics(SM_CXVIRTUALSCREEN);
-        physicsBounds.bottom = physicsBounds.top + GetSystemMetrics(SM_CYVIRTUALSCREEN);
-    }
+    const WorldBounds& physicsBounds = g_Topology.PhysicsBounds();
     
     // Enhanced debug output for physics bounds and cube position
     if (g_StandaloneMode) {
@@ -379,7 +350,7 @@ void UpdateCube() {
                 << L" bottom=" << physicsBounds.bottom << std::endl;
             debugFile << L"cube.x=" << globalCube.x << L" cube.y=" << globalCube.y << std::endl;
             debugFile << L"cube velocity: vx=" << globalCube.vx << L" vy=" << globalCube.vy << std::endl;
-            debugFile << L"CUBE_SIZE=" << GetCubeSizeInPixels() << std::endl;
+            debugFile << L"CUBE_SIZE=" << GetCubeSizeInPixels(g_CubeSize) << std::endl;
             
             // Also print monitor info
             debugFile << L"Monitors:" << std::endl;
@@ -400,187 +371,321 @@ void UpdateCube() {
         }
         debugCounter++;
     }
-    
-    bool hitCorner = false;
-    const float CUBE_SIZE = GetCubeSizeInPixels();
-    const float CORNER_THRESHOLD = CUBE_SIZE * 2;
-    
-    // Check boundaries against physics area - exact copy from main.cpp
-    if (globalCube.x - CUBE_SIZE <= physicsBounds.left) {
-        globalCube.x = physicsBounds.left + CUBE_SIZE;
-        globalCube.vx = -globalCube.vx;
-        
-        // Add randomness that makes bounce more extreme (1-3 degrees in current direction)
-        float currentAngle = atan2(globalCube.vy, globalCube.vx);
-        float randomOffset = (static_cast<float>(rand()) / RAND_MAX) * 0.052f; // 0-3 degrees in radians
-        if (globalCube.vy > 0) randomOffset = -randomOffset; // Make bounce more extreme away from wall
-        else randomOffset = randomOffset;
-        
-        float speed = sqrt(globalCube.vx * globalCube.vx + globalCube.vy * globalCube.vy);
-        float newAngle = currentAngle + randomOffset;
-        globalCube.vx = cos(newAngle) * speed;
-        globalCube.vy = sin(newAngle) * speed;
-        
-        // Change to new random rotation axis and speed - matrix preserves current orientation
-        float axisX = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisY = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisZ = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisLength = sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
-        globalCube.rotationAxisX = axisX / axisLength;
-        globalCube.rotationAxisY = axisY / axisLength;
-        globalCube.rotationAxisZ = axisZ / axisLength;
-        globalCube.rotationSpeed = ((rand() % 2 == 0) ? 1 : -1) * (0.5f + (static_cast<float>(rand()) / RAND_MAX) * 3.0f);
+}
+
+ImmediateGLBackend g_ImmediateBackend;  // For contexts without buffer objects
+RenderCommandList g_Frame;  // Built once per frame, replayed on every monitor
+
+// Replay the frame into one monitor and present it, its context already current
+void PresentScene(Monitor& mon, const DisplayOutput& output, const RenderCommandList& commands) {
+    if (mon.instanced.Valid()) {
+        mon.instanced.Execute(commands, output);
+    } else if (mon.retained.Valid()) {
+        mon.retained.Execute(commands, output);
+    } else {
+        g_ImmediateBackend.Execute(commands, output);
+    }
+    SwapBuffers(mon.hdc);
+}
+
+// --impostor: draw the frame in memory and copy only what changed to the window
+void PresentImpostor(Monitor& mon, const DisplayOutput& output, const RenderCommandList& commands) {
+    mon.impostor.SetAtlas(ReadySpriteAtlas(output.height));
+    mon.impostor.Execute(commands, output);
+    const SoftwareFramebuffer& framebuffer = mon.impostor.Framebuffer();
+    const std::vector<RasterRect>& dirty = mon.impostor.DirtyRects();
+    for (size_t d = 0; d < dirty.size(); d++) {
+        const RasterRect& rect = dirty[d];
+        int width = rect.right - rect.left, height = rect.bottom - rect.top;
         
-        if (abs(globalCube.y - physicsBounds.top) < CORNER_THRESHOLD || 
-            abs(globalCube.y - physicsBounds.bottom) < CORNER_THRESHOLD) {
-            hitCorner = true;
+        // RGBA to the BGRA a DIB holds
+        mon.present.resize((size_t)width * height);
+        for (int y = 0; y < height; y++) {
+            const unsigned int* in = framebuffer.Row(rect.top + y) + rect.left;
+            unsigned int* out = &mon.present[(size_t)y * width];
+            for (int x = 0; x < width; x++) out[x] = (in[x] & 0xFF00FF00u) | ((in[x] & 0xFF) << 16) | ((in[x] >> 16) & 0xFF);
         }
-    } else if (globalCube.x + CUBE_SIZE >= physicsBounds.right) {
-        globalCube.x = physicsBounds.right - CUBE_SIZE;
-        globalCube.vx = -globalCube.vx;
-        
-        // Add randomness that makes bounce more extreme (1-3 degrees in current direction)
-        float currentAngle = atan2(globalCube.vy, globalCube.vx);
-        float randomOffset = (static_cast<float>(rand()) / RAND_MAX) * 0.052f; // 0-3 degrees in radians
-        if (globalCube.vy > 0) randomOffset = randomOffset; // Make bounce more extreme away from wall
-        else randomOffset = -randomOffset;
         
-        float speed = sqrt(globalCube.vx * globalCube.vx + globalCube.vy * globalCube.vy);
-        float newAngle = currentAngle + randomOffset;
-        globalCube.vx = cos(newAngle) * speed;
-        globalCube.vy = sin(newAngle) * speed;
-        
-        // Change to new random rotation axis and speed - matrix preserves current orientation
-        float axisX = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisY = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisZ = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisLength = sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
-        globalCube.rotationAxisX = axisX / axisLength;
-        globalCube.rotationAxisY = axisY / axisLength;
-        globalCube.rotationAxisZ = axisZ / axisLength;
-        globalCube.rotationSpeed = ((rand() % 2 == 0) ? 1 : -1) * (0.5f + (static_cast<float>(rand()) / RAND_MAX) * 3.0f);
-        
-        if (abs(globalCube.y - physicsBounds.top) < CORNER_THRESHOLD || 
-            abs(globalCube.y - physicsBounds.bottom) < CORNER_THRESHOLD) {
-            hitCorner = true;
-        }
+        BITMAPINFO info = {};
+        info.bmiHeader.biSize = sizeof(info.bmiHeader);
+        info.bmiHeader.biWidth = width;
+        info.bmiHeader.biHeight = -height;  // Top-down
+        info.bmiHeader.biPlanes = 1;
+        info.bmiHeader.biBitCount = 32;
+        info.bmiHeader.biCompression = BI_RGB;
+        SetDIBitsToDevice(mon.hdc, rect.left, rect.top, width, height, 0, 0, 0, height, &mon.present[0], &info, DIB_RGB_COLORS);
+    }
+}
+
+// False if nothing was presented because the context had to be recreated
+bool RenderScene(Monitor& mon, const DisplayOutput& output, const RenderCommandList& commands) {
+    if (g_Impostor) {
+        PresentImpostor(mon, output, commands);
+        return true;
     }
     
-    if (globalCube.y - CUBE_SIZE <= physicsBounds.top) {
-        globalCube.y = physicsBounds.top + CUBE_SIZE;
-        globalCube.vy = -globalCube.vy;
-        
-        // Add randomness that makes bounce more extreme (1-3 degrees in current direction)
-        float currentAngle = atan2(globalCube.vy, globalCube.vx);
-        float randomOffset = (static_cast<float>(rand()) / RAND_MAX) * 0.052f; // 0-3 degrees in radians
-        if (globalCube.vx > 0) randomOffset = randomOffset; // Make bounce more extreme away from wall
-        else randomOffset = -randomOffset;
-        
-        float speed = sqrt(globalCube.vx * globalCube.vx + globalCube.vy * globalCube.vy);
-        float newAngle = currentAngle + randomOffset;
-        globalCube.vx = cos(newAngle) * speed;
-        globalCube.vy = sin(newAngle) * speed;
-        
-        // Change to new random rotation axis and speed - matrix preserves current orientation
-        float axisX = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisY = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisZ = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisLength = sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
-        globalCube.rotationAxisX = axisX / axisLength;
-        globalCube.rotationAxisY = axisY / axisLength;
-        globalCube.rotationAxisZ = axisZ / axisLength;
-        globalCube.rotationSpeed = ((rand() % 2 == 0) ? 1 : -1) * (0.5f + (static_cast<float>(rand()) / RAND_MAX) * 3.0f);
-        
-        if (abs(globalCube.x - physicsBounds.left) < CORNER_THRESHOLD || 
-            abs(globalCube.x - physicsBounds.right) < CORNER_THRESHOLD) {
-            hitCorner = true;
+    BOOL result = wglMakeCurrent(mon.hdc, mon.hglrc);
+    if (!result) {
+        if (mon.hwnd != NULL) {
+            wglDeleteContext(mon.hglrc);
+            InitOpenGL(mon.hwnd, mon);
+            wglMakeCurrent(mon.hdc, mon.hglrc);
         }
-    } else if (globalCube.y + CUBE_SIZE >= physicsBounds.bottom) {
-        globalCube.y = physicsBounds.bottom - CUBE_SIZE;
-        globalCube.vy = -globalCube.vy;
-        
-        // Add randomness that makes bounce more extreme (1-3 degrees in current direction)
-        float currentAngle = atan2(globalCube.vy, globalCube.vx);
-        float randomOffset = (static_cast<float>(rand()) / RAND_MAX) * 0.052f; // 0-3 degrees in radians
-        if (globalCube.vx > 0) randomOffset = -randomOffset; // Make bounce more extreme away from wall
-        else randomOffset = randomOffset;
-        
-        float speed = sqrt(globalCube.vx * globalCube.vx + globalCube.vy * globalCube.vy);
-        float newAngle = currentAngle + randomOffset;
-        globalCube.vx = cos(newAngle) * speed;
-        globalCube.vy = sin(newAngle) * speed;
+        return false;
+    }
+    
+    PresentScene(mon, output, commands);
+    return true;
+}
+
+// One monitor driven from its own render thread, its context current for the
+// thread's whole life. The topology and monitor list stay put while render
+// threads run: they are stopped before either is rebuilt.
+class WglOutputRenderer : public OutputRenderer {
+public:
+    explicit WglOutputRenderer(size_t index) : index(index), shownValid(false), repaint(true), skipped(0) {}
+    
+    bool Begin() {
+        Monitor& mon = monitors[index];
+        if (!wglMakeCurrent(mon.hdc, mon.hglrc)) return false;
         
-        // Change to new random rotation axis and speed - matrix preserves current orientation
-        float axisX = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisY = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisZ = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-        float axisLength = sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
-        globalCube.rotationAxisX = axisX / axisLength;
-        globalCube.rotationAxisY = axisY / axisLength;
-        globalCube.rotationAxisZ = axisZ / axisLength;
-        globalCube.rotationSpeed = ((rand() % 2 == 0) ? 1 : -1) * (0.5f + (static_cast<float>(rand()) / RAND_MAX) * 3.0f);
+        // Each thread waits for its own monitor's vblank
+        typedef BOOL (WINAPI* SwapIntervalProc)(int);
+        SwapIntervalProc swapInterval = (SwapIntervalProc)wglGetProcAddress("wglSwapIntervalEXT");
+        if (swapInterval) swapInterval(1);
+        return true;
+    }
+    
+    void Render(const SceneSnapshot& scene) {
+        const DisplayOutput& output = g_Topology.Output(index);
+        const Cube& cube = scene.cubes[0];
+        const float HALF_SIZE = GetCubeSizeInPixels(g_CubeSize);
+        bool drawCube = g_MirrorMode ||
+                        (cube.x + HALF_SIZE >= output.bounds.left && cube.x - HALF_SIZE <= output.bounds.right &&
+                         cube.y + HALF_SIZE >= output.bounds.top && cube.y - HALF_SIZE <= output.bounds.bottom);
         
-        if (abs(globalCube.x - physicsBounds.left) < CORNER_THRESHOLD || 
-            abs(globalCube.x - physicsBounds.right) < CORNER_THRESHOLD) {
-            hitCorner = true;
+        // Same as PresentTracker, but owned by this thread
+        OutputFrame frame = DescribeOutputFrame(cube, drawCube);
+        if (!repaint.exchange(false) && shownValid && SameOutputFrame(shown, frame)) {
+            skipped++;
+            return;
         }
+        PresentScene(monitors[index], output, scene.commands);
+        shown = frame;
+        shownValid = true;
     }
     
-    if (hitCorner && !globalCube.celebratingCorner && g_EnableCelebration) {
-        globalCube.celebratingCorner = true;
-        globalCube.celebrationTimer = CELEBRATION_DURATION;
+    void End() {
+        wglMakeCurrent(NULL, NULL);
     }
     
-    if (globalCube.celebratingCorner) {
-        globalCube.celebrationTimer--;
-        if (globalCube.celebrationTimer <= 0) {
-            globalCube.celebratingCorner = false;
-        }
+    // Any thread: present the next frame even if it looks unchanged
+    void Invalidate() { repaint.store(true); }
+    
+    HWND Window() const { return monitors[index].hwnd; }
+    long long SkippedFrames() const { return skipped; }
+    
+private:
+    size_t index;
+    OutputFrame shown;
+    bool shownValid;
+    std::atomic<bool> repaint;
+    long long skipped;
+};
+
+OutputRenderThreads g_OutputThreads;
+std::vector<std::unique_ptr<WglOutputRenderer> > g_WglRenderers;
+
+// Hand every monitor's context to a thread of its own, which waits for that
+// monitor's vblank, so each runs at its own refresh rate without tearing. The
+// scheduler keeps driving the simulation, which only publishes scenes from then
+// on. --singleThread keeps presenting here; --impostor has no contexts and
+// always does.
+void StartRenderThreads() {
+    if (!g_RenderThreads || g_Impostor) return;
+    std::vector<OutputRenderer*> renderers;
+    for (size_t i = 0; i < monitors.size() && i < g_Topology.OutputCount(); i++) {
+        if (monitors[i].hglrc == NULL) continue;
+        g_WglRenderers.push_back(std::unique_ptr<WglOutputRenderer>(new WglOutputRenderer(i)));
+        renderers.push_back(g_WglRenderers.back().get());
     }
+    
+    // A context is current on at most one thread; InitOpenGL left the last one here
+    wglMakeCurrent(NULL, NULL);
+    g_OutputThreads.Start(renderers);
 }
 
-void RenderScene(Monitor& mon) {
-    BOOL result = wglMakeCurrent(mon.hdc, mon.hglrc);
-    if (!result) {
-        if (mon.hwnd != NULL) {
-            wglDeleteContext(mon.hglrc);
-            InitOpenGL(mon.hwnd, mon);
-            wglMakeCurrent(mon.hdc, mon.hglrc);
-        }
-        return;
+void StopRenderThreads() {
+    g_OutputThreads.Stop();
+    g_WglRenderers.clear();
+}
+
+// The monitor shows something else than it was last given, e.g. it was uncovered
+void InvalidateMonitor(size_t i) {
+    g_Presents.Invalidate(i);
+    monitors[i].impostor.Invalidate();
+    for (size_t r = 0; r < g_WglRenderers.size(); r++) {
+        if (g_WglRenderers[r]->Window() == monitors[i].hwnd) g_WglRenderers[r]->Invalidate();
+    }
+}
+
+// Deadlines for every monitor at its own refresh rate
+void ResetFrameScheduler() {
+    std::vector<double> periods;
+    for (size_t i = 0; i < monitors.size(); i++) periods.push_back(1.0 / monitors[i].refreshHz);
+    g_Scheduler.SetOutputs(periods);
+}
+
+// Sleep until the next monitor's frame is due. False if a message arrived
+// first; the loop handles it and comes back.
+bool WaitForNextFrame() {
+    double wait = g_Scheduler.NextDeadline() - g_SchedulerClock.Now();
+    if (wait <= SCHEDULER_EARLY_SECONDS) return true;
+    DWORD woke;
+    if (g_FrameTimer) {
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)(wait * 1e7);  // Relative, in 100 ns units
+        SetWaitableTimer(g_FrameTimer, &due, 0, NULL, NULL, FALSE);
+        woke = MsgWaitForMultipleObjectsEx(1, &g_FrameTimer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+    } else {
+        woke = MsgWaitForMultipleObjectsEx(0, NULL, (DWORD)ceil(wait * 1000.0), QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+        if (woke == WAIT_TIMEOUT) woke = WAIT_OBJECT_0;
+    }
+    return woke == WAIT_OBJECT_0 && g_Scheduler.NextDeadline() <= g_SchedulerClock.Now() + SCHEDULER_EARLY_SECONDS;
+}
+
+// Frames the scheduler had to drop because nothing ran in time
+void LogMissedFrames() {
+    static std::vector<MissedDeadline> missed;
+    g_Scheduler.TakeMissed(missed);
+    if (missed.empty()) return;
+    std::wofstream log(L"FrameScheduler_log.txt", std::ios::out | std::ios::app);
+    for (size_t m = 0; m < missed.size(); m++) {
+        log << L"Monitor " << missed[m].output << L" (" << monitors[missed[m].output].refreshHz << L" Hz) missed "
+            << missed[m].frames << L" frame(s), served " << (missed[m].served - missed[m].deadline) * 1000.0
+            << L" ms late" << std::endl;
+    }
+}
+
+// Run the physics steps that came due since the last frame, then draw the
+// monitors in `due` (all of them if NULL) with the cube interpolated to the
+// present moment
+void AdvanceFrame(const std::vector<int>* due) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    long long ticks = now.QuadPart - g_LastFrameCounter.QuadPart;
+    double elapsed = (double)ticks / g_CounterFrequency.QuadPart;
+    g_LastFrameCounter = now;
+    
+    CubeSettings settings = { g_CubeSize, g_EnableCelebration };
+    long long steps = AdvanceCubeFrame(globalCube, g_PreviousCube, g_PhysicsClock, g_Topology, settings, elapsed);
+    g_Recorder.RecordFrame(ticks, steps, globalCube);
+    if (steps > 0) {
+        LogCubeDebug();
     }
     
-    glViewport(0, 0, mon.bounds.right - mon.bounds.left, mon.bounds.bottom - mon.bounds.top);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    float aspect = (float)(mon.bounds.right - mon.bounds.left) / (mon.bounds.bottom - mon.bounds.top);
-    gluPerspective(45.0, aspect, 0.1, 100.0);
+    Cube drawn;
+    InterpolateCube(g_PreviousCube, globalCube, FixedStepAlpha(g_PhysicsClock), drawn);
     
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    if (g_OutputThreads.Running()) {
+        SceneSnapshot& scene = g_OutputThreads.BeginScene();
+        scene.cubes.assign(1, drawn);
+        BuildCubeFrame(scene.commands, &drawn, 1, g_CubeSize, g_MirrorMode);
+        scene.commands.Bin(g_Topology);
+        g_OutputThreads.PublishScene();
+        return;
+    }
     
-    if (globalCube.active) {
-        if (g_MirrorMode) {
-            DrawCube(globalCube, mon);
+    // Monitors the cube overlaps draw it; the rest show black, and are only
+    // presented when that is not already what they show. Each monitor replays
+    // the same command list, binned so it only visits the draws reaching it.
+    BuildCubeFrame(g_Frame, &drawn, 1, g_CubeSize, g_MirrorMode);
+    g_Frame.Bin(g_Topology);
+    static std::vector<int> touched;
+    if (g_MirrorMode) {
+        touched.clear();
+        for (size_t i = 0; i < monitors.size(); i++) touched.push_back((int)i);
+    } else {
+        g_Topology.OutputsTouching(drawn.x, drawn.y, GetCubeSizeInPixels(g_CubeSize), touched);
+    }
+    g_Presents.Sync(g_Topology);
+    size_t next = 0;
+    size_t nextDue = 0;
+    for (size_t i = 0; i < monitors.size() && i < g_Topology.OutputCount(); i++) {
+        bool drawCube = next < touched.size() && touched[next] == (int)i;
+        if (drawCube) next++;
+        bool isDue = !due || (nextDue < due->size() && (*due)[nextDue] == (int)i);
+        if (isDue && due) nextDue++;
+        bool drawable = g_Impostor ? monitors[i].hdc != NULL : monitors[i].hglrc != NULL;
+        if (!drawable || !isDue) continue;
+        OutputFrame frame = DescribeOutputFrame(drawn, drawCube);
+        if (g_Presents.ShouldPresent(i, frame) && RenderScene(monitors[i], g_Topology.Output(i), g_Frame)) {
+            g_Presents.Presented(i, frame);
+        }
+    }
+}
+
+// Create a fullscreen window and GL context for each monitor, or with
+// --impostor just the window and its DC
+bool CreateMonitorWindows(HWND parent, std::wofstream& createLog) {
+    for (size_t i = 0; i < monitors.size(); i++) {
+        auto& mon = monitors[i];
+        createLog << L"Creating window for monitor " << i << L": "
+                 << L"left=" << mon.bounds.left << L" top=" << mon.bounds.top
+                 << L" width=" << (mon.bounds.right - mon.bounds.left)
+                 << L" height=" << (mon.bounds.bottom - mon.bounds.top) << std::endl;
+        
+        HWND monitorWnd = CreateWindowEx(
+            WS_EX_TOPMOST,
+            "BouncingCubeMonitor",
+            "BouncingCube",
+            WS_POPUP | WS_VISIBLE,
+            mon.bounds.left, mon.bounds.top,
+            mon.bounds.right - mon.bounds.left,
+            mon.bounds.bottom - mon.bounds.top,
+            parent, NULL, GetModuleHandle(NULL), NULL
+        );
+        
+        if (!monitorWnd) {
+            createLog << L"ERROR: Failed to create monitor window, error: " << GetLastError() << std::endl;
+            return false;
+        }
+        
+        mon.hwnd = monitorWnd;
+        createLog << L"Monitor window created successfully" << std::endl;
+        
+        if (g_Impostor) {
+            mon.hdc = GetDC(monitorWnd);
+            mon.impostor.Invalidate();
+            createLog << L"GDI sprite presents for monitor " << i << std::endl;
         } else {
-            const float CUBE_SIZE = GetCubeSizeInPixels();
-            if (globalCube.x + CUBE_SIZE >= mon.bounds.left &&
-                globalCube.x - CUBE_SIZE <= mon.bounds.right &&
-                globalCube.y + CUBE_SIZE >= mon.bounds.top &&
-                globalCube.y - CUBE_SIZE <= mon.bounds.bottom) {
-                DrawCube(globalCube, mon);
-            }
+            InitOpenGL(monitorWnd, mon);
+            createLog << L"OpenGL initialized for monitor " << i << std::endl;
         }
     }
-    
-    SwapBuffers(mon.hdc);
+    if (g_Impostor) StartSpriteAtlases();
+    return true;
+}
+
+void DestroyMonitorWindows(HWND mainWnd) {
+    StopRenderThreads();
+    for (auto& mon : monitors) {
+        if (mon.hglrc) {
+            wglMakeCurrent(NULL, NULL);
+            wglDeleteContext(mon.hglrc);
+            ReleaseDC(mon.hwnd, mon.hdc);
+        } else if (mon.hdc) {
+            ReleaseDC(mon.hwnd, mon.hdc);
+        }
+        if (mon.hwnd && mon.hwnd != mainWnd) {
+            DestroyWindow(mon.hwnd);
+        }
+    }
+    monitors.clear();
 }
 
 LRESULT CALLBACK MainWndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam) {
-    static UINT_PTR timer;
+    static HPOWERNOTIFY displayNotify = NULL;
     static std::wofstream msgLog;
     static bool logOpened = false;
     
@@ -622,7 +727,9 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPar
             std::wofstream createLog(L"WM_CREATE_log.txt", std::ios::out | std::ios::trunc);
             createLog << L"WM_CREATE started" << std::endl;
             
-            srand(static_cast<unsigned>(time(nullptr)) ^ GetCurrentProcessId());
+            if (!g_SeedFromCommandLine) {
+                g_Seed = static_cast<unsigned long long>(time(nullptr)) ^ GetCurrentProcessId();
+            }
             
             // Load settings from registry, but only if not in standalone mode
             // In standalone mode, command line arguments take precedence
@@ -643,48 +750,41 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPar
             }
             
             InitializeCube();
+            if (ResumeWorldSnapshot()) {
+                createLog << L"Resumed world snapshot" << std::endl;
+            }
+            g_PreviousCube = globalCube;
+            InitFixedStepClock(g_PhysicsClock, PHYSICS_STEPS_PER_SECOND);
+            QueryPerformanceFrequency(&g_CounterFrequency);
+            QueryPerformanceCounter(&g_LastFrameCounter);
             createLog << L"Cube initialized" << std::endl;
             
-            // Create fullscreen windows for each monitor
-            for (size_t i = 0; i < monitors.size(); i++) {
-                auto& mon = monitors[i];
-                createLog << L"Creating window for monitor " << i << L": "
-                         << L"left=" << mon.bounds.left << L" top=" << mon.bounds.top
-                         << L" width=" << (mon.bounds.right - mon.bounds.left)
-                         << L" height=" << (mon.bounds.bottom - mon.bounds.top) << std::endl;
-                
-                HWND monitorWnd = CreateWindowEx(
-                    WS_EX_TOPMOST,
-                    "BouncingCubeMonitor",
-                    "BouncingCube",
-                    WS_POPUP | WS_VISIBLE,
-                    mon.bounds.left, mon.bounds.top,
-                    mon.bounds.right - mon.bounds.left,
-                    mon.bounds.bottom - mon.bounds.top,
-                    hwnd, NULL, GetModuleHandle(NULL), NULL
-                );
-                
-                if (!monitorWnd) {
-                    createLog << L"ERROR: Failed to create monitor window, error: " << GetLastError() << std::endl;
-                    createLog.close();
-                    return -1;
-                }
-                
-                mon.hwnd = monitorWnd;
-                createLog << L"Monitor window created successfully" << std::endl;
-                
-                InitOpenGL(monitorWnd, mon);
-                createLog << L"OpenGL initialized for monitor " << i << std::endl;
+            if (!g_RecordPath.empty()) {
+                CubeSettings settings = { g_CubeSize, g_EnableCelebration };
+                g_Recorder.Begin(globalCube, settings, g_Seed, g_Topology, g_CounterFrequency.QuadPart, PHYSICS_STEPS_PER_SECOND);
+                g_Recorder.RecordTopology(g_Topology);
+                createLog << L"Recording replay" << std::endl;
             }
             
-            timer = SetTimer(hwnd, 1, 16, NULL);
-            if (!timer) {
-                createLog << L"ERROR: Failed to create timer" << std::endl;
+            if (!CreateMonitorWindows(hwnd, createLog)) {
                 createLog.close();
                 return -1;
             }
+            StartRenderThreads();
+            
+            // The scheduler drives frames, waking on a high-resolution timer
+            // (Windows 10 1803 and later) where there is one; the fixed-step
+            // clock keeps physics at the right speed whatever rate frames
+            // really come at
+            ResetFrameScheduler();
+            g_FrameTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+            if (!g_FrameTimer) {
+                g_FrameTimer = CreateWaitableTimerW(NULL, FALSE, NULL);
+            }
+            createLog << (g_FrameTimer ? L"Frame timer created" : L"No frame timer, waiting with timeouts") << std::endl;
             
-            createLog << L"Timer created successfully" << std::endl;
+            // Pause physics and rendering while the display is off
+            displayNotify = RegisterPowerSettingNotification(hwnd, &g_DisplayStateGuid, DEVICE_NOTIFY_WINDOW_HANDLE);
             
             // Record startup time to ignore initial mouse movements
             g_StartupTime = GetTickCount();
@@ -694,16 +794,6 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPar
             return 0;
         }
         
-    case WM_TIMER:
-        UpdateCube();
-        
-        for (auto& mon : monitors) {
-            if (mon.hglrc != NULL) {
-                RenderScene(mon);
-            }
-        }
-        return 0;
-        
     case WM_KEYDOWN:
     case WM_LBUTTONDOWN:
     case WM_RBUTTONDOWN:
@@ -720,18 +810,54 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lPar
         }
         return 0;
         
-    case WM_DESTROY:
-        KillTimer(hwnd, timer);
-        for (auto& mon : monitors) {
-            if (mon.hwnd && mon.hwnd != hwnd) {
-                DestroyWindow(mon.hwnd);
-            }
-            if (mon.hglrc) {
-                wglMakeCurrent(NULL, NULL);
-                wglDeleteContext(mon.hglrc);
-                ReleaseDC(mon.hwnd, mon.hdc);
+    case WM_DISPLAYCHANGE:
+        {
+            // Monitors were added, removed, moved or resized. Rebuild the windows
+            // and the topology; the cube keeps going unless its spot vanished.
+            std::wofstream displayLog(L"WM_DISPLAYCHANGE_log.txt", std::ios::out | std::ios::app);
+            DestroyMonitorWindows(hwnd);
+            EnumDisplayMonitors(NULL, NULL, MonitorEnumProc, 0);
+            displayLog << L"Display change: " << monitors.size() << L" monitors" << std::endl;
+            if (monitors.empty()) return 0;
+            
+            RebuildTopology();
+            KeepCubeOnDesktop(globalCube, g_Topology);
+            g_PreviousCube = globalCube;
+            g_Recorder.RecordTopology(g_Topology);
+            CreateMonitorWindows(hwnd, displayLog);
+            StartRenderThreads();
+            ResetFrameScheduler();
+        }
+        return 0;
+        
+    case WM_POWERBROADCAST:
+        if (wParam == PBT_POWERSETTINGCHANGE) {
+            const POWERBROADCAST_SETTING* setting = (const POWERBROADCAST_SETTING*)lParam;
+            if (IsEqualGUID(setting->PowerSetting, g_DisplayStateGuid) && setting->DataLength >= sizeof(DWORD)) {
+                DWORD displayState = *(const DWORD*)setting->Data;  // 0 = off, 1 = on, 2 = dimmed
+                if (displayState == 0 && g_DisplayOffTime == 0) {
+                    g_DisplayOffTime = GetTickCount();
+                } else if (displayState != 0 && g_DisplayOffTime != 0) {
+                    // The next AdvanceFrame sees the whole gap and catches it up,
+                    // and presents everything again in case the screens lost it
+                    g_DisplayOffTime = 0;
+                    for (size_t i = 0; i < monitors.size(); i++) InvalidateMonitor(i);
+                    g_Scheduler.Restart();
+                }
             }
         }
+        return TRUE;
+        
+    case WM_DESTROY:
+        if (g_FrameTimer) {
+            CloseHandle(g_FrameTimer);
+            g_FrameTimer = NULL;
+        }
+        if (displayNotify) {
+            UnregisterPowerSettingNotification(displayNotify);
+            displayNotify = NULL;
+        }
+        DestroyMonitorWindows(hwnd);
         PostQuitMessage(0);
         return 0;
     }
@@ -775,6 +901,13 @@ LRESULT CALLBACK MonitorWndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM l
     }
     
     switch (message) {
+    case WM_PAINT:
+        // Uncovered: the next frame presents this monitor even if it looks unchanged
+        for (size_t i = 0; i < monitors.size(); i++) {
+            if (monitors[i].hwnd == hwnd) InvalidateMonitor(i);
+        }
+        break;
+        
     case WM_KEYDOWN:
     case WM_LBUTTONDOWN:
     case WM_RBUTTONDOWN:
@@ -808,6 +941,9 @@ void ParseCommandLine(LPWSTR cmdLine) {
     // --monitors all --exitEvent <name>
     // --standalone (for debugging)
     // --mirror (enable mirror mode)
+    // --seed <n> (reproducible bounces)
+    // --singleThread (present every monitor from the UI thread instead of one render thread each)
+    // --impostor (pre-rendered sprites through GDI instead of OpenGL)
     
     std::wstring args(cmdLine);
     
@@ -852,6 +988,35 @@ void ParseCommandLine(LPWSTR cmdLine) {
         }
     }
     
+    size_t seedPos = args.find(L"--seed");
+    if (seedPos != std::wstring::npos) {
+        seedPos += 6; // length of "--seed"
+        while (seedPos < args.length() && args[seedPos] == L' ') seedPos++;
+        
+        if (seedPos < args.length()) {
+            g_Seed = wcstoull(args.c_str() + seedPos, nullptr, 10);
+            g_SeedFromCommandLine = true;
+        }
+    }
+    
+    if (args.find(L"--singleThread") != std::wstring::npos) {
+        g_RenderThreads = false;
+    }
+    
+    if (args.find(L"--impostor") != std::wstring::npos) {
+        g_Impostor = true;
+    }
+    
+    size_t recordPos = args.find(L"--record");
+    if (recordPos != std::wstring::npos) {
+        recordPos += 8; // length of "--record"
+        while (recordPos < args.length() && args[recordPos] == L' ') recordPos++;
+        
+        size_t endPos = args.find(L' ', recordPos);
+        std::wstring path = args.substr(recordPos, endPos == std::wstring::npos ? std::wstring::npos : endPos - recordPos);
+        g_RecordPath.assign(path.begin(), path.end());
+    }
+    
     size_t exitEventPos = args.find(L"--exitEvent");
     if (exitEventPos != std::wstring::npos) {
         exitEventPos += 11; // length of "--exitEvent"
@@ -940,24 +1105,33 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
     logFile.close(); // Close the file so it gets flushed
     
     MSG msg;
-    BOOL bRet;
+    BOOL bRet = TRUE;
     int messageCount = 0;
     DWORD lastEventCheck = GetTickCount();
     
-    while ((bRet = GetMessage(&msg, NULL, 0, 0)) != 0) {
-        if (bRet == -1) {
-            // Error in GetMessage
-            logFile.open(L"BouncingCubeApp_log.txt", std::ios::out | std::ios::app);
-            logFile << L"GetMessage error: " << GetLastError() << std::endl;
-            logFile.close();
-            break;
+    while (true) {
+        if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                bRet = FALSE;
+                break;
+            }
+            
+            messageCount++;
+            
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        } else if (g_DisplayOffTime == 0 && g_Scheduler.OutputCount() > 0) {
+            // Queue is empty: sleep until a monitor's next frame is due
+            if (WaitForNextFrame()) {
+                static std::vector<int> due;
+                g_Scheduler.Collect(g_SchedulerClock.Now(), due);
+                LogMissedFrames();
+                if (!due.empty()) AdvanceFrame(&due);
+            }
+        } else {
+            WaitMessage();
         }
         
-        messageCount++;
-        
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
-        
         // Check exit event if provided - but only every 10ms to avoid tight polling
         DWORD currentTime = GetTickCount();
         if (g_ExitEvent && (currentTime - lastEventCheck) >= 10) {
@@ -973,6 +1147,11 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
         }
     }
     
+    SaveWorldSnapshot();
+    if (g_Recorder.Recording()) {
+        g_Recorder.WriteFile(g_RecordPath.c_str());
+    }
+    
     logFile.open(L"BouncingCubeApp_log.txt", std::ios::out | std::ios::app);
     logFile << L"Message loop exited, bRet = " << bRet << std::endl;
     logFile.close();
@@ -0,0 +1,2359 @@
+// Headless benchmark host for the cube simulation core. Builds on any
+// platform with no window system so physics can be profiled on Linux.
+//
+// Usage: BouncingCubeBench [mode] [--steps N] [--width W] [--height H] [--size S]
+//                          [--max-cubes N] [--seed N] [--threads N] [--file PATH]
+// Modes:
+//   step   single-cube StepCube throughput (default)
+//   soa    CubeSoA scaling from 1 to --max-cubes cubes, scalar vs SIMD kernel,
+//          and a cube-for-cube comparison against StepCube
+//   toi    event-driven AdvanceCube: agreement with fixed-step StepCube and
+//          time to fast-forward hours of simulation
+//   orient quaternion orientation vs the old per-frame 4x4 matrix product:
+//          cost per step and drift over --steps frames
+//   corner corner-hit oracle: FramesUntilCornerHit checked against brute-force
+//          stepping, and corner rates for a few sizes and aspects
+//   clock  fixed-timestep clock and render interpolation under several
+//          presentation rates, against the old one-step-per-tick loop
+//   parallel  work-stealing CubeParallelUpdater: bit-identical to UpdateCubeSoA
+//          for every thread count, and strong scaling from 1 to --threads
+//   desktop   union-of-monitors physics: bit-identical to StepCube on one
+//          monitor, no escapes at 50x speed on uneven layouts, AdvanceCubeDesktop
+//          against stepping, and cost per step
+//   topology  DisplayTopology lookups checked against a linear scan of the
+//          monitors on synthetic layouts, and their cost per query
+//   snapshot  binary world snapshots: save and mmap-load --max-cubes cubes,
+//          round trip and resume checked bit for bit, damaged files rejected
+//   replay    deterministic replay: record a synthetic session, play it back
+//          with every hash checked, catch a tampered frame, and measure the
+//          recording overhead per frame; --file plays an app --record log
+//   raster    software rasterizer: coverage and lighting checked against the
+//          geometry, frames/sec at 1080p, 4K and 8K with one cube and with
+//          1000, and a PPM of a 1080p frame (to --file if given)
+//   tiles     tile-binned multithreaded rendering of 1, 4 and 16 4K outputs:
+//          bit-identical to drawing each output whole, and frame time from 1
+//          to --threads threads against the serial per-output loop
+//   dirty     dirty-tile rendering of moving cubes against full redraws:
+//          pixels touched and CPU time per frame, same pixels on screen
+//   mirror    mirror-mode sharing: 2, 4 and 8 mirrored outputs drawn once per
+//          resolution, each checked against drawing it alone, frame time
+//          against drawing every output
+//   skip      per-output frame skipping on a 3x2 wall: presented and skipped
+//          frames per output, every skip checked against a fresh render
+//   threads   one render thread per output fed lock-free snapshots: no torn or
+//          reused scenes, final frame identical to a serial render, start/stop
+//   exchange  SceneExchange alone: wait-free publish and acquire cost against a
+//          mutex, publish-to-acquire latency with 1-8 polling readers
+//   schedule  per-output frame deadlines on a simulated clock: frames served
+//          and missed at 60-240 Hz, with a stall, against the old SetTimer loop
+//   commands  per-frame render command lists: replayed through the software
+//          backend bit-identical to drawing directly, and the cost of building
+//          and replaying them, measured on the recording backend
+//   binning   command lists binned per output through the topology grid against
+//          testing every draw on every output, 1 to 1000 outputs: same
+//          replays, and frame cost as outputs grow
+//   impostor  orientation sprite atlases: build, cache file round trip with
+//          damaged files refused, background loading, error against exact
+//          rendering, and frame cost against rasterizing
+//   gl        the app's GL paths on a headless EGL context: retained vertex
+//          buffers pixel-identical to immediate mode and close to the software
+//          rasterizer, and submit and frame time for 1 to 10000 cubes
+
+#include "CubeClock.h"
+#include "CubeCore.h"
+#include "CubeDesktop.h"
+#include "CubeEvents.h"
+#include "CubeImpostor.h"
+#include "CubeParallel.h"
+#include "CubePresent.h"
+#include "CubeRaster.h"
+#include "CubeRenderBackend.h"
+#include "CubeRenderThreads.h"
+#include "CubeReplay.h"
+#include "CubeScheduler.h"
+#include "CubeSnapshot.h"
+#include "CubeSoA.h"
+#include "CubeTiles.h"
+#include "CubeTopology.h"
+#if defined(CUBE_HEADLESS_GL)
+#include "CubeHeadlessGL.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BenchOptions {
+    std::string mode = "step";
+    long long steps = 10000000;
+    int width = 1920;
+    int height = 1080;
+    float cubeSize = 0.1f;
+    size_t maxCubes = 1000000;
+    unsigned long long seed = 12345;
+    int threads = 0;  // 0 = std::thread::hardware_concurrency()
+    std::string file;  // replay: a recording to play instead of a synthetic one
+};
+
+static void ParseBenchArgs(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (i == 1 && argv[i][0] != '-') {
+            opts.mode = argv[i];
+        } else if (!strcmp(argv[i], "--steps") && hasValue) {
+            opts.steps = atoll(argv[++i]);
+        } else if (!strcmp(argv[i], "--width") && hasValue) {
+            opts.width = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--height") && hasValue) {
+            opts.height = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--size") && hasValue) {
+            opts.cubeSize = (float)atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--max-cubes") && hasValue) {
+            opts.maxCubes = (size_t)atoll(argv[++i]);
+        } else if (!strcmp(argv[i], "--seed") && hasValue) {
+            opts.seed = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--threads") && hasValue) {
+            opts.threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--file") && hasValue) {
+            opts.file = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown or incomplete argument: %s\n", argv[i]);
+        }
+    }
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int RunStepBenchmark(const BenchOptions& opts) {
+    WorldBounds bounds = { 0, 0, opts.width, opts.height };
+    CubeSettings settings = { opts.cubeSize, true };
+
+    Cube cube;
+    ResetCube(cube, opts.width / 2.0f, opts.height / 2.0f, opts.seed, 0);
+
+    long long corners = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < opts.steps; i++) {
+        if (StepCube(cube, bounds, settings)) corners++;
+    }
+    double seconds = SecondsSince(start);
+
+    printf("single-cube steps: %lld in %.3f s\n", opts.steps, seconds);
+    printf("steps/sec: %.0f (%.2f ns/step)\n", opts.steps / seconds, seconds * 1e9 / opts.steps);
+    printf("corner hits: %lld, final pos: (%.2f, %.2f)\n", corners, cube.x, cube.y);
+    return 0;
+}
+
+// Spread cubes over the whole bounds instead of stacking them on the center
+static void SeedCubeSoA(CubeSoA& cubes, size_t count, const BenchOptions& opts) {
+    cubes.Resize(count);
+    float margin = GetCubeSizeInPixels(opts.cubeSize) + 1.0f;
+    for (size_t i = 0; i < count; i++) {
+        Cube cube;
+        float cx = margin + (opts.width - 2 * margin) * ((i * 7919) % 1000) / 1000.0f;
+        float cy = margin + (opts.height - 2 * margin) * ((i * 104729) % 1000) / 1000.0f;
+        ResetCube(cube, cx, cy, opts.seed, (unsigned int)i);
+        cubes.SetCube(i, cube);
+    }
+}
+
+// Largest component-wise difference between the rotation matrices of two cubes
+static double OrientationError(const Cube& a, const Cube& b) {
+    float ma[16], mb[16];
+    GetCubeRotationMatrix(a, ma);
+    GetCubeRotationMatrix(b, mb);
+    double error = 0;
+    for (int k = 0; k < 16; k++) error = fmax(error, fabs((double)ma[k] - mb[k]));
+    return error;
+}
+
+// Step N cubes through UpdateCubeSoA and through StepCube and require identical
+// positions and velocities. The reference runs cube by cube instead of frame by
+// frame, which only agrees because every cube has its own random stream.
+// Orientations only need to agree to rounding, the vectorized product may be
+// evaluated in a different order.
+static bool VerifyCubeSoA(const BenchOptions& opts, size_t count, int frames) {
+    WorldBounds bounds = { 0, 0, opts.width, opts.height };
+    CubeSettings settings = { opts.cubeSize, true };
+
+    CubeSoA cubes;
+    SeedCubeSoA(cubes, count, opts);
+    std::vector<Cube> reference(count);
+    for (size_t i = 0; i < count; i++) cubes.GetCube(i, reference[i]);
+
+    std::vector<CubeBounce> bounces;
+    for (int f = 0; f < frames; f++) UpdateCubeSoA(cubes, bounds, settings, bounces);
+    for (size_t i = 0; i < count; i++) {
+        for (int f = 0; f < frames; f++) StepCube(reference[i], bounds, settings);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        Cube c;
+        cubes.GetCube(i, c);
+        const Cube& r = reference[i];
+        if (c.x != r.x || c.y != r.y || c.vx != r.vx || c.vy != r.vy ||
+            c.rotationAxisX != r.rotationAxisX || c.rotationSpeed != r.rotationSpeed ||
+            c.celebratingCorner != r.celebratingCorner || OrientationError(c, r) > 1e-5) {
+            printf("MISMATCH cube %zu: soa (%.6f, %.6f) v(%.6f, %.6f), StepCube (%.6f, %.6f) v(%.6f, %.6f)\n",
+                   i, c.x, c.y, c.vx, c.vy, r.x, r.y, r.vx, r.vy);
+            return false;
+        }
+    }
+    return true;
+}
+
+static int RunSoABenchmark(const BenchOptions& opts) {
+    WorldBounds bounds = { 0, 0, opts.width, opts.height };
+    CubeSettings settings = { opts.cubeSize, true };
+    float cubePixels = GetCubeSizeInPixels(opts.cubeSize);
+
+    bool verified = VerifyCubeSoA(opts, 1003, 5000);
+    printf("SoA vs StepCube (1003 cubes, 5000 frames): %s\n", verified ? "identical" : "DIFFERENT");
+
+    printf("kernel: %s\n", CubeSoAKernelName());
+    printf("%10s %16s %16s %16s\n", "cubes", "scalar cubes/s", "simd cubes/s", "full cubes/s");
+
+    // Each row runs roughly the same number of cube updates
+    long long budget = opts.steps > 0 ? opts.steps : 10000000;
+    std::vector<CubeBounce> bounces;
+    for (size_t count = 1; count <= opts.maxCubes; count *= 10) {
+        long long frames = budget / (long long)count;
+        if (frames < 20) frames = 20;
+
+        CubeSoA cubes;
+        double rates[3];
+        for (int pass = 0; pass < 3; pass++) {
+            SeedCubeSoA(cubes, count, opts);
+            bounces.reserve(count);
+            auto start = std::chrono::steady_clock::now();
+            for (long long f = 0; f < frames; f++) {
+                bounces.clear();
+                if (pass == 0) IntegrateCubeSoAScalar(cubes, bounds, cubePixels, bounces);
+                else if (pass == 1) IntegrateCubeSoA(cubes, bounds, cubePixels, bounces);
+                else UpdateCubeSoA(cubes, bounds, settings, bounces);
+            }
+            rates[pass] = (double)frames * count / SecondsSince(start);
+        }
+        printf("%10zu %16.0f %16.0f %16.0f\n", count, rates[0], rates[1], rates[2]);
+    }
+    return verified ? 0 : 1;
+}
+
+// Largest component-wise difference between two cube states
+static void CompareCubes(const Cube& a, const Cube& b, double& posError, double& matrixError) {
+    posError = fmax(fabs((double)a.x - b.x), fabs((double)a.y - b.y));
+    matrixError = OrientationError(a, b);
+}
+
+static int RunToiBenchmark(const BenchOptions& opts) {
+    WorldBounds bounds = { 0, 0, opts.width, opts.height };
+    CubeSettings settings = { opts.cubeSize, true };
+    const double POSITION_TOLERANCE = 0.5;  // pixels
+    const double MATRIX_TOLERANCE = 1e-2;
+    const long long FRAMES = 200000;
+
+    // Fixed-step and event-driven runs from the same state and random stream. The
+    // event-driven run advances in uneven chunks to exercise partial coasts.
+    double worstPos = 0, worstMatrix = 0;
+    int failures = 0;
+    const int RUNS = 50;
+    for (int run = 0; run < RUNS; run++) {
+        Cube start;
+        ResetCube(start, opts.width / 2.0f, opts.height / 2.0f, opts.seed, (unsigned int)run);
+
+        Cube stepped = start;
+        for (long long f = 0; f < FRAMES; f++) StepCube(stepped, bounds, settings);
+
+        Cube advanced = start;
+        long long remaining = FRAMES;
+        long long chunk = 1;
+        while (remaining > 0) {
+            long long n = chunk < remaining ? chunk : remaining;
+            AdvanceCube(advanced, bounds, settings, n);
+            remaining -= n;
+            chunk = chunk * 3 + 7;
+        }
+
+        double posError, matrixError;
+        CompareCubes(stepped, advanced, posError, matrixError);
+        worstPos = fmax(worstPos, posError);
+        worstMatrix = fmax(worstMatrix, matrixError);
+        if (posError > POSITION_TOLERANCE || matrixError > MATRIX_TOLERANCE) failures++;
+    }
+    printf("AdvanceCube vs StepCube (%d runs x %lld frames): max position error %.4f px, max matrix error %.6f, %d over tolerance\n",
+           RUNS, FRAMES, worstPos, worstMatrix, failures);
+
+    // Fast-forward cost for typical suspend lengths at 60 frames per second
+    const long long FRAMES_PER_HOUR = 60LL * 60 * 60;
+    const int hours[] = { 1, 8, 24 * 7 };
+    for (int h = 0; h < 3; h++) {
+        Cube cube;
+        ResetCube(cube, opts.width / 2.0f, opts.height / 2.0f, opts.seed, 0);
+        auto begin = std::chrono::steady_clock::now();
+        long long corners = AdvanceCube(cube, bounds, settings, hours[h] * FRAMES_PER_HOUR);
+        double seconds = SecondsSince(begin);
+        printf("advance %4d h (%lld frames): %.1f us, %lld corner hits\n",
+               hours[h], hours[h] * FRAMES_PER_HOUR, seconds * 1e6, corners);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
+
+// Largest |M * M^T - I| entry, how far a rotation matrix has drifted from orthonormal
+static double OrthonormalityError(const float m[16]) {
+    double error = 0;
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            double dot = 0;
+            for (int k = 0; k < 3; k++) dot += (double)m[r * 4 + k] * m[c * 4 + k];
+            error = fmax(error, fabs(dot - (r == c ? 1.0 : 0.0)));
+        }
+    }
+    return error;
+}
+
+// The orientation update as it was before quaternions: build a rotation matrix
+// every frame and multiply it into the accumulated one, never reorthonormalized
+static void RotateMatrix(float matrix[16], const Cube& cube) {
+    float rotMatrix[16];
+    CreateRotationMatrix(rotMatrix, cube.rotationSpeed, cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ);
+    float newMatrix[16];
+    MultiplyMatrix4x4(newMatrix, rotMatrix, matrix);
+    for (int i = 0; i < 16; i++) matrix[i] = newMatrix[i];
+}
+
+static int RunOrientBenchmark(const BenchOptions& opts) {
+    // Both paths spin the same cube about the same axis; the bounces that would
+    // change the axis are left out so only the orientation update is measured.
+    Cube cube;
+    ResetCube(cube, opts.width / 2.0f, opts.height / 2.0f, opts.seed, 0);
+    float matrix[16];
+    QuaternionToMatrix(matrix, cube.orientation);
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < opts.steps; i++) RotateMatrix(matrix, cube);
+    double matrixSeconds = SecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < opts.steps; i++) RotateCube(cube);
+    double quaternionSeconds = SecondsSince(start);
+
+    float expanded[16];
+    GetCubeRotationMatrix(cube, expanded);
+    double norm = sqrt((double)cube.orientation[0] * cube.orientation[0] + (double)cube.orientation[1] * cube.orientation[1] +
+                       (double)cube.orientation[2] * cube.orientation[2] + (double)cube.orientation[3] * cube.orientation[3]);
+    double matrixDrift = OrthonormalityError(matrix);
+    double quaternionDrift = OrthonormalityError(expanded);
+
+    printf("orientation steps: %lld\n", opts.steps);
+    printf("%-12s %12s %18s\n", "path", "ns/step", "|M*M^T - I| max");
+    printf("%-12s %12.2f %18.3g\n", "matrix", matrixSeconds * 1e9 / opts.steps, matrixDrift);
+    printf("%-12s %12.2f %18.3g\n", "quaternion", quaternionSeconds * 1e9 / opts.steps, quaternionDrift);
+    printf("quaternion norm after %lld steps: %.9f\n", opts.steps, norm);
+
+    // Renormalizing every ORIENTATION_NORMALIZE_INTERVAL frames keeps the error at
+    // a few float ulps no matter how long the saver runs
+    return quaternionDrift < 1e-5 ? 0 : 1;
+}
+
+static int RunCornerBenchmark(const BenchOptions& opts) {
+    WorldBounds bounds = { 0, 0, opts.width, opts.height };
+    CubeSettings settings = { opts.cubeSize, true };
+    const long long FRAMES = 300000;
+    const int RUNS = 40;
+
+    // Record every corner frame by brute force, then hop from corner to corner
+    // with the oracle and require the same frames.
+    long long corners = 0, mismatches = 0;
+    double bruteSeconds = 0, oracleSeconds = 0;
+    for (int run = 0; run < RUNS; run++) {
+        Cube start;
+        ResetCube(start, opts.width / 2.0f, opts.height / 2.0f, opts.seed, (unsigned int)run);
+
+        std::vector<long long> expected;
+        Cube stepped = start;
+        auto begin = std::chrono::steady_clock::now();
+        for (long long f = 1; f <= FRAMES; f++) {
+            if (StepCube(stepped, bounds, settings)) expected.push_back(f);
+        }
+        bruteSeconds += SecondsSince(begin);
+
+        std::vector<long long> predicted;
+        Cube cube = start;
+        long long elapsed = 0;
+        begin = std::chrono::steady_clock::now();
+        while (true) {
+            long long next = FramesUntilCornerHit(cube, bounds, settings, FRAMES - elapsed);
+            if (next < 0) break;
+            AdvanceCube(cube, bounds, settings, next);
+            elapsed += next;
+            predicted.push_back(elapsed);
+        }
+        oracleSeconds += SecondsSince(begin);
+
+        corners += (long long)expected.size();
+        if (predicted != expected) {
+            mismatches++;
+            printf("MISMATCH run %d: %zu corners stepped, %zu predicted\n", run, expected.size(), predicted.size());
+        }
+    }
+    printf("FramesUntilCornerHit vs StepCube (%d runs x %lld frames): %lld corners, %lld runs differ\n",
+           RUNS, FRAMES, corners, mismatches);
+    if (corners > 0) {
+        printf("time per corner: brute force %.1f us, oracle %.1f us\n",
+               bruteSeconds * 1e6 / corners, oracleSeconds * 1e6 / corners);
+    }
+
+    // How often corners happen for a few sizes and aspects, from 64 cubes x 4
+    // simulated hours each
+    struct Layout { int width, height; float cubeSize; };
+    const Layout layouts[] = {
+        { 1920, 1080, 0.05f }, { 1920, 1080, 0.1f }, { 1920, 1080, 0.2f },
+        { 1080, 1920, 0.1f }, { 3840, 1080, 0.1f }, { 1024, 1024, 0.1f },
+    };
+    const long long FRAMES_PER_HOUR = 60LL * 60 * 60;
+    printf("%12s %6s %14s %10s\n", "bounds", "size", "corners/hour", "ms");
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        WorldBounds layoutBounds = { 0, 0, layouts[l].width, layouts[l].height };
+        CubeSettings layoutSettings = { layouts[l].cubeSize, true };
+        auto begin = std::chrono::steady_clock::now();
+        double rate = EstimateCornerHitRate(layoutBounds, layoutSettings, opts.seed, 64, 4 * FRAMES_PER_HOUR);
+        double seconds = SecondsSince(begin);
+
+        char label[32];
+        snprintf(label, sizeof(label), "%dx%d", layouts[l].width, layouts[l].height);
+        printf("%12s %6.2f %14.2f %10.1f\n", label, layouts[l].cubeSize, rate * FRAMES_PER_HOUR, seconds * 1e3);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Presentation intervals of one simulated display, in seconds
+struct PresentProfile {
+    const char* name;
+    double interval;
+    double alternate;  // Every other interval, for timers that slip a tick
+};
+
+static int RunClockBenchmark(const BenchOptions& opts) {
+    // Bounds far away so the cube flies straight and the ideal path is a line
+    WorldBounds bounds = { -1000000, -1000000, 1000000, 1000000 };
+    CubeSettings settings = { opts.cubeSize, false };
+    const double SECONDS = 10.0;
+    const double STEP = 1.0 / PHYSICS_STEPS_PER_SECOND;
+
+    const PresentProfile profiles[] = {
+        { "timer 15.6ms", 0.015625, 0.015625 },
+        { "timer 15.6/31.2ms", 0.015625, 0.03125 },
+        { "vsync 60Hz", 1.0 / 60, 1.0 / 60 },
+        { "vsync 144Hz", 1.0 / 144, 1.0 / 144 },
+        { "vsync 240Hz", 1.0 / 240, 1.0 / 240 },
+    };
+
+    // speed: distance covered over the distance 60 steps/s should cover.
+    // stutter: worst gap between a frame's on-screen motion and velocity * dt.
+    int failures = 0;
+    printf("%-18s %8s %12s %12s %12s %12s\n", "presentation", "frames", "old speed", "old stutter", "new speed", "new stutter");
+    for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        Cube start;
+        ResetCube(start, 0.0f, 0.0f, opts.seed, 0);
+        double speed = sqrt((double)start.vx * start.vx + (double)start.vy * start.vy) * PHYSICS_STEPS_PER_SECOND;
+
+        // Old loop: one StepCube per presented frame
+        Cube old = start;
+        double oldStutter = 0;
+        double t = 0;
+        long long frames = 0;
+        while (t < SECONDS) {
+            double dt = (frames % 2) ? profiles[p].alternate : profiles[p].interval;
+            float px = old.x, py = old.y;
+            StepCube(old, bounds, settings);
+            double moved = sqrt(((double)old.x - px) * (old.x - px) + ((double)old.y - py) * (old.y - py));
+            oldStutter = fmax(oldStutter, fabs(moved - speed * dt));
+            t += dt;
+            frames++;
+        }
+        double oldDistance = sqrt((double)old.x * old.x + (double)old.y * old.y);
+
+        // New loop: accumulator + interpolation, drawn one step behind real time
+        FixedStepClock clock;
+        InitFixedStepClock(clock, PHYSICS_STEPS_PER_SECOND);
+        Cube current = start, previous = start, drawn = start;
+        double newStutter = 0;
+        long long steps = 0;
+        t = 0;
+        for (long long f = 0; f < frames; f++) {
+            double dt = (f % 2) ? profiles[p].alternate : profiles[p].interval;
+            t += dt;
+            long long due = TickFixedStep(clock, dt);
+            for (long long i = 0; i < due; i++) {
+                previous = current;
+                StepCube(current, bounds, settings);
+            }
+            steps += due;
+
+            // Until one whole step has elapsed there is nothing to interpolate from
+            float px = drawn.x, py = drawn.y;
+            InterpolateCube(previous, current, FixedStepAlpha(clock), drawn);
+            if (t - dt >= STEP) {
+                double moved = sqrt(((double)drawn.x - px) * (drawn.x - px) + ((double)drawn.y - py) * (drawn.y - py));
+                newStutter = fmax(newStutter, fabs(moved - speed * dt));
+            }
+        }
+        long long expectedSteps = (long long)floor(t / STEP + 1e-9);
+        double newDistance = sqrt((double)drawn.x * drawn.x + (double)drawn.y * drawn.y);
+        double ideal = speed * (t - STEP);
+
+        printf("%-18s %8lld %12.4f %10.3f px %12.4f %10.3f px\n", profiles[p].name, frames,
+               oldDistance / (speed * t), oldStutter, newDistance / ideal, newStutter);
+        if (llabs(steps - expectedSteps) > 1 || fabs(newDistance / ideal - 1.0) > 1e-3 || newStutter > 0.05) {
+            printf("  FAIL: %lld steps for %.4f s (expected %lld)\n", steps, t, expectedSteps);
+            failures++;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
+
+// Bitwise comparison of every simulated field of two stores
+static bool SameCubeSoA(const CubeSoA& a, const CubeSoA& b) {
+    size_t n = a.Size();
+    if (b.Size() != n) return false;
+    const float* fa[] = { a.x, a.y, a.vx, a.vy, a.axisX, a.axisY, a.axisZ, a.rotationSpeed,
+                          a.orientationW, a.orientationX, a.orientationY, a.orientationZ, a.spinW, a.spinX, a.spinY, a.spinZ };
+    const float* fb[] = { b.x, b.y, b.vx, b.vy, b.axisX, b.axisY, b.axisZ, b.rotationSpeed,
+                          b.orientationW, b.orientationX, b.orientationY, b.orientationZ, b.spinW, b.spinX, b.spinY, b.spinZ };
+    for (size_t f = 0; f < sizeof(fa) / sizeof(fa[0]); f++) {
+        if (memcmp(fa[f], fb[f], n * sizeof(float)) != 0) return false;
+    }
+    return memcmp(a.celebrationTimer, b.celebrationTimer, n * sizeof(int)) == 0 &&
+           memcmp(a.randomEvents, b.randomEvents, n * sizeof(unsigned long long)) == 0;
+}
+
+static int RunParallelBenchmark(const BenchOptions& opts) {
+    WorldBounds bounds = { 0, 0, opts.width, opts.height };
+    CubeSettings settings = { opts.cubeSize, true };
+    int maxThreads = opts.threads > 0 ? opts.threads : (int)std::thread::hardware_concurrency();
+    if (maxThreads < 1) maxThreads = 1;
+    printf("threads: 1..%d (hardware reports %u)\n", maxThreads, std::thread::hardware_concurrency());
+
+    // Determinism: a few hundred frames of an odd-sized population, serial vs
+    // every thread count, compared bit for bit including the bounce lists. Small
+    // chunks so even this population is spread over many chunks and steals.
+    const size_t VERIFY_CUBES = 50003;
+    const int VERIFY_FRAMES = 300;
+    CubeSoA reference;
+    SeedCubeSoA(reference, VERIFY_CUBES, opts);
+    std::vector<std::vector<CubeBounce> > referenceBounces(VERIFY_FRAMES);
+    std::vector<size_t> referenceCorners(VERIFY_FRAMES);
+    for (int f = 0; f < VERIFY_FRAMES; f++) {
+        referenceCorners[f] = UpdateCubeSoA(reference, bounds, settings, referenceBounces[f]);
+    }
+
+    bool identical = true;
+    int verifyThreads = maxThreads > 4 ? maxThreads : 4;  // Oversubscribe small machines to exercise stealing
+    for (int threads = 1; threads <= verifyThreads; threads++) {
+        CubeWorkerPool pool(threads);
+        CubeParallelUpdater updater(pool, 512);
+        CubeSoA cubes;
+        SeedCubeSoA(cubes, VERIFY_CUBES, opts);
+        std::vector<CubeBounce> bounces;
+        bool same = true;
+        for (int f = 0; f < VERIFY_FRAMES && same; f++) {
+            size_t corners = updater.Update(cubes, bounds, settings, bounces);
+            same = corners == referenceCorners[f] && bounces.size() == referenceBounces[f].size() &&
+                   (bounces.empty() || memcmp(&bounces[0], &referenceBounces[f][0], bounces.size() * sizeof(CubeBounce)) == 0);
+        }
+        same = same && SameCubeSoA(cubes, reference);
+        if (!same) {
+            printf("MISMATCH with %d threads\n", threads);
+            identical = false;
+        }
+    }
+    printf("CubeParallelUpdater vs UpdateCubeSoA (%zu cubes, %d frames, 1..%d threads): %s\n",
+           VERIFY_CUBES, VERIFY_FRAMES, verifyThreads, identical ? "identical" : "DIFFERENT");
+
+    // Strong scaling: a fixed population, more threads
+    size_t count = opts.maxCubes;
+    long long budget = opts.steps > 0 ? opts.steps : 10000000;
+    long long frames = budget / (long long)count;
+    if (frames < 20) frames = 20;
+    printf("strong scaling, %zu cubes x %lld frames\n", count, frames);
+    printf("%8s %14s %9s %12s %12s %12s\n", "threads", "cubes/s", "speedup", "integrate ms", "bounce ms", "countdown ms");
+    double baseline = 0;
+    for (int threads = 1; threads <= maxThreads; threads++) {
+        CubeWorkerPool pool(threads);
+        CubeParallelUpdater updater(pool);
+        CubeSoA cubes;
+        SeedCubeSoA(cubes, count, opts);
+        std::vector<CubeBounce> bounces;
+        auto start = std::chrono::steady_clock::now();
+        for (long long f = 0; f < frames; f++) updater.Update(cubes, bounds, settings, bounces);
+        double rate = (double)frames * count / SecondsSince(start);
+        if (threads == 1) baseline = rate;
+
+        const CubePhaseTimes& t = updater.phaseTimes;
+        printf("%8d %14.0f %8.2fx %12.3f %12.3f %12.3f\n", threads, rate, rate / baseline,
+               t.integrate * 1e3 / frames, t.bounce * 1e3 / frames, t.countdown * 1e3 / frames);
+    }
+
+    return identical ? 0 : 1;
+}
+
+static bool SameCube(const Cube& a, const Cube& b) {
+    return a.x == b.x && a.y == b.y && a.vx == b.vx && a.vy == b.vy &&
+           memcmp(a.orientation, b.orientation, sizeof(a.orientation)) == 0 &&
+           a.randomEvents == b.randomEvents && a.celebrationTimer == b.celebrationTimer;
+}
+
+static int RunDesktopBenchmark(const BenchOptions& opts) {
+    CubeSettings settings = { opts.cubeSize, true };
+    const float CUBE_SIZE = GetCubeSizeInPixels(opts.cubeSize);
+    const long long FRAMES = 100000;
+    const int RUNS = 20;
+    bool ok = true;
+
+    // One monitor: every test and clamp must match StepCube exactly
+    WorldBounds bounds = { 0, 0, opts.width, opts.height };
+    DesktopShape single;
+    single.Build(std::vector<WorldBounds>(1, bounds), CUBE_SIZE);
+    int diverged = 0;
+    for (int run = 0; run < RUNS; run++) {
+        Cube a, b;
+        ResetCube(a, opts.width / 2.0f, opts.height / 2.0f, opts.seed, (unsigned int)run);
+        b = a;
+        for (long long f = 0; f < FRAMES; f++) {
+            bool cornerA = StepCube(a, bounds, settings);
+            bool cornerB = StepCubeDesktop(b, single, settings);
+            if (cornerA != cornerB || !SameCube(a, b)) {
+                printf("MISMATCH run %d at frame %lld\n", run, f);
+                diverged++;
+                break;
+            }
+        }
+    }
+    printf("StepCubeDesktop vs StepCube on one monitor (%d runs x %lld frames): %d runs differ\n", RUNS, FRAMES, diverged);
+    ok = ok && diverged == 0;
+
+    // Uneven layouts, the cases a bounding box gets wrong
+    struct Layout { const char* name; int count; WorldBounds monitors[3]; };
+    const Layout layouts[] = {
+        { "mismatched", 2, { { 0, 0, 1920, 1080 }, { 1920, -200, 4480, 1240 } } },
+        { "L-shape", 3, { { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 }, { 0, 1080, 1920, 2160 } } },
+        { "offset stack", 2, { { 0, 0, 1920, 1080 }, { 700, 1080, 2620, 2160 } } },
+        { "portrait", 3, { { 0, 300, 1920, 1380 }, { 1920, 0, 3000, 1920 }, { 3000, 300, 4920, 1380 } } },
+    };
+    printf("%14s %6s %12s %12s %12s %10s %10s\n", "layout", "edges", "escapes", "bbox escapes", "advance err", "ns/step", "corners/h");
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        std::vector<WorldBounds> monitors(layouts[l].monitors, layouts[l].monitors + layouts[l].count);
+        DesktopShape shape;
+        shape.Build(monitors, CUBE_SIZE);
+        const WorldBounds& box = shape.BoundingBox();
+
+        // Fifty times the normal speed crosses a notch in a frame or two, which
+        // a per-frame overlap test would tunnel through
+        long long escapes = 0, boxEscapes = 0;
+        for (int run = 0; run < RUNS; run++) {
+            Cube fast, boxed;
+            float x, y;
+            shape.FindStart(monitors[run % monitors.size()], x, y);
+            ResetCube(fast, x, y, opts.seed, (unsigned int)run);
+            fast.vx *= 50;
+            fast.vy *= 50;
+            boxed = fast;
+            for (long long f = 0; f < FRAMES / 10; f++) {
+                StepCubeDesktop(fast, shape, settings);
+                if (!shape.Contains(fast.x, fast.y)) escapes++;
+                StepCube(boxed, box, settings);
+                if (!shape.Contains(boxed.x, boxed.y)) boxEscapes++;
+            }
+        }
+
+        // Event-driven fast-forward against stepping at normal speed
+        double worstError = 0;
+        long long corners = 0;
+        double stepSeconds = 0;
+        for (int run = 0; run < RUNS; run++) {
+            Cube stepped;
+            float x, y;
+            shape.FindStart(monitors[run % monitors.size()], x, y);
+            ResetCube(stepped, x, y, opts.seed, (unsigned int)run);
+            Cube advanced = stepped;
+
+            auto begin = std::chrono::steady_clock::now();
+            for (long long f = 0; f < FRAMES; f++) {
+                if (StepCubeDesktop(stepped, shape, settings)) corners++;
+            }
+            stepSeconds += SecondsSince(begin);
+
+            long long remaining = FRAMES;
+            long long chunk = 1;
+            while (remaining > 0) {
+                long long n = chunk < remaining ? chunk : remaining;
+                AdvanceCubeDesktop(advanced, shape, settings, n);
+                remaining -= n;
+                chunk = chunk * 3 + 7;
+            }
+            double posError, matrixError;
+            CompareCubes(stepped, advanced, posError, matrixError);
+            worstError = fmax(worstError, posError);
+        }
+
+        const long long FRAMES_PER_HOUR = 60LL * 60 * 60;
+        printf("%14s %6zu %12lld %12lld %12.4f %10.2f %10.2f\n", layouts[l].name, shape.EdgeCount(), escapes, boxEscapes,
+               worstError, stepSeconds * 1e9 / ((double)RUNS * FRAMES), (double)corners * FRAMES_PER_HOUR / ((double)RUNS * FRAMES));
+        ok = ok && escapes == 0 && worstError <= 0.5;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// The per-monitor test RenderScene used before DisplayTopology
+static bool SquareTouches(const WorldBounds& b, float x, float y, float size) {
+    return x + size >= b.left && x - size <= b.right && y + size >= b.top && y - size <= b.bottom;
+}
+
+static int RunTopologyBenchmark(const BenchOptions& opts) {
+    const float CUBE_SIZE = GetCubeSizeInPixels(opts.cubeSize);
+    const int QUERIES = 200000;
+
+    // A row of 16 monitors stands in for a video wall
+    std::vector<WorldBounds> wall;
+    for (int i = 0; i < 16; i++) {
+        WorldBounds b = { (i % 8) * 1920, (i / 8) * 1080, (i % 8 + 1) * 1920, (i / 8 + 1) * 1080 };
+        wall.push_back(b);
+    }
+    struct Layout { const char* name; std::vector<WorldBounds> monitors; };
+    std::vector<Layout> layouts;
+    layouts.push_back(Layout{ "single", std::vector<WorldBounds>(1, WorldBounds{ 0, 0, opts.width, opts.height }) });
+    layouts.push_back(Layout{ "mismatched", { { 0, 0, 1920, 1080 }, { 1920, -200, 4480, 1240 } } });
+    layouts.push_back(Layout{ "left of primary", { { 0, 0, 2560, 1440 }, { -1920, 360, 0, 1440 }, { 2560, -400, 3640, 1520 } } });
+    layouts.push_back(Layout{ "cloned", { { 0, 0, 1920, 1080 }, { 0, 0, 1920, 1080 }, { 1920, 0, 3840, 1080 } } });
+    layouts.push_back(Layout{ "8x2 wall", wall });
+
+    // Synthetic walls of 1000 outputs: aligned, and staggered with mixed
+    // sizes, where no two monitors share an edge coordinate
+    std::vector<WorldBounds> bigWall, staggered;
+    for (int i = 0; i < 1000; i++) {
+        WorldBounds b = { (i % 40) * 1920, (i / 40) * 1080, (i % 40 + 1) * 1920, (i / 40 + 1) * 1080 };
+        bigWall.push_back(b);
+        int width = 1280 + (i * 37) % 640, height = 720 + (i * 53) % 360;
+        int left = (i % 40) * 2000 + (i / 40) * 7, top = (i / 40) * 1100 + (i % 40) * 3;
+        WorldBounds c = { left, top, left + width, top + height };
+        staggered.push_back(c);
+    }
+    layouts.push_back(Layout{ "40x25 wall", bigWall });
+    layouts.push_back(Layout{ "1000 staggered", staggered });
+
+    bool ok = true;
+    printf("%16s %8s %10s %12s %12s %12s %12s\n", "layout", "outputs", "build us", "lookup ns", "touch ns", "linear ns", "mismatches");
+    for (size_t l = 0; l < layouts.size(); l++) {
+        const std::vector<WorldBounds>& monitors = layouts[l].monitors;
+        DisplayTopology topology;
+        auto begin = std::chrono::steady_clock::now();
+        topology.Build(monitors, 0, false, CUBE_SIZE);
+        double buildSeconds = SecondsSince(begin);
+
+        // Query points over the bounding box and a margin around it, with a
+        // share snapped onto monitor edges where off-by-one bugs live
+        const WorldBounds& box = topology.PhysicsBounds();
+        std::vector<float> xs(QUERIES), ys(QUERIES);
+        CubeRandom rng = CubeRandomStream(CubeRandomKey(opts.seed, (unsigned int)l), 0);
+        for (int q = 0; q < QUERIES; q++) {
+            xs[q] = box.left - 200 + CubeRandomUnit(rng) * (box.right - box.left + 400);
+            ys[q] = box.top - 200 + CubeRandomUnit(rng) * (box.bottom - box.top + 400);
+            if (q % 4 == 0) {
+                const WorldBounds& m = monitors[CubeRandomBits(rng) % monitors.size()];
+                xs[q] = (float)(q % 8 == 0 ? m.left : m.right);
+            }
+        }
+
+        long long mismatches = 0;
+        std::vector<int> touching;
+        for (int q = 0; q < QUERIES; q++) {
+            int expected = -1;
+            for (size_t m = 0; m < monitors.size() && expected < 0; m++) {
+                const WorldBounds& b = monitors[m];
+                if (xs[q] >= b.left && xs[q] < b.right && ys[q] >= b.top && ys[q] < b.bottom) expected = (int)m;
+            }
+            if (topology.OutputAt(xs[q], ys[q]) != expected) mismatches++;
+
+            topology.OutputsTouching(xs[q], ys[q], CUBE_SIZE, touching);
+            std::vector<int> scanned;
+            for (size_t m = 0; m < monitors.size(); m++) {
+                if (SquareTouches(monitors[m], xs[q], ys[q], CUBE_SIZE)) scanned.push_back((int)m);
+            }
+            if (touching != scanned) mismatches++;
+        }
+
+        long long sink = 0;
+        begin = std::chrono::steady_clock::now();
+        for (int q = 0; q < QUERIES; q++) sink += topology.OutputAt(xs[q], ys[q]);
+        double lookupSeconds = SecondsSince(begin);
+        begin = std::chrono::steady_clock::now();
+        for (int q = 0; q < QUERIES; q++) {
+            for (size_t m = 0; m < monitors.size(); m++) sink += SquareTouches(monitors[m], xs[q], ys[q], CUBE_SIZE);
+        }
+        double scanSeconds = SecondsSince(begin);
+        begin = std::chrono::steady_clock::now();
+        for (int q = 0; q < QUERIES; q++) {
+            topology.OutputsTouching(xs[q], ys[q], CUBE_SIZE, touching);
+            sink += (long long)touching.size();
+        }
+        double touchSeconds = SecondsSince(begin);
+        if (sink == 42) printf(" ");  // Keep the timed loops from being optimized out
+
+        printf("%16s %8zu %10.1f %12.1f %12.1f %12.1f %12lld\n", layouts[l].name, topology.OutputCount(), buildSeconds * 1e6,
+               lookupSeconds * 1e9 / QUERIES, touchSeconds * 1e9 / QUERIES, scanSeconds * 1e9 / QUERIES, mismatches);
+        ok = ok && mismatches == 0;
+    }
+
+    // Mirror mode bounces on the primary alone and has no desktop shape
+    DisplayTopology mirror;
+    mirror.Build(layouts[2].monitors, 0, true, CUBE_SIZE);
+    const WorldBounds& primary = mirror.PhysicsBounds();
+    bool mirrorOk = mirror.Shape() == NULL && primary.left == 0 && primary.right == 2560 && primary.bottom == 1440;
+    printf("mirror mode physics bounds: (%d, %d)-(%d, %d), %s\n", primary.left, primary.top, primary.right, primary.bottom,
+           mirrorOk ? "ok" : "WRONG");
+
+    return ok && mirrorOk ? 0 : 1;
+}
+
+static int RunSnapshotBenchmark(const BenchOptions& opts) {
+    WorldBounds bounds = { 0, 0, opts.width, opts.height };
+    CubeSettings settings = { opts.cubeSize, true };
+    CubeSnapshotInfo info = { opts.seed, 0x1234, bounds, opts.cubeSize };
+    const char* PATH = "BouncingCubeBench.snap";
+    const int FRAMES = 100;
+    std::vector<CubeBounce> bounces;
+    bool ok = true;
+
+    // Run, save, load and keep running must match running straight through
+    size_t count = opts.maxCubes;
+    CubeSoA straight;
+    SeedCubeSoA(straight, count, opts);
+    for (int f = 0; f < FRAMES; f++) UpdateCubeSoA(straight, bounds, settings, bounces);
+
+    auto begin = std::chrono::steady_clock::now();
+    bool written = WriteCubeSnapshot(PATH, straight, info);
+    double writeSeconds = SecondsSince(begin);
+
+    CubeSoA resumed;
+    CubeSnapshotInfo loadedInfo;
+    begin = std::chrono::steady_clock::now();
+    bool read = ReadCubeSnapshot(PATH, resumed, loadedInfo);
+    double readSeconds = SecondsSince(begin);
+
+    // Loading again into the same store skips the page faults of fresh arrays,
+    // which is most of the cold figure on small VMs
+    begin = std::chrono::steady_clock::now();
+    read = ReadCubeSnapshot(PATH, resumed, loadedInfo) && read;
+    double reloadSeconds = SecondsSince(begin);
+
+    bool roundTrip = written && read && SameCubeSoA(straight, resumed) &&
+                     resumed.stepsSinceNormalize == straight.stepsSinceNormalize &&
+                     loadedInfo.seed == info.seed && loadedInfo.layoutHash == info.layoutHash &&
+                     loadedInfo.cubeSize == info.cubeSize && loadedInfo.bounds.right == bounds.right;
+    for (int f = 0; f < FRAMES; f++) {
+        UpdateCubeSoA(straight, bounds, settings, bounces);
+        UpdateCubeSoA(resumed, bounds, settings, bounces);
+    }
+    bool resumeSame = SameCubeSoA(straight, resumed);
+    double megabytes = CubeSnapshotBytes(count) / 1e6;
+    printf("%zu cubes, %.1f MB: write %.1f ms, mmap load %.1f ms, reload into the same store %.1f ms (%.0f MB/s)\n",
+           count, megabytes, writeSeconds * 1e3, readSeconds * 1e3, reloadSeconds * 1e3, megabytes / reloadSeconds);
+    printf("round trip: %s, resume then %d frames: %s\n", roundTrip ? "identical" : "DIFFERENT", FRAMES,
+           resumeSame ? "identical" : "DIFFERENT");
+    ok = ok && roundTrip && resumeSame;
+
+    // Damaged files must be refused without touching the destination
+    CubeSoA small;
+    SeedCubeSoA(small, 1000, opts);
+    std::vector<unsigned char> image(CubeSnapshotBytes(small.Size()));
+    SaveCubeSnapshot(&image[0], small, info);
+    CubeSoA target;
+    SeedCubeSoA(target, 3, opts);
+    int refused = 0, cases = 0;
+    std::vector<unsigned char> damaged = image;
+    damaged[image.size() / 2] ^= 0x40;
+    cases++;
+    if (!LoadCubeSnapshot(&damaged[0], damaged.size(), target, loadedInfo)) refused++;
+    cases++;
+    if (!LoadCubeSnapshot(&image[0], image.size() - 32, target, loadedInfo)) refused++;
+    damaged = image;
+    damaged[8]++;  // Version
+    cases++;
+    if (!LoadCubeSnapshot(&damaged[0], damaged.size(), target, loadedInfo)) refused++;
+    cases++;
+    if (!ReadCubeSnapshot("BouncingCubeBench.missing.snap", target, loadedInfo)) refused++;
+    bool untouched = target.Size() == 3;
+    printf("damaged snapshots refused: %d of %d, destination %s\n", refused, cases, untouched ? "untouched" : "MODIFIED");
+    ok = ok && refused == cases && untouched;
+
+    remove(PATH);
+    return ok ? 0 : 1;
+}
+
+static void PrintReplayResult(const char* name, const ReplayResult& result, size_t bytes, double seconds) {
+    printf("%-10s %8lld frames %9lld steps %3lld layouts %6lld hashes, %7zu bytes (%.2f/frame), %.1f s in %.1f ms (%.0fx real time), %s\n",
+           name, result.frames, result.steps, result.layouts, result.hashesChecked, bytes,
+           result.frames > 0 ? (double)bytes / result.frames : 0.0, result.simulatedSeconds, seconds * 1e3,
+           result.simulatedSeconds / seconds, result.firstMismatchFrame < 0 ? "all hashes match" : "DIVERGED");
+}
+
+static int RunReplayBenchmark(const BenchOptions& opts) {
+    if (!opts.file.empty()) {
+        std::vector<unsigned char> bytes;
+        ReplayResult result;
+        auto begin = std::chrono::steady_clock::now();
+        bool played = ReadReplayFile(opts.file.c_str(), bytes) && !bytes.empty() && PlayReplay(&bytes[0], bytes.size(), result);
+        if (!played) {
+            printf("%s: not a readable recording\n", opts.file.c_str());
+            return 1;
+        }
+        PrintReplayResult("file", result, bytes.size(), SecondsSince(begin));
+        printf("recorded with --seed %llu, layout hash %016llx\n", result.start.seed, result.start.layoutHash);
+        return result.firstMismatchFrame < 0 ? 0 : 1;
+    }
+
+    // A QueryPerformanceCounter-like 10 MHz timer
+    const long long FREQUENCY = 10000000;
+    const double SESSION_SECONDS = 600.0;
+    CubeSettings settings = { opts.cubeSize, true };
+    float cubePixels = GetCubeSizeInPixels(opts.cubeSize);
+    std::vector<WorldBounds> single(1);
+    single[0].left = 0;
+    single[0].top = 0;
+    single[0].right = opts.width;
+    single[0].bottom = opts.height;
+    std::vector<WorldBounds> pair = single;
+    WorldBounds side = { opts.width, opts.height / 4, opts.width + 1280, opts.height / 4 + 1024 };
+    pair.push_back(side);
+
+    // A session as the app would see it: a 60 Hz monitor with scheduler jitter,
+    // the display switched off for a minute, then a second monitor plugged in
+    // and the frame rate going up to 144 Hz
+    DisplayTopology topology;
+    topology.Build(single, 0, false, cubePixels);
+    Cube cube, previous;
+    ResetCube(cube, 0, 0, opts.seed, 0);
+    PlaceCubeOnPrimary(cube, topology);
+    previous = cube;
+    FixedStepClock clock;
+    InitFixedStepClock(clock, PHYSICS_STEPS_PER_SECOND);
+    ReplayRecorder recorder;
+    recorder.Begin(cube, settings, opts.seed, topology, FREQUENCY, PHYSICS_STEPS_PER_SECOND);
+    unsigned long long startLayout = topology.LayoutHash();
+    recorder.RecordTopology(topology);
+
+    CubeRandom jitter = CubeRandomStream(CubeRandomKey(opts.seed, 1), 0);
+    std::vector<long long> frameTicks, frameSteps;
+    double t = 0;
+    bool screenOff = false, secondMonitor = false;
+    auto begin = std::chrono::steady_clock::now();
+    while (t < SESSION_SECONDS) {
+        double hz = secondMonitor ? 144.0 : 60.0;
+        long long ticks = (long long)(FREQUENCY / hz) + (long long)(CubeRandomUnit(jitter) * 20000) - 10000;
+        if (!screenOff && t > SESSION_SECONDS / 3) {
+            ticks = 60 * FREQUENCY;
+            screenOff = true;
+        }
+        if (!secondMonitor && t > SESSION_SECONDS / 2) {
+            topology.Build(pair, 0, false, cubePixels);
+            KeepCubeOnDesktop(cube, topology);
+            previous = cube;
+            recorder.RecordTopology(topology);
+            secondMonitor = true;
+        }
+        long long steps = AdvanceCubeFrame(cube, previous, clock, topology, settings, (double)ticks / FREQUENCY);
+        recorder.RecordFrame(ticks, steps, cube);
+        frameTicks.push_back(ticks);
+        frameSteps.push_back(steps);
+        t += (double)ticks / FREQUENCY;
+    }
+    double recordSeconds = SecondsSince(begin);
+    const std::vector<unsigned char>& bytes = recorder.Bytes();
+    bool ok = true;
+
+    ReplayResult result;
+    begin = std::chrono::steady_clock::now();
+    bool played = PlayReplay(&bytes[0], bytes.size(), result);
+    PrintReplayResult("synthetic", result, bytes.size(), SecondsSince(begin));
+    bool same = played && SameCube(result.finalCube, cube) && result.frames == (long long)frameTicks.size();
+    printf("final cube after playback: %s\n", same ? "identical to the recorded run" : "DIFFERENT");
+    bool traced = played && result.start.seed == opts.seed && result.start.layoutHash == startLayout;
+    printf("recorded seed and layout: %s\n", traced ? "kept" : "LOST");
+    ok = ok && same && traced && result.firstMismatchFrame < 0 && result.layouts == 2 && result.hashesChecked > 0;
+
+    // A frame whose timing was altered must be caught by the next hash
+    std::vector<unsigned char> tampered = bytes;
+    ReplayResult tamperedResult;
+    tampered[tampered.size() / 2] ^= 0x08;
+    bool caught = !PlayReplay(&tampered[0], tampered.size(), tamperedResult) || tamperedResult.firstMismatchFrame >= 0;
+    printf("tampered recording: %s", caught ? "caught" : "NOT CAUGHT");
+    if (tamperedResult.firstMismatchFrame >= 0) printf(" at frame %lld", tamperedResult.firstMismatchFrame);
+    printf("\n");
+    ok = ok && caught;
+
+    // Recording cost alone, replaying the same frames into a fresh recorder
+    const int REPEATS = 10;
+    begin = std::chrono::steady_clock::now();
+    size_t sink = 0;
+    for (int r = 0; r < REPEATS; r++) {
+        ReplayRecorder timing;
+        timing.Begin(cube, settings, opts.seed, topology, FREQUENCY, PHYSICS_STEPS_PER_SECOND);
+        timing.RecordTopology(topology);
+        for (size_t f = 0; f < frameTicks.size(); f++) timing.RecordFrame(frameTicks[f], frameSteps[f], cube);
+        sink += timing.Bytes().size();
+    }
+    double perFrame = SecondsSince(begin) / (REPEATS * (double)frameTicks.size());
+    if (sink == 42) printf(" ");  // Keep the timed loop from being optimized out
+    double simulatePerFrame = recordSeconds / frameTicks.size();
+    const double FRAME_BUDGET = 1.0 / 60;
+    printf("recording overhead: %.1f ns/frame, %.5f%% of a 60 Hz frame, %.1f%% of the physics it records (%.1f ns/frame)\n",
+           perFrame * 1e9, perFrame / FRAME_BUDGET * 100, perFrame / simulatePerFrame * 100, simulatePerFrame * 1e9);
+    ok = ok && perFrame < FRAME_BUDGET / 100;
+
+    return ok ? 0 : 1;
+}
+
+static DisplayOutput MakeOutput(int width, int height) {
+    DisplayOutput output;
+    output.bounds.left = 0;
+    output.bounds.top = 0;
+    output.bounds.right = width;
+    output.bounds.bottom = height;
+    output.width = width;
+    output.height = height;
+    output.aspect = (float)width / height;
+    output.primary = true;
+    output.index = 0;
+    output.imageSource = 0;
+    SetOutputView(output, output.bounds);
+    return output;
+}
+
+static long long CoveredPixels(const SoftwareFramebuffer& framebuffer) {
+    long long covered = 0;
+    for (int y = 0; y < framebuffer.Height(); y++) {
+        const unsigned int* row = framebuffer.Row(y);
+        for (int x = 0; x < framebuffer.Width(); x++) covered += row[x] != RASTER_OPAQUE;
+    }
+    return covered;
+}
+
+static double TriangleArea(const RasterTriangle& t) {
+    return fabs(((double)t.v[1].x - t.v[0].x) * ((double)t.v[2].y - t.v[0].y) -
+                ((double)t.v[1].y - t.v[0].y) * ((double)t.v[2].x - t.v[0].x)) / 2;
+}
+
+static int RunRasterBenchmark(const BenchOptions& opts) {
+    printf("kernel: %s\n", RasterKernelName());
+    bool ok = true;
+
+    // Coverage: over many orientations, the triangles drawn one at a time must
+    // add up to the whole cube (no pixel drawn twice along a shared edge), and
+    // the whole cube must match the area of its outline (no cracks)
+    DisplayOutput small = MakeOutput(800, 600);
+    SoftwareFramebuffer framebuffer;
+    framebuffer.Resize(small.width, small.height);
+    float size = opts.cubeSize * 4;
+    int overlapFrames = 0;
+    double worstAreaError = 0;
+    Cube cube;
+    ResetCube(cube, 400.0f, 300.0f, opts.seed, 0);
+    for (int f = 0; f < 200; f++) {
+        for (int r = 0; r < 7; r++) RotateCube(cube);
+        RasterTriangle triangles[12];
+        int count = ProjectCube(cube, small, size, triangles);
+        long long separately = 0;
+        double area = 0;
+        for (int t = 0; t < count; t++) {
+            framebuffer.Clear(RASTER_OPAQUE);
+            RasterizeTriangle(framebuffer, triangles[t]);
+            separately += CoveredPixels(framebuffer);
+            area += TriangleArea(triangles[t]);
+        }
+        RenderSceneSoftware(framebuffer, small, cube, size, true);
+        long long together = CoveredPixels(framebuffer);
+        if (together != separately) overlapFrames++;
+        worstAreaError = fmax(worstAreaError, fabs(together - area) / area);
+    }
+    printf("coverage over 200 orientations: %d with pixels drawn twice, worst area error %.2f%%\n", overlapFrames,
+           worstAreaError * 100);
+    ok = ok && overlapFrames == 0 && worstAreaError < 0.02;
+
+    // Lighting: facing the viewer the front face gets full ambient + diffuse
+    ResetCube(cube, 400.0f, 300.0f, opts.seed, 0);
+    RenderSceneSoftware(framebuffer, small, cube, size, true);
+    unsigned int center = framebuffer.Row(300)[400];
+    unsigned int expected = CUBE_RGB(std::min(255, (int)(CUBE_R(cube.color) / 255.0f * 1.2f * 255.0f + 0.5f)),
+                                     std::min(255, (int)(CUBE_G(cube.color) / 255.0f * 1.2f * 255.0f + 0.5f)),
+                                     std::min(255, (int)(CUBE_B(cube.color) / 255.0f * 1.2f * 255.0f + 0.5f))) | RASTER_OPAQUE;
+    printf("front face color: %08x, GL_LIGHT0 gives %08x: %s\n", center, expected, center == expected ? "match" : "DIFFERENT");
+    ok = ok && center == expected;
+
+    // PPM of a 1080p frame with the cube part way through a turn
+    const char* path = opts.file.empty() ? "BouncingCubeBench.ppm" : opts.file.c_str();
+    DisplayOutput fullHd = MakeOutput(1920, 1080);
+    ResetCube(cube, 960.0f, 540.0f, opts.seed, 0);
+    for (int r = 0; r < 40; r++) RotateCube(cube);
+    RenderSceneSoftware(framebuffer, fullHd, cube, size, true);
+    bool written = WriteFramebufferPPM(path, framebuffer);
+    FILE* file = fopen(path, "rb");
+    long ppmBytes = 0;
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        ppmBytes = ftell(file);
+        fclose(file);
+    }
+    bool ppmOk = written && ppmBytes == (long)strlen("P6\n1920 1080\n255\n") + 1920L * 1080 * 3;
+    printf("PPM frame: %s, %ld bytes, %s\n", path, ppmBytes, ppmOk ? "ok" : "WRONG");
+    if (opts.file.empty()) remove(path);
+    ok = ok && ppmOk;
+
+    // Throughput: one cube is mostly the clear, 1000 cubes stress the rasterizer
+    const int SIZES[3][2] = { { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+    const char* NAMES[3] = { "1080p", "4K", "8K" };
+    const size_t CROWD = 1000;
+    printf("%-6s %10s %10s %12s %12s %14s\n", "output", "clear ms", "1 cube fps", "1 cube ms", "1000 cubes ms", "Mpixels/s");
+    for (int r = 0; r < 3; r++) {
+        DisplayOutput output = MakeOutput(SIZES[r][0], SIZES[r][1]);
+        WorldBounds bounds = output.bounds;
+        CubeSettings settings = { opts.cubeSize, true };
+        std::vector<Cube> crowd(CROWD);
+        for (size_t i = 0; i < CROWD; i++) {
+            ResetCube(crowd[i], (float)((i * 7919) % bounds.right), (float)((i * 104729) % bounds.bottom), opts.seed, (unsigned int)i);
+        }
+        ResetCube(cube, output.width / 2.0f, output.height / 2.0f, opts.seed, 0);
+        framebuffer.Resize(output.width, output.height);
+
+        const int FRAMES = r == 0 ? 60 : r == 1 ? 20 : 8;
+        auto begin = std::chrono::steady_clock::now();
+        for (int f = 0; f < FRAMES; f++) framebuffer.Clear(RASTER_OPAQUE);
+        double clearSeconds = SecondsSince(begin) / FRAMES;
+
+        begin = std::chrono::steady_clock::now();
+        for (int f = 0; f < FRAMES; f++) {
+            StepCube(cube, bounds, settings);
+            RenderSceneSoftware(framebuffer, output, cube, opts.cubeSize, true);
+        }
+        double singleSeconds = SecondsSince(begin) / FRAMES;
+
+        begin = std::chrono::steady_clock::now();
+        long long pixels = 0;
+        for (int f = 0; f < FRAMES; f++) {
+            framebuffer.Clear(RASTER_OPAQUE);
+            for (size_t i = 0; i < CROWD; i++) {
+                StepCube(crowd[i], bounds, settings);
+                RasterTriangle triangles[12];
+                int count = ProjectCube(crowd[i], output, opts.cubeSize, triangles);
+                for (int t = 0; t < count; t++) {
+                    RasterizeTriangle(framebuffer, triangles[t]);
+                    if (f == 0) pixels += (long long)TriangleArea(triangles[t]);
+                }
+            }
+        }
+        double crowdSeconds = SecondsSince(begin) / FRAMES;
+        printf("%-6s %10.2f %10.1f %12.2f %12.2f %14.0f\n", NAMES[r], clearSeconds * 1e3, 1.0 / singleSeconds,
+               singleSeconds * 1e3, crowdSeconds * 1e3, pixels / fmax(crowdSeconds - clearSeconds, 1e-9) / 1e6);
+    }
+
+    return ok ? 0 : 1;
+}
+
+// A wall of `across` x `down` outputs of one size, with `perOutput` cubes
+// spread over each
+static void MakeWall(int across, int down, int width, int height, size_t perOutput, const BenchOptions& opts,
+                     DisplayTopology& topology, std::vector<Cube>& cubes) {
+    std::vector<WorldBounds> monitors;
+    for (int j = 0; j < down; j++) {
+        for (int i = 0; i < across; i++) {
+            WorldBounds b = { i * width, j * height, (i + 1) * width, (j + 1) * height };
+            monitors.push_back(b);
+        }
+    }
+    topology.Build(monitors, 0, false, GetCubeSizeInPixels(opts.cubeSize));
+    cubes.resize(monitors.size() * perOutput);
+    for (size_t i = 0; i < cubes.size(); i++) {
+        float x = (float)((i * 7919) % (size_t)(across * width));
+        float y = (float)((i * 104729) % (size_t)(down * height));
+        ResetCube(cubes[i], x, y, opts.seed, (unsigned int)i);
+        for (int r = 0; r < (int)(i % 50); r++) RotateCube(cubes[i]);
+    }
+}
+
+// What WM_TIMER does today, in software: each output cleared, drawn and
+// converted in turn on one thread
+static void RenderOutputsSerially(const DisplayTopology& topology, const std::vector<Cube>& cubes, float cubeSize,
+                                  std::vector<SoftwareFramebuffer>& framebuffers, std::vector<std::vector<unsigned int> >& present) {
+    const float HALF_SIZE = GetCubeSizeInPixels(cubeSize);
+    framebuffers.resize(topology.OutputCount());
+    present.resize(topology.OutputCount());
+    for (size_t o = 0; o < topology.OutputCount(); o++) {
+        const DisplayOutput& output = topology.Output(o);
+        SoftwareFramebuffer& framebuffer = framebuffers[o];
+        framebuffer.Resize(output.width, output.height);
+        framebuffer.Clear(RASTER_OPAQUE);
+        for (size_t i = 0; i < cubes.size(); i++) {
+            const Cube& cube = cubes[i];
+            if (cube.x + HALF_SIZE < output.bounds.left || cube.x - HALF_SIZE > output.bounds.right ||
+                cube.y + HALF_SIZE < output.bounds.top || cube.y - HALF_SIZE > output.bounds.bottom) {
+                continue;
+            }
+            RasterTriangle triangles[12];
+            int count = ProjectCube(cube, output, cubeSize, triangles);
+            for (int t = 0; t < count; t++) RasterizeTriangle(framebuffer, triangles[t]);
+        }
+        present[o].resize((size_t)output.width * output.height);
+        for (int y = 0; y < output.height; y++) {
+            const unsigned int* in = framebuffer.Row(y);
+            unsigned int* out = &present[o][(size_t)y * output.width];
+            for (int x = 0; x < output.width; x++) {
+                out[x] = (in[x] & 0xFF00FF00u) | ((in[x] & 0xFF) << 16) | ((in[x] >> 16) & 0xFF);
+            }
+        }
+    }
+}
+
+static int RunTilesBenchmark(const BenchOptions& opts) {
+    int maxThreads = opts.threads > 0 ? opts.threads : (int)std::thread::hardware_concurrency();
+    if (maxThreads < 1) maxThreads = 1;
+    printf("threads: 1..%d (hardware reports %u), %dx%d tiles, kernel %s\n", maxThreads, std::thread::hardware_concurrency(),
+           RASTER_TILE_SIZE, RASTER_TILE_SIZE, RasterKernelName());
+    const size_t CUBES_PER_OUTPUT = 200;
+    const int WALLS[3][2] = { { 1, 1 }, { 2, 2 }, { 4, 4 } };
+    bool ok = true;
+
+    for (int w = 0; w < 3; w++) {
+        DisplayTopology topology;
+        std::vector<Cube> cubes;
+        MakeWall(WALLS[w][0], WALLS[w][1], 3840, 2160, CUBES_PER_OUTPUT, opts, topology, cubes);
+        const int FRAMES = w == 0 ? 10 : w == 1 ? 4 : 2;
+
+        std::vector<SoftwareFramebuffer> reference;
+        std::vector<std::vector<unsigned int> > referencePresent;
+        RenderOutputsSerially(topology, cubes, opts.cubeSize, reference, referencePresent);
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < FRAMES; f++) RenderOutputsSerially(topology, cubes, opts.cubeSize, reference, referencePresent);
+        double serialSeconds = SecondsSince(start) / FRAMES;
+        printf("%zu x 4K, %zu cubes: serial per-output loop %.1f ms/frame\n", topology.OutputCount(), cubes.size(),
+               serialSeconds * 1e3);
+        printf("%8s %12s %9s %10s %10s %10s\n", "threads", "frame ms", "speedup", "bin ms", "tiles ms", "identical");
+
+        // Oversubscribe small machines so the identity check still sees stealing
+        int verifyThreads = maxThreads > 4 ? maxThreads : 4;
+        for (int threads = 1; threads <= verifyThreads; threads *= 2) {
+            CubeWorkerPool pool(threads);
+            TiledRenderer renderer;
+            renderer.Render(topology, &cubes[0], cubes.size(), opts.cubeSize, pool);
+            bool same = true;
+            for (size_t o = 0; o < topology.OutputCount(); o++) {
+                const DisplayOutput& output = topology.Output(o);
+                const SoftwareFramebuffer& framebuffer = renderer.Framebuffer(o);
+                for (int y = 0; y < output.height && same; y++) {
+                    same = memcmp(framebuffer.Row(y), reference[o].Row(y), output.width * sizeof(unsigned int)) == 0;
+                }
+                same = same && memcmp(renderer.Present(o), &referencePresent[o][0], referencePresent[o].size() * sizeof(unsigned int)) == 0;
+            }
+            ok = ok && same;
+
+            double bin = 0, tile = 0;
+            start = std::chrono::steady_clock::now();
+            for (int f = 0; f < FRAMES; f++) {
+                renderer.Render(topology, &cubes[0], cubes.size(), opts.cubeSize, pool);
+                bin += renderer.binSeconds;
+                tile += renderer.tileSeconds;
+            }
+            double seconds = SecondsSince(start) / FRAMES;
+            const char* note = threads > maxThreads ? " (oversubscribed)" : "";
+            printf("%8d %12.1f %8.2fx %10.2f %10.1f %10s%s\n", threads, seconds * 1e3, serialSeconds / seconds,
+                   bin * 1e3 / FRAMES, tile * 1e3 / FRAMES, same ? "yes" : "NO", note);
+            if (threads < maxThreads && threads * 2 > maxThreads && maxThreads > verifyThreads / 2) threads = maxThreads / 2;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
+
+// Full redraw against dirty tiles on the same moving cubes, one thread so
+// frame time is CPU time
+static int RunDirtyBenchmark(const BenchOptions& opts) {
+    struct Scene {
+        const char* name;
+        int across, down;
+        size_t cubes;
+    };
+    const Scene SCENES[] = {
+        { "1 x 4K, 1 cube", 1, 1, 1 },
+        { "16 x 4K, 1 cube", 4, 4, 1 },
+        { "1 x 4K, 20 cubes", 1, 1, 20 },
+    };
+    const int FRAMES = 120;
+    const int CHECK_EVERY = 20;
+    CubeSettings settings = { opts.cubeSize, false };
+    CubeWorkerPool pool(1);
+    bool ok = true;
+
+    printf("%-18s %14s %14s %9s %9s %8s %10s\n", "scene", "full px/frame", "dirty px/frame", "full ms", "dirty ms",
+           "rects", "identical");
+    for (size_t n = 0; n < sizeof(SCENES) / sizeof(SCENES[0]); n++) {
+        const Scene& scene = SCENES[n];
+        DisplayTopology topology;
+        std::vector<Cube> cubes;
+        MakeWall(scene.across, scene.down, 3840, 2160, scene.cubes, opts, topology, cubes);
+        cubes.resize(scene.cubes);
+
+        TiledRenderer full, dirty;
+        full.SetDirtyTracking(false);
+        // The first frame after a layout redraws everything either way
+        full.Render(topology, &cubes[0], cubes.size(), opts.cubeSize, pool);
+        dirty.Render(topology, &cubes[0], cubes.size(), opts.cubeSize, pool);
+        double fullSeconds = 0, dirtySeconds = 0;
+        long long fullPixels = 0, dirtyPixels = 0, rects = 0;
+        bool same = true;
+        for (int f = 0; f < FRAMES; f++) {
+            for (size_t i = 0; i < cubes.size(); i++) StepCube(cubes[i], topology.PhysicsBounds(), settings);
+            auto start = std::chrono::steady_clock::now();
+            full.Render(topology, &cubes[0], cubes.size(), opts.cubeSize, pool);
+            fullSeconds += SecondsSince(start);
+            start = std::chrono::steady_clock::now();
+            dirty.Render(topology, &cubes[0], cubes.size(), opts.cubeSize, pool);
+            dirtySeconds += SecondsSince(start);
+            fullPixels += full.pixelsTouched;
+            dirtyPixels += dirty.pixelsTouched;
+            for (size_t o = 0; o < topology.OutputCount(); o++) rects += dirty.DirtyRects(o).size();
+
+            // What is left on screen must match a full redraw, stale pixels included
+            if (f % CHECK_EVERY == 0 || f == FRAMES - 1) {
+                for (size_t o = 0; o < topology.OutputCount() && same; o++) {
+                    const DisplayOutput& output = topology.Output(o);
+                    same = memcmp(full.Present(o), dirty.Present(o), (size_t)output.width * output.height * sizeof(unsigned int)) == 0;
+                }
+            }
+        }
+        ok = ok && same;
+        printf("%-18s %14lld %14lld %9.2f %9.2f %8.1f %10s\n", scene.name, fullPixels / FRAMES, dirtyPixels / FRAMES,
+               fullSeconds * 1e3 / FRAMES, dirtySeconds * 1e3 / FRAMES, (double)rects / FRAMES, same ? "yes" : "NO");
+    }
+    return ok ? 0 : 1;
+}
+
+// Mirror mode: outputs of one resolution drawn once and shown on all of them,
+// against every output drawing the same picture itself
+static int RunMirrorBenchmark(const BenchOptions& opts) {
+    struct Layout {
+        const char* name;
+        int sizes[8][2];
+        size_t count;
+        size_t drawn;  // Distinct resolutions
+    };
+    const Layout LAYOUTS[] = {
+        { "2 x 1080p", { { 1920, 1080 }, { 1920, 1080 } }, 2, 1 },
+        { "4 x 1080p", { { 1920, 1080 }, { 1920, 1080 }, { 1920, 1080 }, { 1920, 1080 } }, 4, 1 },
+        { "8 x 1080p", { { 1920, 1080 }, { 1920, 1080 }, { 1920, 1080 }, { 1920, 1080 },
+                         { 1920, 1080 }, { 1920, 1080 }, { 1920, 1080 }, { 1920, 1080 } }, 8, 1 },
+        { "1080p/1440p/4K mix", { { 1920, 1080 }, { 2560, 1440 }, { 1920, 1080 }, { 3840, 2160 },
+                                  { 2560, 1440 }, { 1920, 1080 } }, 6, 3 },
+    };
+    const int FRAMES = 60;
+    CubeSettings settings = { opts.cubeSize, false };
+    CubeWorkerPool pool(1);
+    bool ok = true;
+
+    printf("%-20s %8s %6s %10s %10s %12s %12s %10s\n", "layout", "outputs", "drawn", "shared ms", "all ms",
+           "shared px", "all px", "identical");
+    for (size_t n = 0; n < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); n++) {
+        const Layout& layout = LAYOUTS[n];
+        std::vector<WorldBounds> monitors;
+        int left = 0;
+        for (size_t m = 0; m < layout.count; m++) {
+            WorldBounds b = { left, 0, left + layout.sizes[m][0], layout.sizes[m][1] };
+            monitors.push_back(b);
+            left = b.right;
+        }
+        DisplayTopology topology;
+        topology.Build(monitors, 0, true, GetCubeSizeInPixels(opts.cubeSize));
+        Cube cube;
+        PlaceCubeOnPrimary(cube, topology);
+        ResetCube(cube, cube.x, cube.y, opts.seed, 0);
+
+        // Whole frames, as the GL path draws them, so the cost is per picture
+        TiledRenderer shared, all;
+        shared.SetDirtyTracking(false);
+        all.SetDirtyTracking(false);
+        all.SetImageSharing(false);
+        shared.Render(topology, &cube, 1, opts.cubeSize, pool);
+        all.Render(topology, &cube, 1, opts.cubeSize, pool);
+        double sharedSeconds = 0, allSeconds = 0;
+        long long sharedPixels = 0, allPixels = 0;
+        bool same = shared.DrawnOutputCount() == layout.drawn;
+        SoftwareFramebuffer alone;
+        for (int f = 0; f < FRAMES; f++) {
+            StepCube(cube, topology.PhysicsBounds(), settings);
+            auto start = std::chrono::steady_clock::now();
+            shared.Render(topology, &cube, 1, opts.cubeSize, pool);
+            sharedSeconds += SecondsSince(start);
+            start = std::chrono::steady_clock::now();
+            all.Render(topology, &cube, 1, opts.cubeSize, pool);
+            allSeconds += SecondsSince(start);
+            sharedPixels += shared.pixelsTouched;
+            allPixels += all.pixelsTouched;
+
+            // Every output shows the cube, exactly as drawing it alone would
+            if (f % 20 == 0 || f == FRAMES - 1) {
+                for (size_t o = 0; o < topology.OutputCount() && same; o++) {
+                    const DisplayOutput& output = topology.Output(o);
+                    RenderSceneSoftware(alone, output, cube, opts.cubeSize, true);
+                    same = CoveredPixels(alone) > 0;
+                    for (int y = 0; y < output.height && same; y++) {
+                        same = memcmp(shared.Framebuffer(o).Row(y), alone.Row(y), output.width * sizeof(unsigned int)) == 0;
+                    }
+                    same = same && memcmp(shared.Present(o), all.Present(o),
+                                          (size_t)output.width * output.height * sizeof(unsigned int)) == 0;
+                }
+            }
+        }
+        ok = ok && same;
+        printf("%-20s %8zu %6zu %10.2f %10.2f %12lld %12lld %10s\n", layout.name, topology.OutputCount(),
+               shared.DrawnOutputCount(), sharedSeconds * 1e3 / FRAMES, allSeconds * 1e3 / FRAMES, sharedPixels / FRAMES,
+               allPixels / FRAMES, same ? "yes" : "NO");
+    }
+    return ok ? 0 : 1;
+}
+
+// One cube crossing a 3x2 wall, each frame checked against what a software
+// render of every output would show
+static int RunSkipBenchmark(const BenchOptions& opts) {
+    const int ACROSS = 3, DOWN = 2, WIDTH = 480, HEIGHT = 270;
+    const int FRAMES = 6000;
+    DisplayTopology topology;
+    std::vector<Cube> cubes;
+    MakeWall(ACROSS, DOWN, WIDTH, HEIGHT, 1, opts, topology, cubes);
+    Cube cube = cubes[0];
+    PlaceCubeOnPrimary(cube, topology);
+    CubeSettings settings = { opts.cubeSize, false };
+    const float HALF_SIZE = GetCubeSizeInPixels(opts.cubeSize);
+
+    PresentTracker presents;
+    size_t outputs = topology.OutputCount();
+    std::vector<std::vector<unsigned int> > shown(outputs);  // What each screen shows
+    std::vector<bool> shownCube(outputs, false);
+    std::vector<long long> leaves(outputs, 0), blankPresents(outputs, 0);
+    SoftwareFramebuffer framebuffer;
+    std::vector<unsigned int> image;
+    std::vector<int> touched;
+    long long wrongSkips = 0, extraBlanks = 0, unpresentedLayouts = 0;
+
+    for (int f = 0; f < FRAMES; f++) {
+        // Halfway through, the same monitors are reported again, as after a
+        // WM_DISPLAYCHANGE: everything must be presented once more
+        bool relayout = f == FRAMES / 2;
+        if (relayout) {
+            std::vector<WorldBounds> monitors;
+            for (size_t o = 0; o < outputs; o++) monitors.push_back(topology.Output(o).bounds);
+            topology.Build(monitors, 0, false, HALF_SIZE);
+            leaves.assign(outputs, 0);
+            blankPresents.assign(outputs, 0);
+        }
+        StepCubeDesktop(cube, *topology.Shape(), settings);
+        topology.OutputsTouching(cube.x, cube.y, HALF_SIZE, touched);
+        presents.Sync(topology);
+
+        size_t next = 0;
+        for (size_t o = 0; o < outputs; o++) {
+            bool drawCube = next < touched.size() && touched[next] == (int)o;
+            if (drawCube) next++;
+            RenderSceneSoftware(framebuffer, topology.Output(o), cube, opts.cubeSize, drawCube);
+            image.resize((size_t)WIDTH * HEIGHT);
+            for (int y = 0; y < HEIGHT; y++) memcpy(&image[(size_t)y * WIDTH], framebuffer.Row(y), WIDTH * sizeof(unsigned int));
+
+            OutputFrame frame = DescribeOutputFrame(cube, drawCube);
+            if (!presents.ShouldPresent(o, frame)) {
+                if (image != shown[o]) wrongSkips++;
+                if (relayout) unpresentedLayouts++;
+                continue;
+            }
+            if (!frame.cubeVisible) {
+                if (f > 0 && !relayout && !shownCube[o]) extraBlanks++;
+                if (shownCube[o]) leaves[o]++;
+                blankPresents[o]++;
+            }
+            shown[o] = image;
+            shownCube[o] = frame.cubeVisible;
+            presents.Presented(o, frame);
+        }
+    }
+
+    printf("%d frames, %dx%d wall of %dx%d outputs; counts are for the last %d, after the relayout\n", FRAMES, ACROSS,
+           DOWN, WIDTH, HEIGHT, FRAMES - FRAMES / 2);
+    printf("%8s %10s %10s %10s %14s\n", "output", "presented", "skipped", "cube left", "blank presents");
+    long long presented = 0;
+    for (size_t o = 0; o < outputs; o++) {
+        printf("%8zu %10lld %10lld %10lld %14lld\n", o, presents.PresentedFrames(o), presents.SkippedFrames(o), leaves[o],
+               blankPresents[o]);
+        presented += presents.PresentedFrames(o);
+    }
+    long long everyFrame = (long long)(FRAMES - FRAMES / 2) * outputs;
+    printf("presents: %lld instead of %lld, %.1f%% skipped\n", presented, everyFrame,
+           100.0 * (1.0 - (double)presented / everyFrame));
+    printf("skipped frames that would have looked different: %lld\n", wrongSkips);
+    printf("blank presents not following the cube leaving: %lld, outputs not presented after relayout: %lld\n", extraBlanks,
+           unpresentedLayouts);
+    return wrongSkips == 0 && extraBlanks == 0 && unpresentedLayouts == 0 ? 0 : 1;
+}
+
+// Software renderer that also checks every scene it is handed stays whole and
+// unchanged while it draws
+class CheckedOutputRenderer : public OutputRenderer {
+public:
+    CheckedOutputRenderer(const DisplayOutput& output, float cubeSize)
+        : software(output, cubeSize, false), lastFrame(0), torn(0), backwards(0), began(false), ended(false) {}
+
+    bool Begin() {
+        began = true;
+        return software.Begin();
+    }
+
+    void Render(const SceneSnapshot& scene) {
+        if (!Whole(scene)) torn++;
+        if (scene.frame <= lastFrame) backwards++;
+        lastFrame = scene.frame;
+        software.Render(scene);
+        if (!Whole(scene)) torn++;
+    }
+
+    void End() { ended = true; }
+
+    // The bench stamps every cube of a scene with its frame number
+    static bool Whole(const SceneSnapshot& scene) {
+        for (size_t i = 0; i < scene.cubes.size(); i++) {
+            if (scene.cubes[i].randomEvents != scene.frame) return false;
+        }
+        return true;
+    }
+
+    SoftwareOutputRenderer software;
+    unsigned long long lastFrame;
+    long long torn, backwards;
+    bool began, ended;
+};
+
+// Render threads fed as fast as one simulation thread can publish, checked
+// for torn or reused scenes and for the final frame against a serial render
+static int RunThreadsBenchmark(const BenchOptions& opts) {
+    const int ACROSS = 3, DOWN = 2, WIDTH = 320, HEIGHT = 180;
+    const int FRAMES = 5000;
+    const int RESTARTS = 50;
+    DisplayTopology topology;
+    std::vector<Cube> cubes;
+    MakeWall(ACROSS, DOWN, WIDTH, HEIGHT, 8, opts, topology, cubes);
+    CubeSettings settings = { opts.cubeSize, false };
+    size_t outputs = topology.OutputCount();
+    printf("%zu outputs of %dx%d, %zu cubes, %d scenes, hardware threads %u\n", outputs, WIDTH, HEIGHT, cubes.size(), FRAMES,
+           std::thread::hardware_concurrency());
+
+    std::vector<CheckedOutputRenderer*> checked;
+    std::vector<OutputRenderer*> renderers;
+    for (size_t o = 0; o < outputs; o++) {
+        checked.push_back(new CheckedOutputRenderer(topology.Output(o), opts.cubeSize));
+        renderers.push_back(checked.back());
+    }
+
+    OutputRenderThreads threads;
+    threads.Start(renderers);
+    double publishSeconds = 0;
+    unsigned long long frame = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < FRAMES; f++) {
+        for (size_t i = 0; i < cubes.size(); i++) StepCube(cubes[i], topology.PhysicsBounds(), settings);
+        auto publishStart = std::chrono::steady_clock::now();
+        SceneSnapshot& scene = threads.BeginScene();
+        scene.cubes = cubes;
+        frame++;
+        for (size_t i = 0; i < scene.cubes.size(); i++) scene.cubes[i].randomEvents = frame;
+        threads.PublishScene();
+        publishSeconds += SecondsSince(publishStart);
+        if (f % 2) std::this_thread::yield();  // Let render threads interleave even on one core
+    }
+    double seconds = SecondsSince(start);
+
+    // Every output ends up showing the last scene
+    bool settled = false;
+    auto waitStart = std::chrono::steady_clock::now();
+    while (!settled && SecondsSince(waitStart) < 10.0) {
+        settled = true;
+        for (size_t o = 0; o < outputs; o++) settled = settled && threads.LastFrame(o) == frame;
+        if (!settled) std::this_thread::yield();
+    }
+    std::vector<long long> rendered(outputs), dropped(outputs);
+    for (size_t o = 0; o < outputs; o++) {
+        rendered[o] = threads.FramesRendered(o);
+        dropped[o] = threads.FramesDropped(o);
+    }
+    threads.Stop();
+
+    bool ok = settled;
+    printf("%8s %10s %10s %8s %10s %10s\n", "output", "rendered", "dropped", "torn", "backwards", "last frame");
+    SceneSnapshot last;
+    last.frame = frame;
+    last.cubes = cubes;
+    for (size_t o = 0; o < outputs; o++) {
+        CheckedOutputRenderer& r = *checked[o];
+        SoftwareOutputRenderer reference(topology.Output(o), opts.cubeSize, false);
+        reference.Begin();
+        reference.Render(last);
+        bool same = true;
+        for (int y = 0; y < HEIGHT && same; y++) {
+            same = memcmp(reference.Framebuffer().Row(y), r.software.Framebuffer().Row(y), WIDTH * sizeof(unsigned int)) == 0;
+        }
+        bool accounted = rendered[o] + dropped[o] == (long long)frame;
+        printf("%8zu %10lld %10lld %8lld %10lld %10s\n", o, rendered[o], dropped[o], r.torn, r.backwards,
+               same ? "identical" : "DIFFERENT");
+        ok = ok && same && accounted && r.torn == 0 && r.backwards == 0 && r.began && r.ended;
+    }
+    printf("published %.0f scenes/sec, %.2f us per publish (scene copy and wakeup included), all outputs settled on the last: %s\n",
+           FRAMES / seconds, publishSeconds * 1e6 / FRAMES, settled ? "yes" : "NO");
+
+    // Start and stop under load, so shutdown never hangs or loses an End
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < RESTARTS; r++) {
+        threads.Start(renderers);
+        for (int f = 0; f < 20; f++) {
+            SceneSnapshot& scene = threads.BeginScene();
+            scene.cubes = cubes;
+            for (size_t i = 0; i < scene.cubes.size(); i++) scene.cubes[i].randomEvents = f + 1;
+            threads.PublishScene();
+        }
+        threads.Stop();
+    }
+    printf("%d start/stop cycles: %.2f ms each\n", RESTARTS, SecondsSince(start) * 1e3 / RESTARTS);
+    for (size_t o = 0; o < outputs; o++) {
+        ok = ok && checked[o]->torn == 0 && checked[o]->ended;
+        delete checked[o];
+    }
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// SceneExchange on its own: cost of each side uncontended, next to a mutex
+// guarding one shared scene, then publish-to-acquire latency with readers
+// polling while the writer publishes, every scene checked for tearing
+static int RunExchangeBenchmark(const BenchOptions& opts) {
+    const int CUBES = 16;
+    const int OPS = 1000000;
+    std::vector<Cube> cubes(CUBES);
+    for (int i = 0; i < CUBES; i++) ResetCube(cubes[i], 100.0f * i, 100.0f, opts.seed, (unsigned int)i);
+
+    SceneExchange single(1);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < OPS; i++) {
+        SceneSnapshot& scene = single.BeginPublish();
+        scene.cubes = cubes;
+        single.Publish();
+    }
+    double publishNs = SecondsSince(start) * 1e9 / OPS;
+    unsigned long long checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < OPS; i++) {
+        const SceneSnapshot* scene = single.Acquire();
+        checksum += scene->frame;
+        single.Release(scene);
+    }
+    double acquireNs = SecondsSince(start) * 1e9 / OPS;
+    std::mutex mutex;
+    SceneSnapshot shared, copy;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < OPS; i++) {
+        std::lock_guard<std::mutex> lock(mutex);
+        shared.cubes = cubes;
+        shared.frame++;
+    }
+    double lockedPublishNs = SecondsSince(start) * 1e9 / OPS;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < OPS; i++) {
+        std::lock_guard<std::mutex> lock(mutex);
+        copy = shared;
+    }
+    double lockedReadNs = SecondsSince(start) * 1e9 / OPS;
+    bool ok = checksum == (unsigned long long)OPS * OPS;  // Every acquire saw the last of the OPS scenes
+    printf("%d cubes per scene, uncontended, ns per operation:\n", CUBES);
+    printf("  exchange: publish %.1f (scene copy included), acquire + release %.1f\n", publishNs, acquireNs);
+    printf("  mutex:    publish %.1f, read %.1f (readers must copy out under the lock)\n", lockedPublishNs, lockedReadNs);
+
+    const int FRAMES = 20000;
+    const int READER_COUNTS[] = { 1, 2, 4, 8 };
+    printf("%8s %10s %10s %10s %10s %10s %8s %10s\n", "readers", "scenes", "seen", "p50 us", "p99 us", "max us", "torn",
+           "backwards");
+    for (size_t c = 0; c < sizeof(READER_COUNTS) / sizeof(READER_COUNTS[0]); c++) {
+        int readers = READER_COUNTS[c];
+        SceneExchange exchange(readers);
+        std::vector<std::chrono::steady_clock::time_point> stamps(FRAMES + 1);
+        std::atomic<bool> done(false);
+        std::vector<std::vector<double> > latencies(readers);
+        std::vector<long long> torn(readers, 0), backwards(readers, 0);
+        std::vector<std::thread> threads;
+        for (int r = 0; r < readers; r++) {
+            threads.push_back(std::thread([&, r] {
+                unsigned long long seen = 0;
+                while (!done.load()) {
+                    if (exchange.LatestFrame() == seen) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    const SceneSnapshot* scene = exchange.Acquire();
+                    auto now = std::chrono::steady_clock::now();
+                    if (scene->frame < seen) backwards[r]++;
+                    if (scene->frame > seen) {
+                        latencies[r].push_back(std::chrono::duration<double>(now - stamps[scene->frame]).count());
+                        seen = scene->frame;
+                    }
+                    for (size_t i = 0; i < scene->cubes.size(); i++) {
+                        if (scene->cubes[i].randomEvents != scene->frame) {
+                            torn[r]++;
+                            break;
+                        }
+                    }
+                    exchange.Release(scene);
+                }
+            }));
+        }
+        for (int f = 1; f <= FRAMES; f++) {
+            SceneSnapshot& scene = exchange.BeginPublish();
+            scene.cubes = cubes;
+            for (int i = 0; i < CUBES; i++) scene.cubes[i].randomEvents = (unsigned long long)f;
+            stamps[f] = std::chrono::steady_clock::now();
+            exchange.Publish();
+            if (f % 4 == 0) std::this_thread::yield();
+        }
+        done.store(true);
+        for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+
+        std::vector<double> all;
+        long long tornTotal = 0, backwardsTotal = 0;
+        for (int r = 0; r < readers; r++) {
+            all.insert(all.end(), latencies[r].begin(), latencies[r].end());
+            tornTotal += torn[r];
+            backwardsTotal += backwards[r];
+        }
+        std::sort(all.begin(), all.end());
+        double p50 = all.empty() ? 0 : all[all.size() / 2];
+        double p99 = all.empty() ? 0 : all[all.size() * 99 / 100];
+        double worst = all.empty() ? 0 : all.back();
+        printf("%8d %10d %10zu %10.2f %10.2f %10.1f %8lld %10lld\n", readers, FRAMES, all.size(), p50 * 1e6, p99 * 1e6,
+               worst * 1e6, tornTotal, backwardsTotal);
+        ok = ok && tornTotal == 0 && backwardsTotal == 0;
+    }
+    if (std::thread::hardware_concurrency() < 2) {
+        printf("(one hardware thread: latencies are scheduler time slices, not the handoff itself)\n");
+    }
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// FrameScheduler pacing 60, 75, 144 and 240 Hz outputs on a simulated clock,
+// with and without a render stall, against the old 16 ms SetTimer loop, then
+// briefly on the real clock
+static int RunScheduleBenchmark(const BenchOptions& opts) {
+    const double RATES[] = { 60.0, 75.0, 144.0, 240.0 };
+    const size_t OUTPUTS = sizeof(RATES) / sizeof(RATES[0]);
+    const double SECONDS = 60.0;
+    const double WAKE_LATENCY = 50e-6, WAKE_JITTER = 150e-6;
+    const double RENDER_SECONDS = 0.5e-3;  // Per output rendered
+    const double STALL_AT = 10.0, STALL_SECONDS = 0.1;
+    std::vector<double> periods;
+    for (size_t o = 0; o < OUTPUTS; o++) periods.push_back(1.0 / RATES[o]);
+    bool ok = true;
+
+    printf("simulated clock: wakeups %.0f us late plus up to %.0f us jitter, %.1f ms to render an output, %.0f s\n",
+           WAKE_LATENCY * 1e6, WAKE_JITTER * 1e6, RENDER_SECONDS * 1e3, SECONDS);
+    for (int stall = 0; stall < 2; stall++) {
+        SimulatedSchedulerClock clock(WAKE_LATENCY, WAKE_JITTER, opts.seed);
+        FrameScheduler scheduler(clock);
+        scheduler.SetOutputs(periods);
+        std::vector<int> due;
+        bool stalled = false;
+        while (clock.Now() < SECONDS) {
+            scheduler.Wait(due);
+            clock.Advance(RENDER_SECONDS * due.size());
+            if (stall && !stalled && clock.Now() >= STALL_AT) {
+                clock.Advance(STALL_SECONDS);
+                stalled = true;
+            }
+        }
+        std::vector<MissedDeadline> missed;
+        scheduler.TakeMissed(missed);
+
+        printf("%s\n", stall ? "with one 100 ms stall at 10 s:" : "steady:");
+        printf("%8s %10s %10s %10s %14s %14s %8s\n", "Hz", "deadlines", "served", "missed", "mean late us", "max late us",
+               "logged");
+        for (size_t o = 0; o < OUTPUTS; o++) {
+            long long deadlines = (long long)floor(clock.Now() / periods[o] + 1e-9);
+            long long served = scheduler.FramesServed(o), lost = scheduler.FramesMissed(o);
+            long long logged = 0;
+            for (size_t m = 0; m < missed.size(); m++) logged += missed[m].output == (int)o ? missed[m].frames : 0;
+            printf("%8.0f %10lld %10lld %10lld %14.1f %14.1f %8lld\n", RATES[o], deadlines, served, lost,
+                   scheduler.MeanLateness(o) * 1e6, scheduler.MaxLateness(o) * 1e6, logged);
+
+            // Every deadline is served or missed, except possibly the one in flight
+            bool accounted = served + lost >= deadlines - 1 && served + lost <= deadlines + 1;
+            if (stall) {
+                long long expected = (long long)floor(STALL_SECONDS / periods[o]);
+                ok = ok && accounted && lost >= expected - 1 && lost <= expected + 1 && logged == lost;
+            } else {
+                ok = ok && accounted && lost == 0 && scheduler.MaxLateness(o) < WAKE_LATENCY + WAKE_JITTER + OUTPUTS * RENDER_SECONDS;
+            }
+        }
+    }
+
+    // The old loop: SetTimer(16) on the default 15.625 ms system tick fires on
+    // the first tick at least 16 ms after the last, and redraws every output
+    const double TICK = 1.0 / 64.0;
+    double fire = 0, legacyFrames = 0;
+    while (fire < SECONDS) {
+        fire = ceil((fire + 0.016) / TICK) * TICK;
+        legacyFrames++;
+    }
+    printf("old SetTimer(16) loop: a frame every %.2f ms on every output, %.1f frames/sec\n", SECONDS / legacyFrames * 1e3,
+           legacyFrames / SECONDS);
+
+    // Real clock, nothing rendered: what this machine's sleeps look like
+    SteadySchedulerClock steady;
+    FrameScheduler real(steady);
+    std::vector<double> realPeriods(periods.begin(), periods.begin() + 3);
+    real.SetOutputs(realPeriods);
+    std::vector<int> due;
+    double end = steady.Now() + 1.0;
+    while (steady.Now() < end) real.Wait(due);
+    printf("real steady clock, 1 s:");
+    for (size_t o = 0; o < realPeriods.size(); o++) {
+        printf(" %.0f Hz %lld served %lld missed, %.0f/%.0f us mean/max late;", RATES[o], real.FramesServed(o),
+               real.FramesMissed(o), real.MeanLateness(o) * 1e6, real.MaxLateness(o) * 1e6);
+    }
+    printf("\n%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// Render command lists: the software backend must draw exactly what the
+// direct calls do, then build and replay cost with nothing drawn
+static int RunCommandsBenchmark(const BenchOptions& opts) {
+    bool ok = true;
+
+    // A 2x2 wall, one list per frame replayed on every output, against each
+    // output drawn straight from the cubes
+    DisplayTopology topology;
+    std::vector<Cube> cubes;
+    MakeWall(2, 2, 1920, 1080, 50, opts, topology, cubes);
+    for (size_t i = 0; i < cubes.size(); i += 7) {
+        cubes[i].celebratingCorner = true;
+        cubes[i].celebrationTimer = (int)(i % CELEBRATION_DURATION);
+    }
+    RenderCommandList commands;
+    BuildCubeFrame(commands, &cubes[0], cubes.size(), opts.cubeSize, false);
+    std::vector<SoftwareFramebuffer> reference;
+    std::vector<std::vector<unsigned int> > referencePresent;
+    RenderOutputsSerially(topology, cubes, opts.cubeSize, reference, referencePresent);
+    SoftwareRenderBackend software;
+    long long different = 0;
+    for (size_t o = 0; o < topology.OutputCount(); o++) {
+        software.Execute(commands, topology.Output(o));
+        for (int y = 0; y < reference[o].Height(); y++) {
+            different += memcmp(software.Framebuffer().Row(y), reference[o].Row(y), reference[o].Width() * sizeof(unsigned int)) != 0;
+        }
+    }
+
+    // Mirror mode: the one cube on every output, wherever it is
+    BuildCubeFrame(commands, &cubes[0], 1, opts.cubeSize, true);
+    SoftwareFramebuffer mirrored;
+    for (size_t o = 0; o < topology.OutputCount(); o++) {
+        software.Execute(commands, topology.Output(o));
+        RenderSceneSoftware(mirrored, topology.Output(o), cubes[0], opts.cubeSize, true);
+        for (int y = 0; y < mirrored.Height(); y++) {
+            different += memcmp(software.Framebuffer().Row(y), mirrored.Row(y), mirrored.Width() * sizeof(unsigned int)) != 0;
+        }
+    }
+    printf("software backend on a 2x2 wall, %zu cubes, and mirrored: %lld rows different from direct rendering\n",
+           cubes.size(), different);
+    ok = ok && different == 0;
+
+    // The recorder must see each cube on exactly the outputs the topology
+    // says it touches, and the same frame must fingerprint the same
+    BuildCubeFrame(commands, &cubes[0], cubes.size(), opts.cubeSize, false);
+    RecordingRenderBackend recorder, again;
+    for (size_t o = 0; o < topology.OutputCount(); o++) recorder.Execute(commands, topology.Output(o));
+    for (size_t o = 0; o < topology.OutputCount(); o++) again.Execute(commands, topology.Output(o));
+    long long touching = 0;
+    std::vector<int> touched;
+    for (size_t i = 0; i < cubes.size(); i++) {
+        topology.OutputsTouching(cubes[i].x, cubes[i].y, GetCubeSizeInPixels(opts.cubeSize), touched);
+        touching += (long long)touched.size();
+    }
+    long long reached = recorder.Commands(RENDER_DRAW_MESH) - recorder.DrawsCulled();
+    printf("recording backend: %lld draws reach an output, topology says %lld; fingerprint %016llx, %s on replay\n",
+           reached, touching, recorder.Hash(), recorder.Hash() == again.Hash() ? "same" : "DIFFERENT");
+    ok = ok && reached == touching && recorder.Hash() == again.Hash();
+
+    // Cost with nothing drawn: describing the cubes once per frame, then
+    // walking the list once per output
+    const int WALLS[3][2] = { { 1, 1 }, { 2, 2 }, { 4, 4 } };
+    const size_t PER_OUTPUT[3] = { 1, 100, 10000 };
+    printf("%8s %10s %12s %14s %16s %14s\n", "outputs", "cubes", "commands", "build ns/cube", "replay us/output",
+           "reached/output");
+    for (int w = 0; w < 3; w++) {
+        for (int c = 0; c < 3; c++) {
+            MakeWall(WALLS[w][0], WALLS[w][1], 1920, 1080, PER_OUTPUT[c], opts, topology, cubes);
+            int frames = 0;
+            double buildSeconds = 0, replaySeconds = 0;
+            RecordingRenderBackend timed;
+            auto begin = std::chrono::steady_clock::now();
+            while (frames < 3 || SecondsSince(begin) < 0.2) {
+                auto start = std::chrono::steady_clock::now();
+                BuildCubeFrame(commands, &cubes[0], cubes.size(), opts.cubeSize, false);
+                buildSeconds += SecondsSince(start);
+                start = std::chrono::steady_clock::now();
+                for (size_t o = 0; o < topology.OutputCount(); o++) timed.Execute(commands, topology.Output(o));
+                replaySeconds += SecondsSince(start);
+                frames++;
+            }
+            double outputs = (double)topology.OutputCount();
+            printf("%8zu %10zu %12zu %14.1f %16.2f %14.1f\n", topology.OutputCount(), cubes.size(), commands.Size(),
+                   buildSeconds / frames / cubes.size() * 1e9, replaySeconds / frames / outputs * 1e6,
+                   (timed.Commands(RENDER_DRAW_MESH) - timed.DrawsCulled()) / (frames * outputs));
+        }
+    }
+
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// Binned replays against each output testing every draw, with the cube count
+// fixed and the outputs multiplying
+static int RunBinningBenchmark(const BenchOptions& opts) {
+    bool ok = true;
+
+    // The software backend draws the same frames either way
+    DisplayTopology topology;
+    std::vector<Cube> cubes;
+    MakeWall(4, 4, 480, 270, 50, opts, topology, cubes);
+    RenderCommandList tested, binned;
+    BuildCubeFrame(tested, &cubes[0], cubes.size(), opts.cubeSize, false);
+    BuildCubeFrame(binned, &cubes[0], cubes.size(), opts.cubeSize, false);
+    binned.Bin(topology);
+    SoftwareRenderBackend testedSoftware, binnedSoftware;
+    long long different = 0;
+    for (size_t o = 0; o < topology.OutputCount(); o++) {
+        testedSoftware.Execute(tested, topology.Output(o));
+        binnedSoftware.Execute(binned, topology.Output(o));
+        for (int y = 0; y < topology.Output(o).height; y++) {
+            different += memcmp(testedSoftware.Framebuffer().Row(y), binnedSoftware.Framebuffer().Row(y),
+                                topology.Output(o).width * sizeof(unsigned int)) != 0;
+        }
+    }
+    printf("software backend on a 4x4 wall, %zu cubes: %lld rows different binned\n", cubes.size(), different);
+    ok = ok && different == 0;
+
+    const int WALLS[4][2] = { { 1, 1 }, { 4, 4 }, { 10, 10 }, { 40, 25 } };
+    const size_t CUBES = 10000;
+    printf("%8s %8s %14s %14s %10s %14s %14s %10s\n", "outputs", "cubes", "tested ms", "binned ms", "bin ms",
+           "tested visits", "binned visits", "same");
+    for (int w = 0; w < 4; w++) {
+        size_t outputs = (size_t)WALLS[w][0] * WALLS[w][1];
+        MakeWall(WALLS[w][0], WALLS[w][1], 1920, 1080, (CUBES + outputs - 1) / outputs, opts, topology, cubes);
+        cubes.resize(CUBES);
+        BuildCubeFrame(tested, &cubes[0], cubes.size(), opts.cubeSize, false);
+        BuildCubeFrame(binned, &cubes[0], cubes.size(), opts.cubeSize, false);
+
+        RecordingRenderBackend testedRecorder, binnedRecorder;
+        int testedFrames = 0, binnedFrames = 0;
+        double binSeconds = 0;
+        auto begin = std::chrono::steady_clock::now();
+        while (testedFrames < 2 || SecondsSince(begin) < 0.2) {
+            for (size_t o = 0; o < topology.OutputCount(); o++) testedRecorder.Execute(tested, topology.Output(o));
+            testedFrames++;
+        }
+        double testedSeconds = SecondsSince(begin) / testedFrames;
+        begin = std::chrono::steady_clock::now();
+        while (binnedFrames < 2 || SecondsSince(begin) < 0.2) {
+            auto start = std::chrono::steady_clock::now();
+            binned.Bin(topology);
+            binSeconds += SecondsSince(start);
+            for (size_t o = 0; o < topology.OutputCount(); o++) binnedRecorder.Execute(binned, topology.Output(o));
+            binnedFrames++;
+        }
+        double binnedSeconds = SecondsSince(begin) / binnedFrames;
+
+        // One frame of each, recorded again, must match replay for replay
+        RecordingRenderBackend testedOnce, binnedOnce;
+        for (size_t o = 0; o < topology.OutputCount(); o++) {
+            testedOnce.Execute(tested, topology.Output(o));
+            binnedOnce.Execute(binned, topology.Output(o));
+        }
+        bool same = testedOnce.Hash() == binnedOnce.Hash() && testedOnce.DrawsCulled() == binnedOnce.DrawsCulled();
+        ok = ok && same;
+        printf("%8zu %8zu %14.3f %14.3f %10.3f %14lld %14lld %10s\n", topology.OutputCount(), cubes.size(),
+               testedSeconds * 1e3, binnedSeconds * 1e3, binSeconds * 1e3 / binnedFrames,
+               testedOnce.DrawsVisited(), binnedOnce.DrawsVisited(), same ? "yes" : "NO");
+    }
+
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// Pixels the exact frame covers; of those and the impostor's, how many only
+// one of them covers, and how many both cover in different colors
+static void CompareImpostor(const SoftwareFramebuffer& exact, const SoftwareFramebuffer& impostor, long long& covered,
+                            long long& outline, long long& shade) {
+    covered = outline = shade = 0;
+    for (int y = 0; y < exact.Height(); y++) {
+        const unsigned int* rowA = exact.Row(y);
+        const unsigned int* rowB = impostor.Row(y);
+        for (int x = 0; x < exact.Width(); x++) {
+            bool inA = rowA[x] != RASTER_OPAQUE, inB = rowB[x] != RASTER_OPAQUE;
+            covered += inA;
+            outline += inA != inB;
+            shade += inA && inB && rowA[x] != rowB[x];
+        }
+    }
+}
+
+static bool WriteBytes(const char* path, const std::vector<unsigned char>& bytes) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool written = fwrite(&bytes[0], 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+// Sprite atlases: build, cache and reload, damaged caches refused, error
+// against exact rendering, and the cost of a frame against rasterizing it
+static int RunImpostorBenchmark(const BenchOptions& opts) {
+    bool ok = true;
+    const char* PATH = "BouncingCubeBench.atlas";
+    DisplayOutput output = MakeOutput(opts.width, opts.height);
+    CubeSpriteKey key = { opts.cubeSize, opts.height, SPRITE_GRID };
+
+    CubeSpriteAtlas atlas;
+    auto begin = std::chrono::steady_clock::now();
+    atlas.Build(key);
+    double buildSeconds = SecondsSince(begin);
+    printf("atlas for cube size %.3f, %d px high: %zu sprites up to %dx%d px, %zu runs, %.0f KB, built in %.0f ms\n",
+           opts.cubeSize, opts.height, atlas.SpriteCount(), atlas.SpriteSize(), atlas.SpriteSize(), atlas.RunCount(),
+           atlas.Bytes() / 1024.0, buildSeconds * 1e3);
+
+    begin = std::chrono::steady_clock::now();
+    bool saved = atlas.Save(PATH);
+    double saveSeconds = SecondsSince(begin);
+    CubeSpriteAtlas loaded;
+    begin = std::chrono::steady_clock::now();
+    bool read = loaded.Load(PATH, key);
+    double loadSeconds = SecondsSince(begin);
+
+    // Saved again, the loaded atlas must write the same bytes
+    const char* OTHER_PATH = "BouncingCubeBench.other.atlas";
+    std::vector<unsigned char> bytes, again;
+    bool same = read && loaded.Save(OTHER_PATH) && ReadReplayFile(PATH, bytes) && ReadReplayFile(OTHER_PATH, again) &&
+                !bytes.empty() && bytes == again;
+    printf("cache file: saved %s in %.1f ms, loaded %s in %.1f ms, %s\n", saved ? "yes" : "NO", saveSeconds * 1e3,
+           read ? "yes" : "NO", loadSeconds * 1e3, same ? "same atlas" : "DIFFERENT");
+    ok = ok && saved && same;
+
+    // Another key, a flipped byte or a short file must all be refused
+    CubeSpriteKey otherKey = key;
+    otherKey.outputHeight = key.outputHeight + 1;
+    bool refusedKey = !loaded.Load(PATH, otherKey);
+    bool refusedDamaged = false, refusedShort = false;
+    if (same) {
+        std::vector<unsigned char> damaged = bytes;
+        damaged[damaged.size() / 2] ^= 0x10;
+        refusedDamaged = WriteBytes(OTHER_PATH, damaged) && !loaded.Load(OTHER_PATH, key);
+        damaged.assign(bytes.begin(), bytes.end() - 8);
+        refusedShort = WriteBytes(OTHER_PATH, damaged) && !loaded.Load(OTHER_PATH, key);
+    }
+    remove(OTHER_PATH);
+    printf("refused: other key %s, damaged %s, truncated %s\n", refusedKey ? "yes" : "NO", refusedDamaged ? "yes" : "NO",
+           refusedShort ? "yes" : "NO");
+    ok = ok && refusedKey && refusedDamaged && refusedShort;
+
+    // In the background, first with no cache to load, then with the one it wrote
+    remove(PATH);
+    for (int pass = 0; pass < 2; pass++) {
+        CubeSpriteAtlasLoader loader;
+        begin = std::chrono::steady_clock::now();
+        loader.Start(key, PATH);
+        double startSeconds = SecondsSince(begin);
+        while (!loader.Ready()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        printf("loader, %s: Start returned in %.3f ms, ready after %.0f ms, %s\n", pass == 0 ? "cold" : "warm",
+               startSeconds * 1e3, SecondsSince(begin) * 1e3, loader.LoadedFromCache() ? "from cache" : "built");
+        ok = ok && loader.LoadedFromCache() == (pass == 1) && loader.Ready()->RunCount() == atlas.RunCount();
+    }
+    remove(PATH);
+
+    // Error against exact rendering, the cube in the middle of the output
+    // (orientation steps only) and anywhere on it (plus perspective). One
+    // impostor backend draws every pose, so its partial clears are checked too.
+    const int POSES = 300;
+    RenderCommandList commands;
+    SoftwareRenderBackend exact;
+    ImpostorRenderBackend impostor;
+    impostor.SetAtlas(&atlas);
+    for (int place = 0; place < 2; place++) {
+        double outlineSum = 0, shadeSum = 0, worstOutline = 0;
+        for (int p = 0; p < POSES; p++) {
+            float x = output.width * 0.5f, y = output.height * 0.5f;
+            if (place == 1) {
+                x = (float)((p * 7919) % output.width);
+                y = (float)((p * 104729) % output.height);
+            }
+            Cube cube;
+            ResetCube(cube, x, y, opts.seed, (unsigned int)p);
+            for (int r = 0; r < (p * 37) % 400; r++) RotateCube(cube);
+            BuildCubeFrame(commands, &cube, 1, opts.cubeSize, false);
+            exact.Execute(commands, output);
+            impostor.Execute(commands, output);
+            long long covered, outline, shade;
+            CompareImpostor(exact.Framebuffer(), impostor.Framebuffer(), covered, outline, shade);
+            double outlineShare = covered ? (double)outline / covered : 0.0;
+            outlineSum += outlineShare;
+            shadeSum += covered ? (double)shade / covered : 0.0;
+            worstOutline = std::max(worstOutline, outlineShare);
+        }
+        printf("%s: %d poses, outline off on %.2f%% of the cube's pixels (worst %.2f%%), shade off on %.2f%%\n",
+               place == 0 ? "middle of the output" : "anywhere on it", POSES, outlineSum / POSES * 100.0,
+               worstOutline * 100.0, shadeSum / POSES * 100.0);
+        ok = ok && outlineSum / POSES < (place == 0 ? 0.05 : 0.075) && shadeSum / POSES < 0.05;
+    }
+
+    // A celebrating cube has no sprite and must come out exactly
+    Cube pulsing;
+    ResetCube(pulsing, output.width * 0.3f, output.height * 0.6f, opts.seed, 0);
+    pulsing.celebratingCorner = true;
+    pulsing.celebrationTimer = 5;
+    BuildCubeFrame(commands, &pulsing, 1, opts.cubeSize, false);
+    long long exactBefore = impostor.ExactDraws();
+    exact.Execute(commands, output);
+    impostor.Execute(commands, output);
+    long long rows = 0;
+    for (int y = 0; y < output.height; y++) {
+        rows += memcmp(exact.Framebuffer().Row(y), impostor.Framebuffer().Row(y), output.width * sizeof(unsigned int)) != 0;
+    }
+    printf("celebrating cube: %s, %lld rows different\n", impostor.ExactDraws() > exactBefore ? "rasterized" : "NOT rasterized", rows);
+    ok = ok && impostor.ExactDraws() > exactBefore && rows == 0;
+
+    // A frame of one cube crossing the output: rasterized whole, as sprites
+    // redrawing only what changed, and the bare copy of those changes a
+    // present would make. Each runs on its own so neither evicts the other's
+    // framebuffer from the cache.
+    const int FRAMES = 600;
+    std::vector<RenderCommandList> moving(FRAMES);
+    CubeSettings settings = { opts.cubeSize, false };
+    Cube cube;
+    ResetCube(cube, output.width * 0.5f, output.height * 0.5f, opts.seed, 1);
+    for (int f = 0; f < FRAMES; f++) {
+        StepCube(cube, output.bounds, settings);
+        BuildCubeFrame(moving[f], &cube, 1, opts.cubeSize, false);
+    }
+    begin = std::chrono::steady_clock::now();
+    for (int f = 0; f < FRAMES; f++) exact.Execute(moving[f], output);
+    double exactSeconds = SecondsSince(begin);
+    double impostorSeconds = 0, copySeconds = 0;
+    long long dirtyPixels = 0;
+    std::vector<unsigned int> copy((size_t)output.width * output.height);
+    for (int f = 0; f < FRAMES; f++) {
+        auto start = std::chrono::steady_clock::now();
+        impostor.Execute(moving[f], output);
+        impostorSeconds += SecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        const std::vector<RasterRect>& dirty = impostor.DirtyRects();
+        for (size_t d = 0; d < dirty.size(); d++) {
+            for (int y = dirty[d].top; y < dirty[d].bottom; y++) {
+                memcpy(&copy[(size_t)y * output.width + dirty[d].left], impostor.Framebuffer().Row(y) + dirty[d].left,
+                       (dirty[d].right - dirty[d].left) * sizeof(unsigned int));
+            }
+            dirtyPixels += (long long)(dirty[d].right - dirty[d].left) * (dirty[d].bottom - dirty[d].top);
+        }
+        copySeconds += SecondsSince(start);
+    }
+    int frames = FRAMES;
+    printf("%dx%d, one moving cube, per frame: rasterized %.1f us, sprite %.1f us, copying its %lld changed pixels %.1f us\n",
+           output.width, output.height, exactSeconds / frames * 1e6, impostorSeconds / frames * 1e6, dirtyPixels / frames,
+           copySeconds / frames * 1e6);
+
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+#if defined(CUBE_HEADLESS_GL)
+// Pixels where any channel differs by more than `tolerance`
+static long long DifferentPixels(const SoftwareFramebuffer& a, const SoftwareFramebuffer& b, int tolerance) {
+    long long different = 0;
+    for (int y = 0; y < a.Height(); y++) {
+        const unsigned int* rowA = a.Row(y);
+        const unsigned int* rowB = b.Row(y);
+        for (int x = 0; x < a.Width(); x++) {
+            different += abs(CUBE_R(rowA[x]) - CUBE_R(rowB[x])) > tolerance || abs(CUBE_G(rowA[x]) - CUBE_G(rowB[x])) > tolerance ||
+                         abs(CUBE_B(rowA[x]) - CUBE_B(rowB[x])) > tolerance;
+        }
+    }
+    return different;
+}
+
+// Immediate mode and the retained mesh on a headless context: golden frames
+// checked against each other and the software rasterizer, then submit and
+// frame time as the cube count grows
+static int RunGLBenchmark(const BenchOptions& opts) {
+    HeadlessGLContext gl;
+    if (!gl.Create(opts.width, opts.height)) {
+        printf("no headless GL context: %s\n", gl.Error());
+        return 1;
+    }
+    printf("GL: %s, %s\n", gl.Renderer(), gl.Version());
+    SetupCubeLighting();
+    ImmediateGLBackend immediateBackend;
+    RetainedGLBackend retainedBackend;
+    InstancedGLBackend instancedBackend;
+    if (!retainedBackend.Create(HeadlessGLContext::Loader(), opts.cubeSize)) {
+        printf("no vertex buffer objects\n");
+        return 1;
+    }
+    if (!instancedBackend.Create(HeadlessGLContext::Loader(), opts.cubeSize)) {
+        printf("no GLSL or instanced arrays\n");
+        return 1;
+    }
+    DisplayOutput output = MakeOutput(opts.width, opts.height);
+    bool ok = true;
+
+    // Poses all over the output, some hanging off its edges, every fourth one
+    // celebrating so the pulse scale and color are covered
+    const int POSES = 200;
+    SoftwareFramebuffer immediate, retained, instanced, software;
+    RenderCommandList commands;
+    long long retainedDifferent = 0, instancedDifferent = 0, softwareDifferent = 0, covered = 0;
+    int framesDifferent = 0;
+    Cube cube;
+    ResetCube(cube, 0.0f, 0.0f, opts.seed, 0);
+    for (int p = 0; p < POSES; p++) {
+        for (int r = 0; r < 7; r++) RotateCube(cube);
+        cube.x = (float)((p * 7919) % (output.width + 100)) - 50.0f;
+        cube.y = (float)((p * 104729) % (output.height + 100)) - 50.0f;
+        cube.celebratingCorner = p % 4 == 3;
+        cube.celebrationTimer = p % CELEBRATION_DURATION;
+
+        BuildCubeFrame(commands, &cube, 1, opts.cubeSize, true);
+        immediateBackend.Execute(commands, output);
+        gl.ReadPixels(immediate);
+        retainedBackend.Execute(commands, output);
+        gl.ReadPixels(retained);
+        instancedBackend.Execute(commands, output);
+        gl.ReadPixels(instanced);
+        RenderSceneSoftware(software, output, cube, opts.cubeSize, true);
+
+        long long different = DifferentPixels(immediate, retained, 0);
+        retainedDifferent += different;
+        framesDifferent += different != 0;
+        instancedDifferent += DifferentPixels(immediate, instanced, 2);
+        softwareDifferent += DifferentPixels(retained, software, 2);
+        covered += CoveredPixels(retained);
+        if (p == POSES / 2 && !opts.file.empty() && !WriteFramebufferPPM(opts.file.c_str(), retained)) {
+            printf("could not write %s\n", opts.file.c_str());
+            ok = false;
+        }
+    }
+    double softwareShare = (double)softwareDifferent / fmax((double)covered, 1.0);
+    double instancedShare = (double)instancedDifferent / fmax((double)covered, 1.0);
+    printf("golden frames, %d poses: retained vs immediate %lld pixels different in %d frames; "
+           "instanced vs immediate %.2f%% and software rasterizer vs retained %.2f%% of cube pixels off by more than 2\n",
+           POSES, retainedDifferent, framesDifferent, instancedShare * 100, softwareShare * 100);
+    ok = ok && retainedDifferent == 0 && instancedShare < 0.02 && softwareShare < 0.02;
+
+    // Same cubes, same pixels for every path: what differs is how many GL
+    // calls it takes to send them. Small cubes, so filling them does not
+    // drown that out.
+    float crowdSize = opts.cubeSize / 5;
+    const size_t COUNTS[] = { 1, 10, 100, 1000, 10000 };
+    printf("%8s %20s %16s %14s %16s %14s %16s %14s\n", "cubes", "draw calls", "immediate sub us", "immediate ms",
+           "retained sub us", "retained ms", "instanced sub us", "instanced ms");
+    for (size_t c = 0; c < sizeof(COUNTS) / sizeof(COUNTS[0]); c++) {
+        std::vector<Cube> cubes(COUNTS[c]);
+        for (size_t i = 0; i < cubes.size(); i++) {
+            ResetCube(cubes[i], (float)((i * 7919) % output.width), (float)((i * 104729) % output.height), opts.seed,
+                      (unsigned int)i);
+        }
+        BuildCubeFrame(commands, &cubes[0], cubes.size(), crowdSize, false);
+        double submit[3], frame[3];
+        for (int path = 0; path < 3; path++) {
+            int frames = 0;
+            double submitted = 0;
+            auto begin = std::chrono::steady_clock::now();
+            while (frames < 3 || SecondsSince(begin) < 0.3) {
+                auto start = std::chrono::steady_clock::now();
+                if (path == 0) {
+                    immediateBackend.Execute(commands, output);
+                } else if (path == 1) {
+                    retainedBackend.Execute(commands, output);
+                } else {
+                    instancedBackend.Execute(commands, output);
+                }
+                submitted += SecondsSince(start);
+                gl.Finish();
+                frames++;
+            }
+            submit[path] = submitted / frames;
+            frame[path] = SecondsSince(begin) / frames;
+        }
+        // A glBegin per cube, a glDrawElements per cube, one instanced draw
+        printf("%8zu %8zu / %5zu / %-3d %16.1f %14.2f %16.1f %14.2f %16.1f %14.2f\n", COUNTS[c], COUNTS[c], COUNTS[c], 1,
+               submit[0] * 1e6, frame[0] * 1e3, submit[1] * 1e6, frame[1] * 1e3, submit[2] * 1e6, frame[2] * 1e3);
+    }
+
+    instancedBackend.Destroy();
+    retainedBackend.Destroy();
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+#else
+static int RunGLBenchmark(const BenchOptions& opts) {
+    printf("built without the headless GL host (CUBE_ENABLE_HEADLESS_GL, needs EGL, GL and GLU)\n");
+    return 1;
+}
+#endif
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    ParseBenchArgs(argc, argv, opts);
+    printf("BouncingCubeBench: %dx%d bounds, cube size %.3f, seed %llu\n", opts.width, opts.height, opts.cubeSize, opts.seed);
+
+    if (opts.mode == "step") return RunStepBenchmark(opts);
+    if (opts.mode == "soa") return RunSoABenchmark(opts);
+    if (opts.mode == "toi") return RunToiBenchmark(opts);
+    if (opts.mode == "orient") return RunOrientBenchmark(opts);
+    if (opts.mode == "corner") return RunCornerBenchmark(opts);
+    if (opts.mode == "clock") return RunClockBenchmark(opts);
+    if (opts.mode == "parallel") return RunParallelBenchmark(opts);
+    if (opts.mode == "desktop") return RunDesktopBenchmark(opts);
+    if (opts.mode == "topology") return RunTopologyBenchmark(opts);
+    if (opts.mode == "snapshot") return RunSnapshotBenchmark(opts);
+    if (opts.mode == "replay") return RunReplayBenchmark(opts);
+    if (opts.mode == "raster") return RunRasterBenchmark(opts);
+    if (opts.mode == "tiles") return RunTilesBenchmark(opts);
+    if (opts.mode == "dirty") return RunDirtyBenchmark(opts);
+    if (opts.mode == "mirror") return RunMirrorBenchmark(opts);
+    if (opts.mode == "skip") return RunSkipBenchmark(opts);
+    if (opts.mode == "threads") return RunThreadsBenchmark(opts);
+    if (opts.mode == "exchange") return RunExchangeBenchmark(opts);
+    if (opts.mode == "schedule") return RunScheduleBenchmark(opts);
+    if (opts.mode == "commands") return RunCommandsBenchmark(opts);
+    if (opts.mode == "binning") return RunBinningBenchmark(opts);
+    if (opts.mode == "impostor") return RunImpostorBenchmark(opts);
+    if (opts.mode == "gl") return RunGLBenchmark(opts);
+
+    fprintf(stderr, "Unknown mode: %s\n", opts.mode.c_str());
+    return 1;
+}
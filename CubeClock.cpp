@@ -0,0 +1,44 @@
+#include "CubeClock.h"
+
+void InitFixedStepClock(FixedStepClock& clock, int stepsPerSecond) {
+    clock.stepSeconds = 1.0 / stepsPerSecond;
+    clock.accumulator = 0.0;
+}
+
+long long TickFixedStep(FixedStepClock& clock, double elapsedSeconds) {
+    if (elapsedSeconds > 0) clock.accumulator += elapsedSeconds;
+
+    long long steps = (long long)(clock.accumulator / clock.stepSeconds);
+    clock.accumulator -= steps * clock.stepSeconds;
+
+    // Rounding can leave the remainder a hair outside [0, step)
+    if (clock.accumulator < 0) clock.accumulator = 0;
+    if (clock.accumulator >= clock.stepSeconds) {
+        clock.accumulator -= clock.stepSeconds;
+        steps++;
+    }
+    return steps;
+}
+
+float FixedStepAlpha(const FixedStepClock& clock) {
+    return (float)(clock.accumulator / clock.stepSeconds);
+}
+
+void InterpolateCube(const Cube& previous, const Cube& current, float alpha, Cube& out) {
+    out = current;
+    out.x = previous.x + (current.x - previous.x) * alpha;
+    out.y = previous.y + (current.y - previous.y) * alpha;
+    out.z = previous.z + (current.z - previous.z) * alpha;
+
+    // Consecutive orientations are a few degrees apart, so a normalized lerp is
+    // indistinguishable from slerp. q and -q are the same rotation; flip so the
+    // blend takes the short way round.
+    const float* a = previous.orientation;
+    const float* b = current.orientation;
+    float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    float sign = dot < 0 ? -1.0f : 1.0f;
+    for (int i = 0; i < 4; i++) {
+        out.orientation[i] = a[i] * sign * (1.0f - alpha) + b[i] * alpha;
+    }
+    NormalizeQuaternion(out.orientation);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CubeCore.h"
+
+// Fixed-timestep clock. Velocities are in pixels per step and celebrations count
+// steps, so the simulation has to advance at exactly PHYSICS_STEPS_PER_SECOND no
+// matter how often the host gets to run. Hosts feed real elapsed time into the
+// accumulator, run the whole steps it hands back, and render the state blended
+// FixedStepAlpha() of the way from the previous step to the current one.
+
+const int PHYSICS_STEPS_PER_SECOND = 60;
+
+struct FixedStepClock {
+    double stepSeconds;
+    double accumulator;  // Elapsed time not yet simulated, < stepSeconds between ticks
+};
+
+void InitFixedStepClock(FixedStepClock& clock, int stepsPerSecond);
+
+// Add elapsed wall-clock time and return how many fixed steps are now due
+long long TickFixedStep(FixedStepClock& clock, double elapsedSeconds);
+
+// How far presentation time is past the last simulated step, in [0, 1)
+float FixedStepAlpha(const FixedStepClock& clock);
+
+// Render state `alpha` of the way from `previous` to `current`, the cube one
+// step apart. Position is blended linearly and orientation along the shorter
+// arc; everything else comes from `current`.
+void InterpolateCube(const Cube& previous, const Cube& current, float alpha, Cube& out);
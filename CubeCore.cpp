@@ -0,0 +1,225 @@
+#include "CubeCore.h"
+#include <cmath>
+
+void MultiplyMatrix4x4(float result[16], const float a[16], const float b[16]) {
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            result[i * 4 + j] = 0;
+            for (int k = 0; k < 4; k++) {
+                result[i * 4 + j] += a[i * 4 + k] * b[k * 4 + j];
+            }
+        }
+    }
+}
+
+void CreateRotationMatrix(float matrix[16], float angle, float x, float y, float z) {
+    float c = cos(angle * 3.14159f / 180.0f);
+    float s = sin(angle * 3.14159f / 180.0f);
+    float ic = 1.0f - c;
+
+    matrix[0] = c + x*x*ic;     matrix[1] = x*y*ic - z*s;   matrix[2] = x*z*ic + y*s;   matrix[3] = 0;
+    matrix[4] = y*x*ic + z*s;   matrix[5] = c + y*y*ic;     matrix[6] = y*z*ic - x*s;   matrix[7] = 0;
+    matrix[8] = z*x*ic - y*s;   matrix[9] = z*y*ic + x*s;   matrix[10] = c + z*z*ic;    matrix[11] = 0;
+    matrix[12] = 0;             matrix[13] = 0;             matrix[14] = 0;             matrix[15] = 1;
+}
+
+void CreateRotationQuaternion(float q[4], float angle, float x, float y, float z) {
+    float halfAngle = angle * 3.14159f / 360.0f;
+    float s = sin(halfAngle);
+    q[0] = cos(halfAngle);
+    q[1] = x * s;
+    q[2] = y * s;
+    q[3] = z * s;
+}
+
+void MultiplyQuaternion(float result[4], const float a[4], const float b[4]) {
+    float w = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+    float x = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+    float y = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+    float z = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+    result[0] = w;
+    result[1] = x;
+    result[2] = y;
+    result[3] = z;
+}
+
+void NormalizeQuaternion(float q[4]) {
+    float length = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (length > 0.0f) {
+        float inv = 1.0f / length;
+        q[0] *= inv;
+        q[1] *= inv;
+        q[2] *= inv;
+        q[3] *= inv;
+    }
+}
+
+void QuaternionToMatrix(float matrix[16], const float q[4]) {
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+    float xx = x * x, yy = y * y, zz = z * z;
+    float xy = x * y, xz = x * z, yz = y * z;
+    float wx = w * x, wy = w * y, wz = w * z;
+
+    matrix[0] = 1 - 2 * (yy + zz);  matrix[1] = 2 * (xy - wz);      matrix[2] = 2 * (xz + wy);      matrix[3] = 0;
+    matrix[4] = 2 * (xy + wz);      matrix[5] = 1 - 2 * (xx + zz);  matrix[6] = 2 * (yz - wx);      matrix[7] = 0;
+    matrix[8] = 2 * (xz - wy);      matrix[9] = 2 * (yz + wx);      matrix[10] = 1 - 2 * (xx + yy); matrix[11] = 0;
+    matrix[12] = 0;                 matrix[13] = 0;                 matrix[14] = 0;                 matrix[15] = 1;
+}
+
+void GetCubeRotationMatrix(const Cube& cube, float matrix[16]) {
+    QuaternionToMatrix(matrix, cube.orientation);
+}
+
+void UpdateCubeSpin(Cube& cube) {
+    CreateRotationQuaternion(cube.spin, cube.rotationSpeed, cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ);
+}
+
+void RotateCube(Cube& cube) {
+    float rotated[4];
+    MultiplyQuaternion(rotated, cube.spin, cube.orientation);
+    cube.orientation[0] = rotated[0];
+    cube.orientation[1] = rotated[1];
+    cube.orientation[2] = rotated[2];
+    cube.orientation[3] = rotated[3];
+
+    if (++cube.stepsSinceNormalize >= ORIENTATION_NORMALIZE_INTERVAL) {
+        NormalizeQuaternion(cube.orientation);
+        cube.stepsSinceNormalize = 0;
+    }
+}
+
+float GetCubeSizeInPixels(float cubeSize) {
+    return cubeSize * 500.0f;  // Scale factor to convert to reasonable pixel size
+}
+
+// Random rotation axis (normalized) and a signed speed in [0.5, 0.5 + speedRange]
+static void PickRotation(float& axisX, float& axisY, float& axisZ, float& rotationSpeed, float speedRange, CubeRandom& rng) {
+    float rx = CubeRandomUnit(rng) * 2.0f - 1.0f;
+    float ry = CubeRandomUnit(rng) * 2.0f - 1.0f;
+    float rz = CubeRandomUnit(rng) * 2.0f - 1.0f;
+    float axisLength = sqrt(rx * rx + ry * ry + rz * rz);
+    axisX = rx / axisLength;
+    axisY = ry / axisLength;
+    axisZ = rz / axisLength;
+    rotationSpeed = ((CubeRandomBits(rng) & 1) ? 1 : -1) * (0.5f + CubeRandomUnit(rng) * speedRange);
+}
+
+void ApplyBounceJitter(float& vx, float& vy, float& axisX, float& axisY, float& axisZ, float& rotationSpeed, int wall, CubeRandom& rng) {
+    // Add randomness that makes bounce more extreme (1-3 degrees in current direction)
+    float currentAngle = atan2(vy, vx);
+    float randomOffset = CubeRandomUnit(rng) * 0.052f; // 0-3 degrees in radians
+    bool vertical = (wall & (WALL_LEFT | WALL_RIGHT)) != 0;
+    bool negateWhenPositive = (wall & (WALL_LEFT | WALL_BOTTOM)) != 0;
+    float tangential = vertical ? vy : vx;
+    if ((tangential > 0) == negateWhenPositive) randomOffset = -randomOffset;
+
+    float speed = sqrt(vx * vx + vy * vy);
+    float newAngle = currentAngle + randomOffset;
+    vx = cos(newAngle) * speed;
+    vy = sin(newAngle) * speed;
+
+    // Change to new random rotation axis and speed - quaternion preserves current orientation
+    PickRotation(axisX, axisY, axisZ, rotationSpeed, 3.0f, rng);
+}
+
+bool IsCornerBounce(float x, float y, const WorldBounds& bounds, int wall, float cornerThreshold) {
+    if (wall & (WALL_LEFT | WALL_RIGHT)) {
+        return fabs(y - bounds.top) < cornerThreshold || fabs(y - bounds.bottom) < cornerThreshold;
+    }
+    return fabs(x - bounds.left) < cornerThreshold || fabs(x - bounds.right) < cornerThreshold;
+}
+
+void ResetCube(Cube& cube, float centerX, float centerY, unsigned long long seed, unsigned int cubeId) {
+    cube.x = centerX;
+    cube.y = centerY;
+    cube.z = 0.0f;
+
+    // Event 0 is the reset itself, bounces continue from 1
+    cube.randomKey = CubeRandomKey(seed, cubeId);
+    cube.randomEvents = 1;
+    CubeRandom rng = CubeRandomStream(cube.randomKey, 0);
+
+    float angle = CubeRandomUnit(rng) * 2.0f * 3.14159f;
+    float speed = 2.0f + CubeRandomUnit(rng) * 3.0f;
+    cube.vx = cos(angle) * speed * SPEED_MULTIPLIER;
+    cube.vy = sin(angle) * speed * SPEED_MULTIPLIER;
+    cube.vz = 0;
+
+    // Start from the identity orientation
+    cube.orientation[0] = 1.0f;
+    cube.orientation[1] = cube.orientation[2] = cube.orientation[3] = 0.0f;
+    cube.stepsSinceNormalize = 0;
+
+    PickRotation(cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ, cube.rotationSpeed, 2.0f, rng);
+    UpdateCubeSpin(cube);
+    unsigned int r = CubeRandomBits(rng) % 128 + 128;
+    unsigned int g = CubeRandomBits(rng) % 128 + 128;
+    unsigned int b = CubeRandomBits(rng) % 128 + 128;
+    cube.color = CUBE_RGB(r, g, b);
+    cube.celebratingCorner = false;
+    cube.celebrationTimer = 0;
+    cube.active = true;
+}
+
+bool StepCube(Cube& cube, const WorldBounds& bounds, const CubeSettings& settings) {
+    if (!cube.active) return false;
+
+    cube.x += cube.vx;
+    cube.y += cube.vy;
+
+    RotateCube(cube);
+
+    bool hitCorner = false;
+    const float CUBE_SIZE = GetCubeSizeInPixels(settings.cubeSize);
+    const float CORNER_THRESHOLD = CUBE_SIZE * 2;
+
+    bool bounced = false;
+    int walls = 0;
+    if (cube.x - CUBE_SIZE <= bounds.left) {
+        cube.x = bounds.left + CUBE_SIZE;
+        walls = WALL_LEFT;
+    } else if (cube.x + CUBE_SIZE >= bounds.right) {
+        cube.x = bounds.right - CUBE_SIZE;
+        walls = WALL_RIGHT;
+    }
+    if (walls) {
+        bounced = true;
+        cube.vx = -cube.vx;
+        CubeRandom rng = CubeRandomStream(cube.randomKey, cube.randomEvents++);
+        ApplyBounceJitter(cube.vx, cube.vy, cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ, cube.rotationSpeed, walls, rng);
+        hitCorner |= IsCornerBounce(cube.x, cube.y, bounds, walls, CORNER_THRESHOLD);
+    }
+
+    if (cube.y - CUBE_SIZE <= bounds.top) {
+        cube.y = bounds.top + CUBE_SIZE;
+        walls = WALL_TOP;
+    } else if (cube.y + CUBE_SIZE >= bounds.bottom) {
+        cube.y = bounds.bottom - CUBE_SIZE;
+        walls = WALL_BOTTOM;
+    } else {
+        walls = 0;
+    }
+    if (walls) {
+        bounced = true;
+        cube.vy = -cube.vy;
+        CubeRandom rng = CubeRandomStream(cube.randomKey, cube.randomEvents++);
+        ApplyBounceJitter(cube.vx, cube.vy, cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ, cube.rotationSpeed, walls, rng);
+        hitCorner |= IsCornerBounce(cube.x, cube.y, bounds, walls, CORNER_THRESHOLD);
+    }
+
+    if (bounced) UpdateCubeSpin(cube);
+
+    if (hitCorner && !cube.celebratingCorner && settings.enableCelebration) {
+        cube.celebratingCorner = true;
+        cube.celebrationTimer = CELEBRATION_DURATION;
+    }
+
+    if (cube.celebratingCorner) {
+        cube.celebrationTimer--;
+        if (cube.celebrationTimer <= 0) {
+            cube.celebratingCorner = false;
+        }
+    }
+
+    return hitCorner;
+}
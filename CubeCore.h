@@ -0,0 +1,88 @@
+#pragma once
+
+// Platform-free cube simulation core shared by BouncingCubeApp, the legacy
+// main.cpp screensaver and the headless benchmark host. Nothing in here may
+// include <windows.h>; callers translate RECT/COLORREF at the boundary.
+
+#include "CubeRandom.h"
+
+#define CUBE_RGB(r, g, b) ((unsigned int)(((unsigned char)(r)) | ((unsigned int)((unsigned char)(g)) << 8) | ((unsigned int)((unsigned char)(b)) << 16)))
+#define CUBE_R(c) ((unsigned char)((c) & 0xFF))
+#define CUBE_G(c) ((unsigned char)(((c) >> 8) & 0xFF))
+#define CUBE_B(c) ((unsigned char)(((c) >> 16) & 0xFF))
+
+struct Cube {
+    float x, y, z;  // Screen space coordinates in pixels
+    float vx, vy, vz;  // Velocity in pixels per frame
+    float orientation[4];  // Unit quaternion (w, x, y, z) to preserve orientation
+    float rotationAxisX, rotationAxisY, rotationAxisZ;  // Current rotation axis
+    float rotationSpeed;  // Angular velocity in degrees per frame
+    float spin[4];  // Per-frame rotation quaternion for the current axis and speed
+    int stepsSinceNormalize;  // Frames since orientation was last renormalized
+    unsigned int color;  // Same layout as COLORREF (0x00BBGGRR)
+    unsigned long long randomKey;  // CubeRandomKey(seed, cube id)
+    unsigned long long randomEvents;  // Random events drawn so far; the next one's event number
+    bool celebratingCorner;
+    int celebrationTimer;
+    bool active;  // Whether this cube is currently visible
+};
+
+// Rectangle the cube bounces inside, in virtual desktop pixels (same layout as RECT)
+struct WorldBounds {
+    int left, top, right, bottom;
+};
+
+struct CubeSettings {
+    float cubeSize;  // 3D render scale, see GetCubeSizeInPixels
+    bool enableCelebration;
+};
+
+// Wall bits reported by the collision kernels
+enum CubeWall {
+    WALL_LEFT = 1,
+    WALL_RIGHT = 2,
+    WALL_TOP = 4,
+    WALL_BOTTOM = 8
+};
+
+const float SPEED_MULTIPLIER = 1.0f;
+const int CELEBRATION_DURATION = 60;
+const int ORIENTATION_NORMALIZE_INTERVAL = 64;  // Frames between quaternion renormalizations
+
+void MultiplyMatrix4x4(float result[16], const float a[16], const float b[16]);
+void CreateRotationMatrix(float matrix[16], float angle, float x, float y, float z);
+
+// Quaternions are stored (w, x, y, z). The rotation matrices they expand to use the
+// same layout CreateRotationMatrix produces and can go straight to glMultMatrixf.
+void CreateRotationQuaternion(float q[4], float angle, float x, float y, float z);
+void MultiplyQuaternion(float result[4], const float a[4], const float b[4]);
+void NormalizeQuaternion(float q[4]);
+void QuaternionToMatrix(float matrix[16], const float q[4]);
+
+// Expand the cube's orientation for a renderer
+void GetCubeRotationMatrix(const Cube& cube, float matrix[16]);
+
+// Recompute cube.spin after rotationAxis/rotationSpeed changed
+void UpdateCubeSpin(Cube& cube);
+
+// Apply one frame of spin to the orientation, renormalizing periodically
+void RotateCube(Cube& cube);
+
+// Convert 3D cube scale to approximate pixel size for boundary detection
+float GetCubeSizeInPixels(float cubeSize);
+
+// Place the cube at (centerX, centerY) with a random heading, axis and color.
+// Restarts the cube's random stream: the same seed and id give the same run.
+void ResetCube(Cube& cube, float centerX, float centerY, unsigned long long seed, unsigned int cubeId);
+
+// Called right after the velocity component normal to `wall` has been reflected.
+// Rotates the heading 0-3 degrees away from the wall and picks a new rotation,
+// drawing from `rng` (one CubeRandomStream per bounce).
+void ApplyBounceJitter(float& vx, float& vy, float& axisX, float& axisY, float& axisZ, float& rotationSpeed, int wall, CubeRandom& rng);
+
+// True if a bounce off `wall` at (x, y) lands within cornerThreshold of a corner
+bool IsCornerBounce(float x, float y, const WorldBounds& bounds, int wall, float cornerThreshold);
+
+// Advance the cube by one frame against the given bounds. Returns true if a
+// bounce this frame landed within the corner threshold.
+bool StepCube(Cube& cube, const WorldBounds& bounds, const CubeSettings& settings);
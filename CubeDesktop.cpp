@@ -0,0 +1,449 @@
+#include "CubeDesktop.h"
+#include "CubeEvents.h"
+#include <algorithm>
+#include <cmath>
+
+// Slack for deciding whether a crossing lands on a wall's extent. Clamped
+// positions sit exactly on breakpoints, so this only absorbs the rounding of
+// the crossing point itself.
+static const float EXTENT_SLACK = 0.01f;
+
+typedef DesktopShape::Breakpoint Breakpoint;
+typedef DesktopShape::Edge Edge;
+
+static Breakpoint MakeBreakpoint(int coord, int side, float cubeSize) {
+    Breakpoint b;
+    b.coord = coord;
+    b.side = side;
+    // Same expression StepCube clamps with: bounds.left + CUBE_SIZE
+    b.value = side > 0 ? coord + cubeSize : coord - cubeSize;
+    return b;
+}
+
+static bool BreakpointLess(const Breakpoint& a, const Breakpoint& b) { return a.value < b.value; }
+static bool EdgeLess(const Edge& a, const Edge& b) { return a.position.value < b.position.value; }
+
+// Every coordinate where the square around a center starts or stops overlapping
+// a monitor edge, sorted and without duplicate values
+static std::vector<Breakpoint> CollectBreakpoints(const std::vector<int>& coords, float cubeSize) {
+    std::vector<Breakpoint> breaks;
+    for (size_t i = 0; i < coords.size(); i++) {
+        breaks.push_back(MakeBreakpoint(coords[i], +1, cubeSize));
+        breaks.push_back(MakeBreakpoint(coords[i], -1, cubeSize));
+    }
+    std::stable_sort(breaks.begin(), breaks.end(), BreakpointLess);
+    std::vector<Breakpoint> unique;
+    for (size_t i = 0; i < breaks.size(); i++) {
+        if (unique.empty() || unique.back().value != breaks[i].value) unique.push_back(breaks[i]);
+    }
+    return unique;
+}
+
+// Index range [first, last) of the compressed cells whose interior overlaps
+// (low, high). False if the span sticks out past the outermost edges.
+static bool CellSpan(const std::vector<int>& coords, double low, double high, size_t& first, size_t& last) {
+    if (low < coords.front() || high > coords.back()) return false;
+    first = std::upper_bound(coords.begin(), coords.end(), low) - coords.begin() - 1;
+    last = std::lower_bound(coords.begin(), coords.end(), high) - coords.begin();
+    return true;
+}
+
+DesktopShape::DesktopShape() : cubeSize(0), cellsX(0), cellsY(0) {
+    boundingBox.left = boundingBox.top = boundingBox.right = boundingBox.bottom = 0;
+}
+
+size_t DesktopShape::EdgeCount() const {
+    return walls[0].size() + walls[1].size() + walls[2].size() + walls[3].size();
+}
+
+bool DesktopShape::CellValid(int i, int j) const {
+    if (i < 0 || j < 0 || i >= cellsX || j >= cellsY) return false;
+    return valid[(size_t)j * cellsX + i] != 0;
+}
+
+void DesktopShape::Build(const std::vector<WorldBounds>& monitors, float cubeSizePixels) {
+    cubeSize = cubeSizePixels;
+    for (int w = 0; w < 4; w++) walls[w].clear();
+    breaksX.clear();
+    breaksY.clear();
+    valid.clear();
+    cellsX = cellsY = 0;
+    boundingBox.left = boundingBox.top = boundingBox.right = boundingBox.bottom = 0;
+    if (monitors.empty()) return;
+
+    // Coverage of the desktop itself on the grid of monitor edges
+    std::vector<int> edgesX, edgesY;
+    boundingBox = monitors[0];
+    for (size_t m = 0; m < monitors.size(); m++) {
+        const WorldBounds& mon = monitors[m];
+        edgesX.push_back(mon.left);
+        edgesX.push_back(mon.right);
+        edgesY.push_back(mon.top);
+        edgesY.push_back(mon.bottom);
+        boundingBox.left = std::min(boundingBox.left, mon.left);
+        boundingBox.top = std::min(boundingBox.top, mon.top);
+        boundingBox.right = std::max(boundingBox.right, mon.right);
+        boundingBox.bottom = std::max(boundingBox.bottom, mon.bottom);
+    }
+    std::sort(edgesX.begin(), edgesX.end());
+    edgesX.erase(std::unique(edgesX.begin(), edgesX.end()), edgesX.end());
+    std::sort(edgesY.begin(), edgesY.end());
+    edgesY.erase(std::unique(edgesY.begin(), edgesY.end()), edgesY.end());
+    if (edgesX.size() < 2 || edgesY.size() < 2) return;
+
+    size_t coverX = edgesX.size() - 1;
+    size_t coverY = edgesY.size() - 1;
+    std::vector<unsigned char> covered(coverX * coverY, 0);
+    for (size_t m = 0; m < monitors.size(); m++) {
+        const WorldBounds& mon = monitors[m];
+        size_t x0 = std::lower_bound(edgesX.begin(), edgesX.end(), mon.left) - edgesX.begin();
+        size_t x1 = std::lower_bound(edgesX.begin(), edgesX.end(), mon.right) - edgesX.begin();
+        size_t y0 = std::lower_bound(edgesY.begin(), edgesY.end(), mon.top) - edgesY.begin();
+        size_t y1 = std::lower_bound(edgesY.begin(), edgesY.end(), mon.bottom) - edgesY.begin();
+        for (size_t j = y0; j < y1; j++) {
+            for (size_t i = x0; i < x1; i++) covered[j * coverX + i] = 1;
+        }
+    }
+
+    // Valid centers: the square of half size cubeSize around them lies inside
+    // the covered cells. Validity only changes where a side of the square meets
+    // a monitor edge, so it is constant on the cells between those breakpoints.
+    breaksX = CollectBreakpoints(edgesX, cubeSize);
+    breaksY = CollectBreakpoints(edgesY, cubeSize);
+    cellsX = (int)breaksX.size() - 1;
+    cellsY = (int)breaksY.size() - 1;
+    valid.assign((size_t)cellsX * cellsY, 0);
+    for (int j = 0; j < cellsY; j++) {
+        double cy = ((double)breaksY[j].value + breaksY[j + 1].value) / 2;
+        size_t y0 = 0, y1 = 0;
+        bool spanY = CellSpan(edgesY, cy - cubeSize, cy + cubeSize, y0, y1);
+        for (int i = 0; i < cellsX; i++) {
+            double cx = ((double)breaksX[i].value + breaksX[i + 1].value) / 2;
+            size_t x0 = 0, x1 = 0;
+            bool inside = spanY && CellSpan(edgesX, cx - cubeSize, cx + cubeSize, x0, x1);
+            for (size_t v = y0; inside && v < y1; v++) {
+                for (size_t u = x0; inside && u < x1; u++) inside = covered[v * coverX + u] != 0;
+            }
+            valid[(size_t)j * cellsX + i] = inside ? 1 : 0;
+        }
+    }
+
+    // Walls between valid and invalid cells, merged into maximal runs. An end is
+    // convex when the valid side does not carry on past it.
+    for (int i = 0; i <= cellsX; i++) {
+        for (int j = 0; j < cellsY;) {
+            bool leftWall = CellValid(i, j) && !CellValid(i - 1, j);
+            bool rightWall = CellValid(i - 1, j) && !CellValid(i, j);
+            if (!leftWall && !rightWall) { j++; continue; }
+            int inner = leftWall ? i : i - 1;
+            int outer = leftWall ? i - 1 : i;
+            int end = j;
+            while (end + 1 < cellsY && CellValid(inner, end + 1) && !CellValid(outer, end + 1)) end++;
+
+            Edge edge;
+            edge.position = breaksX[i];
+            edge.low = breaksY[j].value;
+            edge.high = breaksY[end + 1].value;
+            edge.lowCorner = breaksY[j];
+            edge.highCorner = breaksY[end + 1];
+            edge.lowConvex = !CellValid(inner, j - 1);
+            edge.highConvex = !CellValid(inner, end + 1);
+            walls[leftWall ? 0 : 1].push_back(edge);
+            j = end + 1;
+        }
+    }
+    for (int j = 0; j <= cellsY; j++) {
+        for (int i = 0; i < cellsX;) {
+            bool topWall = CellValid(i, j) && !CellValid(i, j - 1);
+            bool bottomWall = CellValid(i, j - 1) && !CellValid(i, j);
+            if (!topWall && !bottomWall) { i++; continue; }
+            int inner = topWall ? j : j - 1;
+            int outer = topWall ? j - 1 : j;
+            int end = i;
+            while (end + 1 < cellsX && CellValid(end + 1, inner) && !CellValid(end + 1, outer)) end++;
+
+            Edge edge;
+            edge.position = breaksY[j];
+            edge.low = breaksX[i].value;
+            edge.high = breaksX[end + 1].value;
+            edge.lowCorner = breaksX[i];
+            edge.highCorner = breaksX[end + 1];
+            edge.lowConvex = !CellValid(i - 1, inner);
+            edge.highConvex = !CellValid(end + 1, inner);
+            walls[topWall ? 2 : 3].push_back(edge);
+            i = end + 1;
+        }
+    }
+    for (int w = 0; w < 4; w++) std::stable_sort(walls[w].begin(), walls[w].end(), EdgeLess);
+}
+
+// Cells whose closed interval touches [low, high]
+static void CellRange(const std::vector<Breakpoint>& breaks, float low, float high, int& first, int& last) {
+    Breakpoint key;
+    key.value = low;
+    first = (int)(std::lower_bound(breaks.begin(), breaks.end(), key, BreakpointLess) - breaks.begin()) - 1;
+    key.value = high;
+    last = (int)(std::upper_bound(breaks.begin(), breaks.end(), key, BreakpointLess) - breaks.begin()) - 1;
+}
+
+bool DesktopShape::Contains(float x, float y) const {
+    if (Empty()) return false;
+    int i0, i1, j0, j1;
+    CellRange(breaksX, x, x, i0, i1);
+    CellRange(breaksY, y, y, j0, j1);
+    for (int j = std::max(j0, 0); j <= std::min(j1, cellsY - 1); j++) {
+        for (int i = std::max(i0, 0); i <= std::min(i1, cellsX - 1); i++) {
+            if (CellValid(i, j)) return true;
+        }
+    }
+    return false;
+}
+
+bool DesktopShape::FindStart(const WorldBounds& monitor, float& x, float& y) const {
+    float cx = (monitor.left + monitor.right) / 2.0f;
+    float cy = (monitor.top + monitor.bottom) / 2.0f;
+    if (Contains(cx, cy)) {
+        x = cx;
+        y = cy;
+        return true;
+    }
+
+    // Closest point of the closest valid cell
+    double best = HUGE_VAL;
+    for (int j = 0; j < cellsY; j++) {
+        for (int i = 0; i < cellsX; i++) {
+            if (!CellValid(i, j)) continue;
+            float px = std::min(std::max(cx, breaksX[i].value), breaksX[i + 1].value);
+            float py = std::min(std::max(cy, breaksY[j].value), breaksY[j + 1].value);
+            double distance = ((double)px - cx) * (px - cx) + ((double)py - cy) * (py - cy);
+            if (distance < best) {
+                best = distance;
+                x = px;
+                y = py;
+            }
+        }
+    }
+    return best != HUGE_VAL;
+}
+
+// StepCube's wall predicates, generalised to both breakpoint sides. For a
+// side +1 low wall this is exactly `x - CUBE_SIZE <= bounds.left`.
+static bool ReachesLowWall(float p, const Breakpoint& b, float size) {
+    return b.side > 0 ? p - size <= b.coord : p + size <= b.coord;
+}
+
+static bool ReachesHighWall(float p, const Breakpoint& b, float size) {
+    return b.side < 0 ? p + size >= b.coord : p - size >= b.coord;
+}
+
+// The first wall of `list` (all facing the motion) met while moving along one
+// axis from `from` to `to`, with the other axis going from `acrossFrom` to
+// `acrossTo`. Binary search narrows it to walls between the two positions.
+static const Edge* FirstWallCrossed(const std::vector<Edge>& list, bool lowWalls, float from, float to,
+                                    float acrossFrom, float acrossTo, float size, float& fraction) {
+    if (list.empty()) return NULL;
+    Edge key;
+    double span = (double)to - from;
+    if (lowWalls) {
+        // Moving toward -axis: walls in [to, from], nearest (largest) first
+        key.position.value = from + EXTENT_SLACK;
+        std::vector<Edge>::const_iterator it = std::upper_bound(list.begin(), list.end(), key, EdgeLess);
+        while (it != list.begin()) {
+            --it;
+            if (it->position.value < to - EXTENT_SLACK) break;
+            if (!ReachesLowWall(to, it->position, size)) continue;
+            double t = span != 0 ? ((double)it->position.value - from) / span : 0;
+            t = std::min(std::max(t, 0.0), 1.0);
+            double across = acrossFrom + t * ((double)acrossTo - acrossFrom);
+            if (across >= it->low - EXTENT_SLACK && across <= it->high + EXTENT_SLACK) {
+                fraction = (float)t;
+                return &*it;
+            }
+        }
+    } else {
+        key.position.value = from - EXTENT_SLACK;
+        std::vector<Edge>::const_iterator it = std::lower_bound(list.begin(), list.end(), key, EdgeLess);
+        for (; it != list.end(); ++it) {
+            if (it->position.value > to + EXTENT_SLACK) break;
+            if (!ReachesHighWall(to, it->position, size)) continue;
+            double t = span != 0 ? ((double)it->position.value - from) / span : 0;
+            t = std::min(std::max(t, 0.0), 1.0);
+            double across = acrossFrom + t * ((double)acrossTo - acrossFrom);
+            if (across >= it->low - EXTENT_SLACK && across <= it->high + EXTENT_SLACK) {
+                fraction = (float)t;
+                return &*it;
+            }
+        }
+    }
+    return NULL;
+}
+
+static float ClampToWall(const Breakpoint& b, float size) {
+    return b.side > 0 ? b.coord + size : b.coord - size;
+}
+
+// IsCornerBounce for a desktop wall: only convex ends count as corners
+static bool IsDesktopCornerBounce(float along, const Edge& edge, float threshold) {
+    return (edge.lowConvex && fabs(along - edge.lowCorner.coord) < threshold) ||
+           (edge.highConvex && fabs(along - edge.highCorner.coord) < threshold);
+}
+
+// Which walls a straight move from (x0, y0) to (x1, y1) runs into, and where
+// the cube ends up after clamping to them
+struct DesktopContact {
+    const Edge* wallX;
+    const Edge* wallY;
+    int wallsX, wallsY;
+    float x, y;
+};
+
+static DesktopContact SweepCube(const DesktopShape& shape, float x0, float y0, float x1, float y1) {
+    const float size = shape.CubeSizePixels();
+    bool lowX = x1 <= x0;
+    bool lowY = y1 <= y0;
+    const std::vector<Edge>& listX = shape.walls[lowX ? 0 : 1];
+    const std::vector<Edge>& listY = shape.walls[lowY ? 2 : 3];
+
+    DesktopContact contact;
+    contact.wallsX = lowX ? WALL_LEFT : WALL_RIGHT;
+    contact.wallsY = lowY ? WALL_TOP : WALL_BOTTOM;
+    contact.x = x1;
+    contact.y = y1;
+
+    float tx = 0, ty = 0;
+    contact.wallX = FirstWallCrossed(listX, lowX, x0, x1, y0, y1, size, tx);
+    contact.wallY = FirstWallCrossed(listY, lowY, y0, y1, x0, x1, size, ty);
+
+    // The earlier contact stops its axis; the other axis then slides along that
+    // wall and may still meet a wall of its own.
+    if (contact.wallX && (!contact.wallY || tx <= ty)) {
+        contact.x = ClampToWall(contact.wallX->position, size);
+        float slideFrom = (float)(y0 + (double)tx * ((double)y1 - y0));
+        contact.wallY = FirstWallCrossed(listY, lowY, slideFrom, y1, contact.x, contact.x, size, ty);
+    } else if (contact.wallY) {
+        contact.y = ClampToWall(contact.wallY->position, size);
+        float slideFrom = (float)(x0 + (double)ty * ((double)x1 - x0));
+        contact.wallX = FirstWallCrossed(listX, lowX, slideFrom, x1, contact.y, contact.y, size, tx);
+    }
+    if (contact.wallX) contact.x = ClampToWall(contact.wallX->position, size);
+    if (contact.wallY) contact.y = ClampToWall(contact.wallY->position, size);
+    if (!contact.wallX) contact.wallsX = 0;
+    if (!contact.wallY) contact.wallsY = 0;
+    return contact;
+}
+
+bool StepCubeDesktop(Cube& cube, const DesktopShape& shape, const CubeSettings& settings) {
+    if (!cube.active) return false;
+
+    float startX = cube.x;
+    float startY = cube.y;
+    cube.x += cube.vx;
+    cube.y += cube.vy;
+
+    RotateCube(cube);
+
+    bool hitCorner = false;
+    const float CUBE_SIZE = GetCubeSizeInPixels(settings.cubeSize);
+    const float CORNER_THRESHOLD = CUBE_SIZE * 2;
+
+    DesktopContact contact = SweepCube(shape, startX, startY, cube.x, cube.y);
+    bool bounced = false;
+    if (!shape.Contains(contact.x, contact.y)) {
+        // Rounding at a notch let the cube slip past both walls; back out the
+        // way it came rather than leave the desktop
+        contact.x = startX;
+        contact.y = startY;
+        cube.vx = -cube.vx;
+        cube.vy = -cube.vy;
+        contact.wallsX = contact.wallsY = 0;
+        bounced = true;
+    }
+
+    // Same order as StepCube: x bounces see the unclamped y, y bounces the final x
+    if (contact.wallsX) {
+        bounced = true;
+        cube.x = contact.x;
+        cube.vx = -cube.vx;
+        CubeRandom rng = CubeRandomStream(cube.randomKey, cube.randomEvents++);
+        ApplyBounceJitter(cube.vx, cube.vy, cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ, cube.rotationSpeed, contact.wallsX, rng);
+        hitCorner |= IsDesktopCornerBounce(cube.y, *contact.wallX, CORNER_THRESHOLD);
+    }
+    cube.x = contact.x;
+    if (contact.wallsY) {
+        bounced = true;
+        cube.y = contact.y;
+        cube.vy = -cube.vy;
+        CubeRandom rng = CubeRandomStream(cube.randomKey, cube.randomEvents++);
+        ApplyBounceJitter(cube.vx, cube.vy, cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ, cube.rotationSpeed, contact.wallsY, rng);
+        hitCorner |= IsDesktopCornerBounce(cube.x, *contact.wallY, CORNER_THRESHOLD);
+    }
+    cube.y = contact.y;
+
+    if (bounced) UpdateCubeSpin(cube);
+
+    if (hitCorner && !cube.celebratingCorner && settings.enableCelebration) {
+        cube.celebratingCorner = true;
+        cube.celebrationTimer = CELEBRATION_DURATION;
+    }
+
+    if (cube.celebratingCorner) {
+        cube.celebrationTimer--;
+        if (cube.celebrationTimer <= 0) {
+            cube.celebratingCorner = false;
+        }
+    }
+
+    return hitCorner;
+}
+
+// Frames until the ray from the cube first meets a wall, in doubles. Only a
+// guess: the float path wanders from the ray by rounding, which the caller
+// checks for before trusting it.
+static double EstimateFramesToWall(const Cube& cube, const DesktopShape& shape) {
+    double best = HUGE_VAL;
+    for (int axis = 0; axis < 2; axis++) {
+        double p = axis == 0 ? cube.x : cube.y;
+        double v = axis == 0 ? cube.vx : cube.vy;
+        double q = axis == 0 ? cube.y : cube.x;
+        double w = axis == 0 ? cube.vy : cube.vx;
+        if (v == 0) continue;
+        const std::vector<Edge>& list = shape.walls[axis * 2 + (v < 0 ? 0 : 1)];
+        for (size_t k = 0; k < list.size(); k++) {
+            double n = (list[k].position.value - p) / v;
+            if (n < 0 || n >= best) continue;
+            double across = q + n * w;
+            if (across >= list[k].low && across <= list[k].high) best = n;
+        }
+    }
+    return best;
+}
+
+long long AdvanceCubeDesktop(Cube& cube, const DesktopShape& shape, const CubeSettings& settings, long long frames) {
+    if (!cube.active) return 0;
+
+    long long corners = 0;
+    while (frames > 0) {
+        // Coast to a couple of frames short of the estimated contact, provided
+        // the straight stretch really is clear; otherwise try half as far.
+        double estimate = EstimateFramesToWall(cube, shape) - 2;
+        long long coast = estimate >= (double)frames ? frames : (estimate > 0 ? (long long)estimate : 0);
+        while (coast > 0) {
+            Cube probe = cube;
+            CoastCube(probe, coast);
+            DesktopContact contact = SweepCube(shape, cube.x, cube.y, probe.x, probe.y);
+            if (!contact.wallsX && !contact.wallsY && shape.Contains(probe.x, probe.y)) {
+                cube = probe;
+                break;
+            }
+            coast /= 2;
+        }
+        if (coast > 0) {
+            frames -= coast;
+            continue;
+        }
+
+        if (StepCubeDesktop(cube, shape, settings)) corners++;
+        frames--;
+    }
+    return corners;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CubeCore.h"
+#include <cstddef>
+#include <vector>
+
+// Physics against the exact shape of a multi-monitor desktop: the union of the
+// monitor rectangles rather than their bounding box, so the cube never flies
+// into dead regions no monitor shows.
+//
+// The region the cube's center may occupy is the union shrunk by the cube's
+// half size. It is rectilinear, so it is stored as a grid over its breakpoints
+// plus four sorted lists of wall edges (one per facing). A step looks up the
+// walls between the old and new position with a binary search, so the cost is
+// O(log edges) no matter how fast the cube moves, and nothing can tunnel.
+//
+// With a single rectangle every comparison, clamp and corner test reduces to the
+// same float expression StepCube evaluates, so the results are bit-identical.
+
+class DesktopShape {
+public:
+    DesktopShape();
+
+    // Rebuild for these monitor rectangles and the cube's half size in pixels
+    void Build(const std::vector<WorldBounds>& monitors, float cubeSizePixels);
+
+    bool Empty() const { return cellsX == 0 || cellsY == 0; }
+    float CubeSizePixels() const { return cubeSize; }
+    const WorldBounds& BoundingBox() const { return boundingBox; }
+    size_t EdgeCount() const;
+
+    // True if the cube's center may sit at (x, y), boundary included
+    bool Contains(float x, float y) const;
+
+    // A valid center as close as possible to the middle of `monitor`, for
+    // placing a new cube. False if the cube fits nowhere on the desktop.
+    bool FindStart(const WorldBounds& monitor, float& x, float& y) const;
+
+    // One breakpoint of the shrunk region: coord + side * cubeSize. Keeping the
+    // integer monitor coordinate lets tests use StepCube's exact expressions.
+    struct Breakpoint {
+        int coord;
+        int side;  // +1 or -1
+        float value;
+    };
+
+    // A wall of the shrunk region. Vertical walls block x motion, horizontal
+    // walls block y motion. [low, high] is the extent along the other axis.
+    struct Edge {
+        Breakpoint position;
+        float low, high;
+        Breakpoint lowCorner, highCorner;  // Where perpendicular walls meet this one
+        bool lowConvex, highConvex;  // Whether those meetings are real corners
+    };
+
+    // Walls facing each direction, sorted by position.value. walls[0] stops
+    // motion toward -x (CubeWall WALL_LEFT), then WALL_RIGHT, WALL_TOP, WALL_BOTTOM.
+    std::vector<Edge> walls[4];
+
+private:
+    bool CellValid(int i, int j) const;
+
+    float cubeSize;
+    WorldBounds boundingBox;
+    std::vector<Breakpoint> breaksX, breaksY;
+    int cellsX, cellsY;
+    std::vector<unsigned char> valid;  // cellsX * cellsY, row-major by y
+};
+
+// StepCube for a desktop shape. The shape must have been built for
+// GetCubeSizeInPixels(settings.cubeSize). Returns true on a corner hit, where a
+// corner is a convex corner of the desktop, not a notch.
+bool StepCubeDesktop(Cube& cube, const DesktopShape& shape, const CubeSettings& settings);
+
+// AdvanceCube for a desktop shape: coasts along straight stretches that provably
+// reach no wall and steps only near contacts. Returns the number of corner hits.
+long long AdvanceCubeDesktop(Cube& cube, const DesktopShape& shape, const CubeSettings& settings, long long frames);
@@ -0,0 +1,203 @@
+#include "CubeEvents.h"
+#include <cmath>
+#include <cstring>
+
+// Position after `frames` repetitions of the float update `p += v` that StepCube
+// performs, reproduced bit for bit. While p stays inside one binade every sum is
+// rounded to the same grid, so each step adds the same float delta and a whole
+// run of steps collapses to one multiply. Only binade crossings are stepped.
+static float PositionAfter(float p, float v, long long frames) {
+    while (frames > 0) {
+        float next = p + v;
+        if (next == p) break;  // v is below half an ulp here, so p never moves again
+        float after = next + v;
+        float delta = next - p;
+
+        // Binade of p is [low, high) in magnitude with grid spacing ulp
+        unsigned int bits;
+        memcpy(&bits, &p, sizeof(bits));
+        unsigned long long lowBits = (unsigned long long)(((bits >> 23) & 0xFF) - 127 + 1023) << 52;
+        double low;
+        memcpy(&low, &lowBits, sizeof(low));
+        double high = low * 2;
+        double ulp = low * (1.0 / 8388608.0);  // 2^-23
+
+        // Constant deltas imply a tie-free grid (see ties-to-even), so jump
+        long long run = 0;
+        if (p != 0 && after - next == delta) {
+            double magnitude = fabs((double)p);
+            double step = fabs((double)delta);
+            bool growing = (p > 0) == (delta > 0);
+            double room = growing ? (high - ulp) - magnitude : magnitude - (low + ulp);
+            if (room > 0) run = (long long)floor(room / step);
+        }
+
+        if (run < 2) {
+            p = next;
+            frames--;
+            continue;
+        }
+        if (run > frames) run = frames;
+        p = (float)((double)p + (double)run * delta);
+        frames -= run;
+    }
+    return p;
+}
+
+// StepCube's wall test for one axis after integration
+static bool TouchesWall(float p, float size, int low, int high) {
+    return p - size <= low || p + size >= high;
+}
+
+// Double-precision guess at the first touching frame, HUGE_VAL if never
+static double EstimateAxisHit(float position, float velocity, float size, int low, int high) {
+    if (velocity < 0) return ((double)position - size - low) / -velocity;   // pos + n*v - size <= low
+    if (velocity > 0) return ((double)high - size - position) / velocity;   // pos + n*v + size >= high
+    return HUGE_VAL;
+}
+
+// First frame n in [1, limit] at which the axis touches a wall, or -1
+static long long FramesUntilAxisHit(float position, float velocity, float size, int low, int high, long long limit) {
+    if (TouchesWall(position + velocity, size, low, high)) return 1;
+    if (position + velocity == position || limit < 2) return -1;
+
+    // Bracket the first touching frame starting at the estimate and bisect. Float
+    // rounding can make the real path slower than v (tiny velocities near an
+    // ulp), so the estimate may be off by far more than one frame.
+    double distance = EstimateAxisHit(position, velocity, size, low, high);
+    long long miss = 1;
+    long long hit = distance < 2.0 ? 2 : (distance >= (double)limit ? limit : (long long)ceil(distance));
+
+    // Common case: the estimate is exact. One more float step from the frame
+    // before is the same update StepCube does, so it needs no second solve.
+    float before = PositionAfter(position, velocity, hit - 1);
+    if (!TouchesWall(before, size, low, high)) {
+        if (TouchesWall(before + velocity, size, low, high)) return hit;
+        miss = hit;
+        if (hit >= limit) return -1;
+        hit = hit > limit / 2 ? limit : hit * 2;
+        while (!TouchesWall(PositionAfter(position, velocity, hit), size, low, high)) {
+            if (hit >= limit) return -1;
+            miss = hit;
+            hit = hit > limit / 2 ? limit : hit * 2;
+        }
+    } else {
+        hit = hit - 1;
+    }
+
+    while (hit - miss > 1) {
+        long long mid = miss + (hit - miss) / 2;
+        if (TouchesWall(PositionAfter(position, velocity, mid), size, low, high)) hit = mid;
+        else miss = mid;
+    }
+    return hit;
+}
+
+// Solve the axis that is expected to hit first, then only ask whether the other
+// one beats it. Nothing past `limit` frames is searched.
+static long long FramesUntilWallHitWithin(const Cube& cube, const WorldBounds& bounds, float cubeSizePixels, long long limit) {
+    double estimateX = EstimateAxisHit(cube.x, cube.vx, cubeSizePixels, bounds.left, bounds.right);
+    double estimateY = EstimateAxisHit(cube.y, cube.vy, cubeSizePixels, bounds.top, bounds.bottom);
+    bool xFirst = estimateX <= estimateY;
+
+    long long first = xFirst
+        ? FramesUntilAxisHit(cube.x, cube.vx, cubeSizePixels, bounds.left, bounds.right, limit)
+        : FramesUntilAxisHit(cube.y, cube.vy, cubeSizePixels, bounds.top, bounds.bottom, limit);
+    if (first > 0) limit = first;
+    long long second = xFirst
+        ? FramesUntilAxisHit(cube.y, cube.vy, cubeSizePixels, bounds.top, bounds.bottom, limit)
+        : FramesUntilAxisHit(cube.x, cube.vx, cubeSizePixels, bounds.left, bounds.right, limit);
+
+    if (first < 0) return second;
+    if (second < 0) return first;
+    return first < second ? first : second;
+}
+
+long long FramesUntilWallHit(const Cube& cube, const WorldBounds& bounds, float cubeSizePixels) {
+    return FramesUntilWallHitWithin(cube, bounds, cubeSizePixels, 1LL << 62);
+}
+
+void CoastCube(Cube& cube, long long frames) {
+    if (frames <= 0) return;
+
+    cube.x = PositionAfter(cube.x, cube.vx, frames);
+    cube.y = PositionAfter(cube.y, cube.vy, frames);
+
+    // N incremental rotations about a fixed axis are one rotation by N times the
+    // angle. Reduce in radians with the same pi approximation CreateRotationQuaternion uses.
+    const double DEG_TO_RAD = 3.14159 / 180.0;
+    const double TWO_PI = 6.283185307179586;
+    double radians = fmod((double)frames * cube.rotationSpeed * DEG_TO_RAD, TWO_PI);
+    float spin[4];
+    CreateRotationQuaternion(spin, (float)(radians / DEG_TO_RAD),
+                             cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ);
+    float rotated[4];
+    MultiplyQuaternion(rotated, spin, cube.orientation);
+    NormalizeQuaternion(rotated);
+    for (int i = 0; i < 4; i++) {
+        cube.orientation[i] = rotated[i];
+    }
+    cube.stepsSinceNormalize = 0;
+
+    if (cube.celebratingCorner) {
+        if (frames >= cube.celebrationTimer) {
+            cube.celebrationTimer = 0;
+            cube.celebratingCorner = false;
+        } else {
+            cube.celebrationTimer -= (int)frames;
+        }
+    }
+}
+
+long long AdvanceCube(Cube& cube, const WorldBounds& bounds, const CubeSettings& settings, long long frames) {
+    if (!cube.active) return 0;
+
+    const float CUBE_SIZE = GetCubeSizeInPixels(settings.cubeSize);
+    long long corners = 0;
+    while (frames > 0) {
+        long long untilHit = FramesUntilWallHitWithin(cube, bounds, CUBE_SIZE, frames);
+        if (untilHit < 0) {
+            CoastCube(cube, frames);
+            break;
+        }
+
+        // Coast to the frame before contact, then let StepCube do the bounce itself
+        // so jitter, corner detection and celebration stay in one place.
+        CoastCube(cube, untilHit - 1);
+        if (StepCube(cube, bounds, settings)) corners++;
+        frames -= untilHit;
+    }
+    return corners;
+}
+
+long long FramesUntilCornerHit(const Cube& cube, const WorldBounds& bounds, const CubeSettings& settings, long long limit) {
+    if (!cube.active) return -1;
+
+    const float CUBE_SIZE = GetCubeSizeInPixels(settings.cubeSize);
+    Cube probe = cube;
+    long long elapsed = 0;
+    while (elapsed < limit) {
+        long long untilHit = FramesUntilWallHitWithin(probe, bounds, CUBE_SIZE, limit - elapsed);
+        if (untilHit < 0) return -1;
+
+        CoastCube(probe, untilHit - 1);
+        elapsed += untilHit;
+        if (StepCube(probe, bounds, settings)) return elapsed;
+    }
+    return -1;
+}
+
+double EstimateCornerHitRate(const WorldBounds& bounds, const CubeSettings& settings, unsigned long long seed, int cubes, long long frames) {
+    if (cubes <= 0 || frames <= 0) return 0;
+
+    // Bounce jitter steers every contact toward the wall normal, so wall contacts
+    // are not spread evenly along the walls and a closed-form rate based on that
+    // assumption overshoots by 2-3x. Sample the real dynamics instead.
+    long long hits = 0;
+    for (int c = 0; c < cubes; c++) {
+        Cube cube;
+        ResetCube(cube, (bounds.left + bounds.right) / 2.0f, (bounds.top + bounds.bottom) / 2.0f, seed, (unsigned int)c);
+        hits += AdvanceCube(cube, bounds, settings, frames);
+    }
+    return (double)hits / ((double)cubes * frames);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "CubeCore.h"
+
+// Event-driven stepping. Between bounces StepCube moves the cube in a straight
+// line and spins it about a fixed axis, so the next wall contact can be solved
+// in closed form and everything up to it skipped in O(1).
+
+// Number of frames until StepCube would next touch a wall (>= 1), or -1 if the
+// cube is not moving toward any wall.
+long long FramesUntilWallHit(const Cube& cube, const WorldBounds& bounds, float cubeSizePixels);
+
+// Move and spin the cube for `frames` frames without any wall checks. Only
+// valid while FramesUntilWallHit() > frames.
+void CoastCube(Cube& cube, long long frames);
+
+// Equivalent to calling StepCube `frames` times, but costs O(bounces) instead of
+// O(frames). Returns the number of corner hits along the way.
+long long AdvanceCube(Cube& cube, const WorldBounds& bounds, const CubeSettings& settings, long long frames);
+
+// Frames until StepCube next reports a corner hit (>= 1), or -1 if there is none
+// within `limit` frames. Walks the same bounces and random draws StepCube would,
+// one wall contact at a time, so the answer is exact at O(bounces) cost. The
+// cube itself is not modified.
+long long FramesUntilCornerHit(const Cube& cube, const WorldBounds& bounds, const CubeSettings& settings, long long limit);
+
+// Corner hits per frame averaged over `cubes` cubes (ids 0..cubes-1 of `seed`)
+// started at the center of the bounds and advanced `frames` frames each. Runs
+// on AdvanceCube, so hours of simulated time cost milliseconds.
+double EstimateCornerHitRate(const WorldBounds& bounds, const CubeSettings& settings, unsigned long long seed, int cubes, long long frames);
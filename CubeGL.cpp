@@ -0,0 +1,499 @@
+#include "CubeGL.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include <cmath>
+#include <cstddef>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// GL 1.5, missing from the GL 1.1 headers Windows ships
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW 0x88E4
+#endif
+
+// GL 2.0 and instancing
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+
+typedef void (APIENTRY* GenBuffersProc)(GLsizei, GLuint*);
+typedef void (APIENTRY* BindBufferProc)(GLenum, GLuint);
+typedef void (APIENTRY* BufferDataProc)(GLenum, ptrdiff_t, const void*, GLenum);
+typedef void (APIENTRY* DeleteBuffersProc)(GLsizei, const GLuint*);
+typedef void (APIENTRY* BufferSubDataProc)(GLenum, ptrdiff_t, ptrdiff_t, const void*);
+typedef GLuint (APIENTRY* CreateShaderProc)(GLenum);
+typedef void (APIENTRY* ShaderSourceProc)(GLuint, GLsizei, const char* const*, const GLint*);
+typedef void (APIENTRY* CompileShaderProc)(GLuint);
+typedef void (APIENTRY* GetShaderivProc)(GLuint, GLenum, GLint*);
+typedef GLuint (APIENTRY* CreateProgramProc)();
+typedef void (APIENTRY* AttachShaderProc)(GLuint, GLuint);
+typedef void (APIENTRY* BindAttribLocationProc)(GLuint, GLuint, const char*);
+typedef void (APIENTRY* LinkProgramProc)(GLuint);
+typedef void (APIENTRY* GetProgramivProc)(GLuint, GLenum, GLint*);
+typedef void (APIENTRY* UseProgramProc)(GLuint);
+typedef GLint (APIENTRY* GetUniformLocationProc)(GLuint, const char*);
+typedef void (APIENTRY* Uniform4fProc)(GLint, GLfloat, GLfloat, GLfloat, GLfloat);
+typedef void (APIENTRY* Uniform1fProc)(GLint, GLfloat);
+typedef void (APIENTRY* VertexAttribPointerProc)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
+typedef void (APIENTRY* VertexAttribArrayProc)(GLuint);
+typedef void (APIENTRY* VertexAttribDivisorProc)(GLuint, GLuint);
+typedef void (APIENTRY* DrawElementsInstancedProc)(GLenum, GLsizei, GLenum, const void*, GLsizei);
+typedef void (APIENTRY* DeleteObjectProc)(GLuint);
+
+void SetupCubeLighting() {
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_COLOR_MATERIAL);
+
+    // DrawCubeImmediate winds every face counter-clockwise from outside. Without
+    // culling, a back face ties in depth with the front face it meets along
+    // the silhouette, and which wins depends on how the driver splits quads.
+    glEnable(GL_CULL_FACE);
+
+    float lightPos[] = {0.0f, 0.0f, 1.0f, 0.0f};
+    float lightAmb[] = {0.2f, 0.2f, 0.2f, 1.0f};
+    float lightDiff[] = {0.8f, 0.8f, 0.8f, 1.0f};
+
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmb);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiff);
+}
+
+// The viewport and RenderScene's gluPerspective(45, aspect, 0.1, 100), with
+// an identity modelview
+static void SetView(const DisplayOutput& output) {
+    glViewport(0, 0, output.width, output.height);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(45.0, output.aspect, 0.1, 100.0);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+static void Clear(unsigned int rgba) {
+    glClearColor(CUBE_R(rgba) / 255.0f, CUBE_G(rgba) / 255.0f, CUBE_B(rgba) / 255.0f, (rgba >> 24) / 255.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DrawCubeImmediate(const CubeDraw& draw, const DisplayOutput& output) {
+    float relX, relY;
+    CubeDrawOffset(draw, output, relX, relY);
+
+    float cubeScale = draw.halfSize;
+
+    glPushMatrix();
+    glTranslatef(relX, relY, -5.0f);
+    glMultMatrixf(draw.rotation);
+    if (draw.scale != 1.0f) {
+        glScalef(draw.scale, draw.scale, draw.scale);
+    }
+
+    glColor3f(draw.r, draw.g, draw.b);
+
+    glBegin(GL_QUADS);
+    // Front face
+    glNormal3f(0.0f, 0.0f, 1.0f);
+    glVertex3f(-cubeScale, -cubeScale, cubeScale);
+    glVertex3f(cubeScale, -cubeScale, cubeScale);
+    glVertex3f(cubeScale, cubeScale, cubeScale);
+    glVertex3f(-cubeScale, cubeScale, cubeScale);
+
+    // Back face
+    glNormal3f(0.0f, 0.0f, -1.0f);
+    glVertex3f(-cubeScale, -cubeScale, -cubeScale);
+    glVertex3f(-cubeScale, cubeScale, -cubeScale);
+    glVertex3f(cubeScale, cubeScale, -cubeScale);
+    glVertex3f(cubeScale, -cubeScale, -cubeScale);
+
+    // Top face
+    glNormal3f(0.0f, 1.0f, 0.0f);
+    glVertex3f(-cubeScale, cubeScale, -cubeScale);
+    glVertex3f(-cubeScale, cubeScale, cubeScale);
+    glVertex3f(cubeScale, cubeScale, cubeScale);
+    glVertex3f(cubeScale, cubeScale, -cubeScale);
+
+    // Bottom face
+    glNormal3f(0.0f, -1.0f, 0.0f);
+    glVertex3f(-cubeScale, -cubeScale, -cubeScale);
+    glVertex3f(cubeScale, -cubeScale, -cubeScale);
+    glVertex3f(cubeScale, -cubeScale, cubeScale);
+    glVertex3f(-cubeScale, -cubeScale, cubeScale);
+
+    // Right face
+    glNormal3f(1.0f, 0.0f, 0.0f);
+    glVertex3f(cubeScale, -cubeScale, -cubeScale);
+    glVertex3f(cubeScale, cubeScale, -cubeScale);
+    glVertex3f(cubeScale, cubeScale, cubeScale);
+    glVertex3f(cubeScale, -cubeScale, cubeScale);
+
+    // Left face
+    glNormal3f(-1.0f, 0.0f, 0.0f);
+    glVertex3f(-cubeScale, -cubeScale, -cubeScale);
+    glVertex3f(-cubeScale, -cubeScale, cubeScale);
+    glVertex3f(-cubeScale, cubeScale, cubeScale);
+    glVertex3f(-cubeScale, cubeScale, -cubeScale);
+    glEnd();
+
+    glPopMatrix();
+}
+
+void ImmediateGLBackend::Execute(const RenderCommandList& commands, const DisplayOutput& output) {
+    for (RenderCommandCursor cursor(commands, output); cursor.Current(); cursor.Advance()) {
+        const RenderCommand& command = *cursor.Current();
+        switch (command.type) {
+        case RENDER_CLEAR:
+            Clear(command.argument);
+            break;
+        case RENDER_SET_VIEW:
+            SetView(output);
+            break;
+        case RENDER_DRAW_MESH:
+            DrawCubeImmediate(commands.Draw(command.argument), output);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+RetainedGLBackend::RetainedGLBackend()
+    : uploadedSize(0), genBuffers(NULL), bindBuffer(NULL), bufferData(NULL), deleteBuffers(NULL) {
+    buffers[0] = buffers[1] = 0;
+}
+
+bool RetainedGLBackend::Create(GLProcLoader load, float cubeSize) {
+    buffers[0] = buffers[1] = 0;
+    genBuffers = load("glGenBuffers");
+    bindBuffer = load("glBindBuffer");
+    bufferData = load("glBufferData");
+    deleteBuffers = load("glDeleteBuffers");
+    if (!genBuffers || !bindBuffer || !bufferData || !deleteBuffers) return false;
+
+    ((GenBuffersProc)genBuffers)(2, buffers);
+    Upload(cubeSize);
+    return Valid();
+}
+
+void RetainedGLBackend::Destroy() {
+    if (!Valid()) return;
+    ((DeleteBuffersProc)deleteBuffers)(2, buffers);
+    buffers[0] = buffers[1] = 0;
+}
+
+void RetainedGLBackend::Upload(float cubeSize) {
+    CubeMeshVertex vertices[CUBE_MESH_VERTEX_COUNT];
+    unsigned short indices[CUBE_MESH_INDEX_COUNT];
+    BuildCubeMesh(cubeSize, vertices, indices);
+    BindBufferProc bind = (BindBufferProc)bindBuffer;
+    bind(GL_ARRAY_BUFFER, buffers[0]);
+    ((BufferDataProc)bufferData)(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    bind(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    ((BufferDataProc)bufferData)(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    bind(GL_ARRAY_BUFFER, 0);
+    bind(GL_ELEMENT_ARRAY_BUFFER, 0);
+    uploadedSize = cubeSize;
+}
+
+// The run of draw commands at the cursor, with the buffers bound once for all
+// of them; the cursor is left on the first command after the run
+void RetainedGLBackend::DrawMeshes(const RenderCommandList& commands, RenderCommandCursor& cursor, const DisplayOutput& output) {
+    BindBufferProc bind = (BindBufferProc)bindBuffer;
+    bool bound = false;
+    glPushMatrix();
+    for (; cursor.Current() && cursor.Current()->type == RENDER_DRAW_MESH; cursor.Advance()) {
+        const CubeDraw& draw = commands.Draw(cursor.Current()->argument);
+        if (draw.halfSize != uploadedSize) {
+            Upload(draw.halfSize);
+            bound = false;
+        }
+        if (!bound) {
+            // With a buffer bound, the array pointers are offsets into it
+            bind(GL_ARRAY_BUFFER, buffers[0]);
+            bind(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glEnableClientState(GL_NORMAL_ARRAY);
+            glVertexPointer(3, GL_FLOAT, sizeof(CubeMeshVertex), (const void*)offsetof(CubeMeshVertex, x));
+            glNormalPointer(GL_FLOAT, sizeof(CubeMeshVertex), (const void*)offsetof(CubeMeshVertex, nx));
+            bound = true;
+        }
+        float modelView[16];
+        PlaceCubeDraw(draw, output, modelView);
+        glLoadMatrixf(modelView);
+        glColor3f(draw.r, draw.g, draw.b);
+        glDrawElements(GL_TRIANGLES, CUBE_MESH_INDEX_COUNT, GL_UNSIGNED_SHORT, (const void*)0);
+    }
+    glPopMatrix();
+    if (bound) {
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        bind(GL_ARRAY_BUFFER, 0);
+        bind(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+void RetainedGLBackend::Execute(const RenderCommandList& commands, const DisplayOutput& output) {
+    if (!Valid()) return;
+    RenderCommandCursor cursor(commands, output);
+    while (cursor.Current()) {
+        const RenderCommand& command = *cursor.Current();
+        switch (command.type) {
+        case RENDER_CLEAR:
+            Clear(command.argument);
+            cursor.Advance();
+            break;
+        case RENDER_SET_VIEW:
+            SetView(output);
+            cursor.Advance();
+            break;
+        case RENDER_DRAW_MESH:
+            DrawMeshes(commands, cursor, output);
+            break;
+        default:
+            cursor.Advance();
+            break;
+        }
+    }
+}
+
+// InstancedGLBackend::procs, in this order. The instancing pair falls back to
+// the ARB names for GL 2.x drivers with ARB_instanced_arrays.
+enum InstancedProc {
+    PROC_BUFFER_SUB_DATA, PROC_CREATE_SHADER, PROC_SHADER_SOURCE, PROC_COMPILE_SHADER, PROC_GET_SHADERIV,
+    PROC_CREATE_PROGRAM, PROC_ATTACH_SHADER, PROC_BIND_ATTRIB_LOCATION, PROC_LINK_PROGRAM, PROC_GET_PROGRAMIV,
+    PROC_USE_PROGRAM, PROC_GET_UNIFORM_LOCATION, PROC_UNIFORM_4F, PROC_UNIFORM_1F, PROC_VERTEX_ATTRIB_POINTER,
+    PROC_ENABLE_VERTEX_ATTRIB_ARRAY, PROC_DISABLE_VERTEX_ATTRIB_ARRAY, PROC_VERTEX_ATTRIB_DIVISOR,
+    PROC_DRAW_ELEMENTS_INSTANCED, PROC_DELETE_SHADER, PROC_DELETE_PROGRAM, INSTANCED_PROCS
+};
+
+static const char* const INSTANCED_PROC_NAMES[INSTANCED_PROCS] = {
+    "glBufferSubData", "glCreateShader", "glShaderSource", "glCompileShader", "glGetShaderiv",
+    "glCreateProgram", "glAttachShader", "glBindAttribLocation", "glLinkProgram", "glGetProgramiv",
+    "glUseProgram", "glGetUniformLocation", "glUniform4f", "glUniform1f", "glVertexAttribPointer",
+    "glEnableVertexAttribArray", "glDisableVertexAttribArray", "glVertexAttribDivisor",
+    "glDrawElementsInstanced", "glDeleteShader", "glDeleteProgram",
+};
+
+// Generic attribute locations: the mesh's, then the instance's
+enum InstancedAttribute {
+    ATTRIB_POSITION, ATTRIB_NORMAL, ATTRIB_PLACEMENT, ATTRIB_COLOR, ATTRIB_ROTATION_X, ATTRIB_ROTATION_Y,
+    ATTRIB_ROTATION_Z, INSTANCED_ATTRIBS
+};
+
+static const char* const INSTANCED_ATTRIB_NAMES[INSTANCED_ATTRIBS] = {
+    "position", "normal", "placement", "color", "rotationX", "rotationY", "rotationZ",
+};
+
+// What RenderScene's fixed-function pipeline does with DrawCubeImmediate's
+// matrices: translate into the output as CubeDrawOffset does, rotate, scale,
+// project with the current projection matrix, then light with GL_LIGHT0 along
+// +z and GL_NORMALIZE off, so the normal shrinks with the pulse scale
+static const char* const INSTANCED_VERTEX_SHADER =
+    "#version 120\n"
+    "attribute vec3 position;\n"
+    "attribute vec3 normal;\n"
+    "attribute vec3 placement;\n"  // Desktop x, y, pulse scale
+    "attribute vec3 color;\n"
+    "attribute vec3 rotationX;\n"
+    "attribute vec3 rotationY;\n"
+    "attribute vec3 rotationZ;\n"
+    "uniform vec4 view;\n"  // Left, top, scale x, scale y
+    "uniform float aspect;\n"
+    "varying vec4 litColor;\n"
+    "void main() {\n"
+    "    mat3 rotation = mat3(rotationX, rotationY, rotationZ);\n"
+    "    vec3 offset = vec3((placement.x - view.x) * view.z - 2.0 * aspect, 2.0 - (placement.y - view.y) * view.w, -5.0);\n"
+    "    gl_Position = gl_ProjectionMatrix * vec4(rotation * (position * placement.z) + offset, 1.0);\n"
+    "    float lambert = max((rotation * normal).z / placement.z, 0.0);\n"
+    "    litColor = vec4(clamp(color * (0.4 + 0.8 * lambert), 0.0, 1.0), 1.0);\n"
+    "}\n";
+
+static const char* const INSTANCED_FRAGMENT_SHADER =
+    "#version 120\n"
+    "varying vec4 litColor;\n"
+    "void main() {\n"
+    "    gl_FragColor = litColor;\n"
+    "}\n";
+
+InstancedGLBackend::InstancedGLBackend()
+    : program(0), instanceBuffer(0), instanceCapacity(0), viewLocation(-1), aspectLocation(-1) {
+    static_assert(INSTANCED_PROCS == PROC_COUNT, "InstancedGLBackend::procs does not match InstancedProc");
+    for (int p = 0; p < INSTANCED_PROCS; p++) procs[p] = NULL;
+}
+
+static GLuint CompileShader(void* const* procs, GLenum type, const char* source) {
+    GLuint shader = ((CreateShaderProc)procs[PROC_CREATE_SHADER])(type);
+    ((ShaderSourceProc)procs[PROC_SHADER_SOURCE])(shader, 1, &source, NULL);
+    ((CompileShaderProc)procs[PROC_COMPILE_SHADER])(shader);
+    GLint compiled = 0;
+    ((GetShaderivProc)procs[PROC_GET_SHADERIV])(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled) {
+        ((DeleteObjectProc)procs[PROC_DELETE_SHADER])(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool InstancedGLBackend::Create(GLProcLoader load, float cubeSize) {
+    program = 0;
+    instanceBuffer = 0;
+    instanceCapacity = 0;
+    for (int p = 0; p < INSTANCED_PROCS; p++) procs[p] = load(INSTANCED_PROC_NAMES[p]);
+    if (!procs[PROC_VERTEX_ATTRIB_DIVISOR]) procs[PROC_VERTEX_ATTRIB_DIVISOR] = load("glVertexAttribDivisorARB");
+    if (!procs[PROC_DRAW_ELEMENTS_INSTANCED]) procs[PROC_DRAW_ELEMENTS_INSTANCED] = load("glDrawElementsInstancedARB");
+    for (int p = 0; p < INSTANCED_PROCS; p++) {
+        if (!procs[p]) return false;
+    }
+    if (!RetainedGLBackend::Create(load, cubeSize)) return false;
+
+    GLuint vertexShader = CompileShader(procs, GL_VERTEX_SHADER, INSTANCED_VERTEX_SHADER);
+    GLuint fragmentShader = CompileShader(procs, GL_FRAGMENT_SHADER, INSTANCED_FRAGMENT_SHADER);
+    if (vertexShader && fragmentShader) {
+        program = ((CreateProgramProc)procs[PROC_CREATE_PROGRAM])();
+        ((AttachShaderProc)procs[PROC_ATTACH_SHADER])(program, vertexShader);
+        ((AttachShaderProc)procs[PROC_ATTACH_SHADER])(program, fragmentShader);
+        for (int a = 0; a < INSTANCED_ATTRIBS; a++) {
+            ((BindAttribLocationProc)procs[PROC_BIND_ATTRIB_LOCATION])(program, a, INSTANCED_ATTRIB_NAMES[a]);
+        }
+        ((LinkProgramProc)procs[PROC_LINK_PROGRAM])(program);
+        GLint linked = 0;
+        ((GetProgramivProc)procs[PROC_GET_PROGRAMIV])(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            ((DeleteObjectProc)procs[PROC_DELETE_PROGRAM])(program);
+            program = 0;
+        }
+    }
+    // The program keeps what it needs; the shaders go once it is linked
+    if (vertexShader) ((DeleteObjectProc)procs[PROC_DELETE_SHADER])(vertexShader);
+    if (fragmentShader) ((DeleteObjectProc)procs[PROC_DELETE_SHADER])(fragmentShader);
+    if (!program) {
+        RetainedGLBackend::Destroy();
+        return false;
+    }
+    viewLocation = ((GetUniformLocationProc)procs[PROC_GET_UNIFORM_LOCATION])(program, "view");
+    aspectLocation = ((GetUniformLocationProc)procs[PROC_GET_UNIFORM_LOCATION])(program, "aspect");
+    ((GenBuffersProc)genBuffers)(1, &instanceBuffer);
+    return true;
+}
+
+void InstancedGLBackend::Destroy() {
+    if (program) {
+        ((DeleteObjectProc)procs[PROC_DELETE_PROGRAM])(program);
+        ((DeleteBuffersProc)deleteBuffers)(1, &instanceBuffer);
+        program = 0;
+        instanceBuffer = 0;
+        instanceCapacity = 0;
+    }
+    RetainedGLBackend::Destroy();
+}
+
+// The run of draw commands at the cursor as one instanced draw; the cursor is
+// left on the first command after the run
+void InstancedGLBackend::DrawInstances(const RenderCommandList& commands, RenderCommandCursor& cursor,
+                                       const DisplayOutput& output) {
+    instances.clear();
+    float halfSize = uploadedSize;
+    for (; cursor.Current() && cursor.Current()->type == RENDER_DRAW_MESH; cursor.Advance()) {
+        const CubeDraw& draw = commands.Draw(cursor.Current()->argument);
+        // The mesh is baked at one size; a draw of another size starts a new run
+        if (draw.halfSize != halfSize) {
+            if (!instances.empty()) break;
+            halfSize = draw.halfSize;
+        }
+        Instance instance;
+        instance.x = draw.x;
+        instance.y = draw.y;
+        instance.scale = draw.scale;
+        instance.r = draw.r;
+        instance.g = draw.g;
+        instance.b = draw.b;
+        for (int column = 0; column < 3; column++) {
+            for (int row = 0; row < 3; row++) instance.rotation[column * 3 + row] = draw.rotation[column * 4 + row];
+        }
+        instances.push_back(instance);
+    }
+    if (instances.empty()) return;
+    if (halfSize != uploadedSize) Upload(halfSize);
+
+    // Orphan the buffer, then fill the fresh storage: the driver hands out new
+    // memory instead of waiting for draws still reading the old
+    BindBufferProc bind = (BindBufferProc)bindBuffer;
+    size_t bytes = instances.size() * sizeof(Instance);
+    bind(GL_ARRAY_BUFFER, instanceBuffer);
+    if (bytes > instanceCapacity) instanceCapacity = bytes + bytes / 2;
+    ((BufferDataProc)bufferData)(GL_ARRAY_BUFFER, (ptrdiff_t)instanceCapacity, NULL, GL_STREAM_DRAW);
+    ((BufferSubDataProc)procs[PROC_BUFFER_SUB_DATA])(GL_ARRAY_BUFFER, 0, (ptrdiff_t)bytes, &instances[0]);
+
+    VertexAttribPointerProc pointer = (VertexAttribPointerProc)procs[PROC_VERTEX_ATTRIB_POINTER];
+    VertexAttribArrayProc enable = (VertexAttribArrayProc)procs[PROC_ENABLE_VERTEX_ATTRIB_ARRAY];
+    VertexAttribArrayProc disable = (VertexAttribArrayProc)procs[PROC_DISABLE_VERTEX_ATTRIB_ARRAY];
+    VertexAttribDivisorProc divisor = (VertexAttribDivisorProc)procs[PROC_VERTEX_ATTRIB_DIVISOR];
+    pointer(ATTRIB_PLACEMENT, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (const void*)offsetof(Instance, x));
+    pointer(ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (const void*)offsetof(Instance, r));
+    for (int column = 0; column < 3; column++) {
+        pointer(ATTRIB_ROTATION_X + column, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                (const void*)(offsetof(Instance, rotation) + column * 3 * sizeof(float)));
+    }
+    for (int a = ATTRIB_PLACEMENT; a < INSTANCED_ATTRIBS; a++) divisor(a, 1);
+
+    bind(GL_ARRAY_BUFFER, buffers[0]);
+    bind(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    pointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(CubeMeshVertex), (const void*)offsetof(CubeMeshVertex, x));
+    pointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(CubeMeshVertex), (const void*)offsetof(CubeMeshVertex, nx));
+    for (int a = 0; a < INSTANCED_ATTRIBS; a++) enable(a);
+
+    ((UseProgramProc)procs[PROC_USE_PROGRAM])(program);
+    ((Uniform4fProc)procs[PROC_UNIFORM_4F])(viewLocation, (float)output.view.left, (float)output.view.top,
+                                            output.viewScaleX, output.viewScaleY);
+    ((Uniform1fProc)procs[PROC_UNIFORM_1F])(aspectLocation, output.aspect);
+    ((DrawElementsInstancedProc)procs[PROC_DRAW_ELEMENTS_INSTANCED])(GL_TRIANGLES, CUBE_MESH_INDEX_COUNT,
+                                                                     GL_UNSIGNED_SHORT, (const void*)0,
+                                                                     (GLsizei)instances.size());
+    ((UseProgramProc)procs[PROC_USE_PROGRAM])(0);
+
+    // Leave the fixed-function paths the state they expect
+    for (int a = ATTRIB_PLACEMENT; a < INSTANCED_ATTRIBS; a++) divisor(a, 0);
+    for (int a = 0; a < INSTANCED_ATTRIBS; a++) disable(a);
+    bind(GL_ARRAY_BUFFER, 0);
+    bind(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void InstancedGLBackend::Execute(const RenderCommandList& commands, const DisplayOutput& output) {
+    if (!Valid()) return;
+    RenderCommandCursor cursor(commands, output);
+    while (cursor.Current()) {
+        const RenderCommand& command = *cursor.Current();
+        switch (command.type) {
+        case RENDER_CLEAR:
+            Clear(command.argument);
+            cursor.Advance();
+            break;
+        case RENDER_SET_VIEW:
+            SetView(output);
+            cursor.Advance();
+            break;
+        case RENDER_DRAW_MESH:
+            DrawInstances(commands, cursor, output);
+            break;
+        default:
+            cursor.Advance();
+            break;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "CubeMesh.h"
+#include "CubeRenderBackend.h"
+#include "CubeTopology.h"
+#include <cstddef>
+#include <vector>
+
+// OpenGL backends for the cube scene's command lists (CubeRenderBackend.h),
+// shared by BouncingCubeApp (WGL), the legacy screensaver and the headless GL
+// host (EGL). Everything here works on whatever context is current.
+//
+// There are two ways to draw a cube. ImmediateGLBackend is the original
+// glBegin/glEnd path: 24 vertices and 6 normals sent every frame per cube.
+// RetainedGLBackend uploads the mesh to a vertex and an index buffer once and
+// then draws each cube with one matrix, one color and one glDrawElements.
+// Both leave exactly the same pixels. InstancedGLBackend keeps the same mesh
+// and draws every cube of a frame in one glDrawElementsInstanced, with a small
+// shader standing in for the fixed-function transform and lighting.
+
+// Entry points beyond GL 1.1 come from wglGetProcAddress/eglGetProcAddress
+typedef void* (*GLProcLoader)(const char* name);
+
+// InitOpenGL's fixed-function state: depth test, back faces culled, GL_LIGHT0
+// as a directional light along +z, color material
+void SetupCubeLighting();
+
+// What DrawCube always did, on top of the current modelview
+void DrawCubeImmediate(const CubeDraw& draw, const DisplayOutput& output);
+
+class ImmediateGLBackend : public RenderBackend {
+public:
+    void Execute(const RenderCommandList& commands, const DisplayOutput& output);
+};
+
+class RetainedGLBackend : public RenderBackend {
+public:
+    RetainedGLBackend();
+
+    // Upload the mesh into the current context. False if it has no vertex
+    // buffer objects (GL 1.5), in which case use ImmediateGLBackend.
+    // The buffers belong to the context and go when it is deleted.
+    bool Create(GLProcLoader load, float cubeSize);
+
+    // Free the buffers, with the context current
+    void Destroy();
+
+    bool Valid() const { return buffers[0] != 0; }
+
+    // The mesh is uploaded again first if the cube size changed
+    void Execute(const RenderCommandList& commands, const DisplayOutput& output);
+
+protected:
+    void Upload(float cubeSize);
+
+    unsigned int buffers[2];  // Vertices, indices
+    float uploadedSize;
+
+    // Buffer object entry points, typed in CubeGL.cpp where the GL headers are
+    void* genBuffers;
+    void* bindBuffer;
+    void* bufferData;
+    void* deleteBuffers;
+
+private:
+    void DrawMeshes(const RenderCommandList& commands, RenderCommandCursor& cursor, const DisplayOutput& output);
+};
+
+// The retained mesh drawn once per run of draws with one instance per cube.
+// Each frame the instances (desktop position, pulse scale, color, rotation)
+// are streamed into a buffer that is orphaned first, so the driver never
+// waits for the GPU to finish with the last frame's. The vertex shader maps
+// them into the output and lights them as SetupCubeLighting would, to within
+// rounding.
+class InstancedGLBackend : public RetainedGLBackend {
+public:
+    InstancedGLBackend();
+
+    // The mesh, the instance buffer and the shader in the current context.
+    // False if it lacks GLSL or instanced arrays (GL 3.3 or
+    // ARB_instanced_arrays), in which case use RetainedGLBackend.
+    bool Create(GLProcLoader load, float cubeSize);
+    void Destroy();
+
+    bool Valid() const { return RetainedGLBackend::Valid() && program != 0; }
+
+    void Execute(const RenderCommandList& commands, const DisplayOutput& output);
+
+private:
+    struct Instance {
+        float x, y, scale;  // Desktop pixels, celebration pulse
+        float r, g, b;
+        float rotation[9];  // Columns of the rotation's upper 3x3
+    };
+
+    void DrawInstances(const RenderCommandList& commands, RenderCommandCursor& cursor, const DisplayOutput& output);
+
+    unsigned int program;
+    unsigned int instanceBuffer;
+    size_t instanceCapacity;  // Bytes allocated the last time the buffer was orphaned
+    int viewLocation, aspectLocation;
+    std::vector<Instance> instances;
+
+    // Shader and instancing entry points, typed in CubeGL.cpp
+    static const int PROC_COUNT = 21;
+    void* procs[PROC_COUNT];
+};
@@ -0,0 +1,126 @@
+#include "CubeHeadlessGL.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <vector>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static void* LoadEGLProc(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+HeadlessGLContext::HeadlessGLContext()
+    : display(EGL_NO_DISPLAY), config(NULL), context(EGL_NO_CONTEXT), surface(EGL_NO_SURFACE), width(0), height(0),
+      error("") {
+}
+
+HeadlessGLContext::~HeadlessGLContext() {
+    Destroy();
+}
+
+bool HeadlessGLContext::Create(int newWidth, int newHeight) {
+    Destroy();
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay) {
+        error = "no eglGetPlatformDisplayEXT";
+        return false;
+    }
+    EGLDisplay eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    EGLint major, minor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)) {
+        error = "no surfaceless EGL display";
+        return false;
+    }
+    display = eglDisplay;
+
+    // Desktop GL with the compatibility profile, for the fixed-function
+    // lighting and matrix stack the app uses
+    const EGLint CONFIG[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_DEPTH_SIZE, 24,
+        EGL_NONE,
+    };
+    EGLConfig eglConfig;
+    EGLint configs = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(eglDisplay, CONFIG, &eglConfig, 1, &configs) || configs < 1) {
+        error = "no desktop GL pbuffer config";
+        Destroy();
+        return false;
+    }
+    config = eglConfig;
+
+    context = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, NULL);
+    if (context == EGL_NO_CONTEXT) {
+        error = "eglCreateContext failed";
+        Destroy();
+        return false;
+    }
+    return Resize(newWidth, newHeight);
+}
+
+bool HeadlessGLContext::Resize(int newWidth, int newHeight) {
+    if (context == EGL_NO_CONTEXT) return false;
+    if (surface != EGL_NO_SURFACE && newWidth == width && newHeight == height) return true;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+
+    const EGLint SIZE[] = { EGL_WIDTH, newWidth, EGL_HEIGHT, newHeight, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, SIZE);
+    if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+        error = "no pbuffer surface of that size";
+        Destroy();
+        return false;
+    }
+    width = newWidth;
+    height = newHeight;
+    return true;
+}
+
+void HeadlessGLContext::Destroy() {
+    if (display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+    config = NULL;
+    context = EGL_NO_CONTEXT;
+    surface = EGL_NO_SURFACE;
+    width = height = 0;
+}
+
+const char* HeadlessGLContext::Renderer() const {
+    return (const char*)glGetString(GL_RENDERER);
+}
+
+const char* HeadlessGLContext::Version() const {
+    return (const char*)glGetString(GL_VERSION);
+}
+
+GLProcLoader HeadlessGLContext::Loader() {
+    return LoadEGLProc;
+}
+
+void HeadlessGLContext::Finish() const {
+    glFinish();
+}
+
+void HeadlessGLContext::ReadPixels(SoftwareFramebuffer& framebuffer) const {
+    framebuffer.Resize(width, height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH, framebuffer.Stride());
+
+    // GL's first row is the bottom one
+    std::vector<unsigned int> pixels((size_t)framebuffer.Stride() * height);
+    if (!pixels.empty()) glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    for (int y = 0; y < height; y++) {
+        const unsigned int* in = &pixels[(size_t)(height - 1 - y) * framebuffer.Stride()];
+        unsigned int* out = framebuffer.Row(y);
+        for (int x = 0; x < width; x++) out[x] = in[x] | RASTER_OPAQUE;
+    }
+}
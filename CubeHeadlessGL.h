@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CubeGL.h"
+#include "CubeRaster.h"
+
+// An offscreen OpenGL context with no window system, so the GL render paths
+// can be built, checked and timed on a GPU-less Linux machine: EGL on Mesa's
+// surfaceless platform, usually backed by llvmpipe, rendering into a pbuffer
+// with a 24-bit depth buffer like the app's pixel format.
+
+class HeadlessGLContext {
+public:
+    HeadlessGLContext();
+    ~HeadlessGLContext();
+
+    // Create the context with a width x height surface and make it current
+    // on this thread. False, with Error() saying why, if EGL cannot.
+    bool Create(int width, int height);
+
+    // Replace the surface with one of the new size, keeping the context and
+    // everything uploaded to it
+    bool Resize(int width, int height);
+
+    void Destroy();
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    const char* Error() const { return error; }
+
+    // GL_RENDERER and GL_VERSION of the current context
+    const char* Renderer() const;
+    const char* Version() const;
+
+    // For RetainedGLBackend::Create
+    static GLProcLoader Loader();
+
+    // Wait until everything sent so far has been drawn
+    void Finish() const;
+
+    // Wait for the frame and copy it into `framebuffer`, resized to the
+    // surface, top row first, in the software rasterizer's RGBA layout
+    void ReadPixels(SoftwareFramebuffer& framebuffer) const;
+
+private:
+    void* display;
+    void* config;
+    void* context;
+    void* surface;
+    int width, height;
+    const char* error;
+};
@@ -0,0 +1,584 @@
+#include "CubeImpostor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static const char SPRITE_ATLAS_MAGIC[8] = { 'C', 'U', 'B', 'E', 'S', 'P', 'R', 'T' };
+
+struct SpriteAtlasHeader {
+    char magic[8];
+    unsigned int version;
+    float cubeSize;
+    int outputHeight;
+    int grid;
+    int spriteSize;
+    unsigned int spriteCount;
+    unsigned int runCount;
+    unsigned int reserved;  // Zero; keeps the checksum 8-byte aligned with no padding
+    unsigned long long checksum;  // Of every byte after the header
+};
+
+// Largest Rodrigues coordinate of a rotation reduced by the cube's symmetries
+static const float ZONE_EDGE = 0.41421356f;  // tan(22.5 degrees)
+
+// The 24 rotations taking the cube onto itself, as row-major 3x3 signed
+// permutation matrices with determinant +1
+struct CubeSymmetries {
+    float m[24][9];
+
+    CubeSymmetries() {
+        static const int PERMUTATIONS[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+        static const int PARITY[6] = { 1, -1, -1, 1, 1, -1 };
+        int count = 0;
+        for (int p = 0; p < 6; p++) {
+            for (int signs = 0; signs < 8; signs++) {
+                int s[3] = { signs & 1 ? -1 : 1, signs & 2 ? -1 : 1, signs & 4 ? -1 : 1 };
+                if (PARITY[p] * s[0] * s[1] * s[2] != 1) continue;
+                for (int k = 0; k < 9; k++) m[count][k] = 0.0f;
+                for (int row = 0; row < 3; row++) m[count][row * 3 + PERMUTATIONS[p][row]] = (float)s[row];
+                count++;
+            }
+        }
+    }
+};
+
+static const CubeSymmetries SYMMETRIES;
+
+// floorf and ceilf are library calls without SSE4.1, and the stretched blit
+// needs several per run
+static int FloorToInt(float v) {
+    int i = (int)v;
+    return i - (v < (float)i);
+}
+
+static int CeilToInt(float v) {
+    int i = (int)v;
+    return i + (v > (float)i);
+}
+
+static int SpriteCell(float r, int grid) {
+    int cell = (int)floorf((r + ZONE_EDGE) / (2.0f * ZONE_EDGE) * grid);
+    return std::min(std::max(cell, 0), grid - 1);
+}
+
+// The rotation (column-major, as GetCubeRotationMatrix) at Rodrigues vector (x, y, z)
+static void RodriguesMatrix(float x, float y, float z, float m[16]) {
+    float k = 2.0f / (1.0f + x * x + y * y + z * z);
+    float r[3] = { x, y, z };
+    float skew[9] = { 0, -z, y, z, 0, -x, -y, x, 0 };
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            float identity = row == col ? 1.0f : 0.0f;
+            float outer = r[row] * r[col] - (row == col ? x * x + y * y + z * z : 0.0f);
+            m[col * 4 + row] = identity + k * (skew[row * 3 + col] + outer);
+        }
+        m[row * 4 + 3] = 0.0f;
+        m[12 + row] = 0.0f;
+    }
+    m[15] = 1.0f;
+}
+
+CubeSpriteAtlas::CubeSpriteAtlas() : spriteSize(0) {
+    key.cubeSize = 0.0f;
+    key.outputHeight = 0;
+    key.grid = 0;
+}
+
+// The symmetry leaving `rotation` least turned, which maximizes the trace
+static int ClosestSymmetry(const float rotation[16]) {
+    int best = 0;
+    float bestTrace = -4.0f;
+    for (int s = 0; s < 24; s++) {
+        const float* g = SYMMETRIES.m[s];
+        float trace = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            for (int k = 0; k < 3; k++) trace += rotation[k * 4 + i] * g[k * 3 + i];
+        }
+        if (trace > bestTrace) {
+            bestTrace = trace;
+            best = s;
+        }
+    }
+    return best;
+}
+
+// `rotation` times a symmetry, column-major like `rotation`
+static void ApplySymmetry(const float rotation[16], int symmetry, float turned[16]) {
+    const float* g = SYMMETRIES.m[symmetry];
+    for (int col = 0; col < 3; col++) {
+        for (int row = 0; row < 3; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 3; k++) sum += rotation[k * 4 + row] * g[k * 3 + col];
+            turned[col * 4 + row] = sum;
+        }
+        turned[col * 4 + 3] = 0.0f;
+        turned[12 + col] = 0.0f;
+    }
+    turned[15] = 1.0f;
+}
+
+// `rotation` as seen by a viewer looking straight at a cube centered at
+// (relX, relY, -5): turned by the rotation taking that direction onto -z
+static void TurnTowardViewer(const float rotation[16], float relX, float relY, float seen[16]) {
+    float distance = sqrtf(relX * relX + relY * relY + 25.0f);
+    float dx = relX / distance, dy = relY / distance;
+    float sine = sqrtf(dx * dx + dy * dy);
+    float cosine = 5.0f / distance;
+    float turn[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    if (sine > 1e-6f) {
+        // Rodrigues' formula about the unit axis (-dy, dx, 0) / sine
+        float ax = -dy / sine, ay = dx / sine;
+        float skew[9] = { 0, 0, ay, 0, 0, -ax, -ay, ax, 0 };
+        for (int row = 0; row < 3; row++) {
+            for (int col = 0; col < 3; col++) {
+                float square = 0.0f;
+                for (int k = 0; k < 3; k++) square += skew[row * 3 + k] * skew[k * 3 + col];
+                turn[row * 3 + col] += sine * skew[row * 3 + col] + (1.0f - cosine) * square;
+            }
+        }
+    }
+    for (int col = 0; col < 3; col++) {
+        for (int row = 0; row < 3; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 3; k++) sum += turn[row * 3 + k] * rotation[col * 4 + k];
+            seen[col * 4 + row] = sum;
+        }
+        seen[col * 4 + 3] = 0.0f;
+        seen[12 + col] = 0.0f;
+    }
+    seen[15] = 1.0f;
+}
+
+size_t CubeSpriteAtlas::SpriteIndex(const float reduced[16]) const {
+    float denominator = 1.0f + reduced[0] + reduced[5] + reduced[10];
+    float x = (reduced[6] - reduced[9]) / denominator;
+    float y = (reduced[8] - reduced[2]) / denominator;
+    float z = (reduced[1] - reduced[4]) / denominator;
+    int grid = key.grid;
+    return ((size_t)SpriteCell(z, grid) * grid + SpriteCell(y, grid)) * grid + SpriteCell(x, grid);
+}
+
+void CubeSpriteAtlas::Build(const CubeSpriteKey& buildKey) {
+    key = buildKey;
+    int grid = key.grid;
+    size_t count = (size_t)grid * grid * grid;
+
+    // Each sample drawn in the middle of a square output of the key's height,
+    // first projected to find the square every sprite fits in
+    int height = key.outputHeight;
+    DisplayOutput output;
+    output.bounds.left = output.bounds.top = 0;
+    output.bounds.right = output.bounds.bottom = height;
+    output.width = output.height = height;
+    output.aspect = 1.0f;
+    output.primary = true;
+    output.index = 0;
+    output.imageSource = 0;
+    SetOutputView(output, output.bounds);
+    float middle = height * 0.5f;
+
+    std::vector<RasterTriangle> triangles(count * 12);
+    std::vector<int> faces(count * 12);
+    std::vector<int> triangleCounts(count);
+    float extent = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        int cx = (int)(i % grid), cy = (int)(i / grid % grid), cz = (int)(i / grid / grid);
+        float step = 2.0f * ZONE_EDGE / grid;
+        CubeDraw draw;
+        draw.x = draw.y = middle;
+        RodriguesMatrix(-ZONE_EDGE + (cx + 0.5f) * step, -ZONE_EDGE + (cy + 0.5f) * step, -ZONE_EDGE + (cz + 0.5f) * step,
+                        draw.rotation);
+        draw.scale = 1.0f;
+        draw.halfSize = key.cubeSize;
+        draw.reach = GetCubeSizeInPixels(key.cubeSize);
+        draw.r = draw.g = draw.b = 1.0f;
+        triangleCounts[i] = ProjectCubeDraw(draw, output, &triangles[i * 12], &faces[i * 12]);
+        for (int t = 0; t < triangleCounts[i]; t++) {
+            for (int v = 0; v < 3; v++) {
+                extent = std::max(extent, fabsf(triangles[i * 12 + t].v[v].x - middle));
+                extent = std::max(extent, fabsf(triangles[i * 12 + t].v[v].y - middle));
+            }
+        }
+    }
+    int half = (int)ceilf(extent) + 1;
+    spriteSize = half * 2;
+
+    // Then rasterized with each face's index for a color, and cut into runs
+    sprites.assign(count, CubeSprite());
+    runs.clear();
+    SoftwareFramebuffer framebuffer;
+    framebuffer.Resize(spriteSize, spriteSize);
+    float shift = half - middle;
+    for (size_t i = 0; i < count; i++) {
+        framebuffer.Clear(0);
+        for (int t = 0; t < triangleCounts[i]; t++) {
+            RasterTriangle triangle = triangles[i * 12 + t];
+            for (int v = 0; v < 3; v++) {
+                triangle.v[v].x += shift;
+                triangle.v[v].y += shift;
+            }
+            triangle.color = (unsigned int)faces[i * 12 + t] + 1;
+            RasterizeTriangle(framebuffer, triangle);
+        }
+
+        sprites[i].firstRun = (unsigned int)runs.size();
+        for (int y = 0; y < spriteSize; y++) {
+            const unsigned int* row = framebuffer.Row(y);
+            for (int x = 0; x < spriteSize;) {
+                unsigned int face = row[x];
+                int end = x + 1;
+                while (end < spriteSize && row[end] == face) end++;
+                if (face != 0) {
+                    SpriteRun run = { (unsigned short)x, (unsigned short)y, (unsigned short)(end - x), (unsigned short)(face - 1) };
+                    runs.push_back(run);
+                }
+                x = end;
+            }
+        }
+        sprites[i].runCount = (unsigned int)runs.size() - sprites[i].firstRun;
+    }
+    MeasureSprites();
+}
+
+void CubeSpriteAtlas::MeasureSprites() {
+    bounds.resize(sprites.size());
+    for (size_t i = 0; i < sprites.size(); i++) {
+        RasterRect rect = { spriteSize, spriteSize, 0, 0 };
+        for (unsigned int k = 0; k < sprites[i].runCount; k++) {
+            const SpriteRun& run = runs[sprites[i].firstRun + k];
+            rect.left = std::min(rect.left, (int)run.x);
+            rect.top = std::min(rect.top, (int)run.y);
+            rect.right = std::max(rect.right, (int)run.x + run.length);
+            rect.bottom = std::max(rect.bottom, (int)run.y + 1);
+        }
+        if (rect.left >= rect.right) rect.left = rect.top = rect.right = rect.bottom = 0;
+        bounds[i] = rect;
+    }
+}
+
+bool CubeSpriteAtlas::Covers(const CubeDraw& draw, const DisplayOutput& output) const {
+    return !sprites.empty() && draw.scale == 1.0f && draw.halfSize == key.cubeSize && output.height == key.outputHeight;
+}
+
+void CubeSpriteAtlas::Blit(SoftwareFramebuffer& framebuffer, const CubeDraw& draw, const DisplayOutput& output,
+                           RasterRect& drawn, std::vector<unsigned int>& rowStarts) const {
+    // Away from the middle of the view the cube is seen along a slanted ray.
+    // Turned so that ray is the view axis it matches a sprite, which the slant
+    // then stretches by 1 / cos(slant) along the ray's direction on screen.
+    float relX, relY;
+    CubeDrawOffset(draw, output, relX, relY);
+    float seen[16], reduced[16], lit[16];
+    TurnTowardViewer(draw.rotation, relX, relY, seen);
+    int symmetry = ClosestSymmetry(seen);
+    ApplySymmetry(seen, symmetry, reduced);
+    size_t index = SpriteIndex(reduced);
+    const CubeSprite& sprite = sprites[index];
+    const RasterRect& spriteBounds = bounds[index];
+
+    // The sprite's faces are the ones that symmetry gives the real cube, lit
+    // as its real orientation lights them
+    ApplySymmetry(draw.rotation, symmetry, lit);
+    unsigned int colors[6];
+    for (int face = 0; face < 6; face++) colors[face] = LitCubeColor(draw.r, draw.g, draw.b, CubeFaceIntensity(lit, face, 1.0f));
+
+    float centerX, centerY;
+    ProjectCubeCenter(draw, output, centerX, centerY);
+    int half = spriteSize / 2;
+    int width = framebuffer.Width(), height = framebuffer.Height();
+    float slant = sqrtf(relX * relX + relY * relY);
+    float stretch = sqrtf(slant * slant + 25.0f) / 5.0f;
+
+    if (stretch < 1.0005f) {
+        // Close enough to the middle to copy the sprite's runs as they are
+        int left = (int)floorf(centerX - half + 0.5f);
+        int top = (int)floorf(centerY - half + 0.5f);
+        drawn.left = std::max(left + spriteBounds.left, 0);
+        drawn.top = std::max(top + spriteBounds.top, 0);
+        drawn.right = std::min(left + spriteBounds.right, width);
+        drawn.bottom = std::min(top + spriteBounds.bottom, height);
+        if (drawn.left >= drawn.right || drawn.top >= drawn.bottom) {
+            drawn.left = drawn.top = drawn.right = drawn.bottom = 0;
+            return;
+        }
+        const SpriteRun* run = &runs[sprite.firstRun];
+        for (unsigned int k = 0; k < sprite.runCount; k++, run++) {
+            int y = top + run->y;
+            if (y < drawn.top || y >= drawn.bottom) continue;
+            int from = std::max(left + run->x, drawn.left);
+            int to = std::min(left + run->x + run->length, drawn.right);
+            if (from < to) std::fill(framebuffer.Row(y) + from, framebuffer.Row(y) + to, colors[run->face]);
+        }
+        return;
+    }
+
+    // Otherwise map each pixel back through the stretch. Screen y points
+    // down, so the ray's direction there is (relX, -relY).
+    float ux = relX / slant, uy = -relY / slant;
+    float grow = stretch - 1.0f, shrink = 1.0f / stretch - 1.0f;
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    for (int corner = 0; corner < 4; corner++) {
+        float qx = (corner & 1 ? spriteBounds.right : spriteBounds.left) - (float)half;
+        float qy = (corner & 2 ? spriteBounds.bottom : spriteBounds.top) - (float)half;
+        float along = (qx * ux + qy * uy) * grow;
+        minX = std::min(minX, qx + along * ux);
+        maxX = std::max(maxX, qx + along * ux);
+        minY = std::min(minY, qy + along * uy);
+        maxY = std::max(maxY, qy + along * uy);
+    }
+    drawn.left = std::max((int)floorf(centerX + minX), 0);
+    drawn.top = std::max((int)floorf(centerY + minY), 0);
+    drawn.right = std::min((int)ceilf(centerX + maxX), width);
+    drawn.bottom = std::min((int)ceilf(centerY + maxY), height);
+    if (drawn.left >= drawn.right || drawn.top >= drawn.bottom) {
+        drawn.left = drawn.top = drawn.right = drawn.bottom = 0;
+        return;
+    }
+
+    // Where each sprite row's runs start; runs are stored top row first
+    rowStarts.assign(spriteSize + 1, sprite.runCount);
+    for (unsigned int k = sprite.runCount; k-- > 0;) rowStarts[runs[sprite.firstRun + k].y] = k;
+    for (int y = spriteSize; y-- > 0;) rowStarts[y] = std::min(rowStarts[y], rowStarts[y + 1]);
+
+    // Along a screen row the samples walk a line through the sprite that
+    // crosses only a few of its rows. Within one sprite row they step evenly
+    // in x, so each of that row's runs fills a span of the screen row.
+    float stepX = 1.0f + shrink * ux * ux, stepY = shrink * ux * uy;
+    float perStepX = 1.0f / stepX, perStepY = fabsf(stepY) > 1e-6f ? 1.0f / stepY : 0.0f;
+    int across = drawn.right - drawn.left;
+    for (int y = drawn.top; y < drawn.bottom; y++) {
+        unsigned int* row = framebuffer.Row(y) + drawn.left;
+        float qx = drawn.left + 0.5f - centerX, qy = y + 0.5f - centerY;
+        float along = (qx * ux + qy * uy) * shrink;
+        float startX = qx + along * ux + half, startY = qy + along * uy + half;
+        for (int x = 0; x < across;) {
+            int spriteRow = FloorToInt(startY + x * stepY);
+            int end = across;
+            if (perStepY > 0.0f) {
+                end = std::min(end, CeilToInt((spriteRow + 1 - startY) * perStepY));
+            } else if (perStepY < 0.0f) {
+                end = std::min(end, FloorToInt((spriteRow - startY) * perStepY) + 1);
+            }
+            end = std::max(end, x + 1);
+            if (spriteRow >= 0 && spriteRow < spriteSize) {
+                for (unsigned int k = rowStarts[spriteRow]; k < rowStarts[spriteRow + 1]; k++) {
+                    const SpriteRun& run = runs[sprite.firstRun + k];
+                    int from = std::max(CeilToInt((run.x - startX) * perStepX), x);
+                    int to = std::min(CeilToInt((run.x + run.length - startX) * perStepX), end);
+                    if (from < to) std::fill(row + from, row + to, colors[run.face]);
+                }
+            }
+            x = end;
+        }
+    }
+}
+
+static unsigned long long SpriteAtlasChecksum(const unsigned char* data, size_t bytes) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < bytes; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool CubeSpriteAtlas::Save(const char* path) const {
+    size_t spriteBytes = sprites.size() * sizeof(CubeSprite);
+    size_t runBytes = runs.size() * sizeof(SpriteRun);
+    std::vector<unsigned char> buffer(sizeof(SpriteAtlasHeader) + spriteBytes + runBytes);
+    unsigned char* body = &buffer[0] + sizeof(SpriteAtlasHeader);
+    if (spriteBytes) memcpy(body, &sprites[0], spriteBytes);
+    if (runBytes) memcpy(body + spriteBytes, &runs[0], runBytes);
+
+    SpriteAtlasHeader header;
+    memcpy(header.magic, SPRITE_ATLAS_MAGIC, sizeof(header.magic));
+    header.version = CUBE_SPRITE_ATLAS_VERSION;
+    header.cubeSize = key.cubeSize;
+    header.outputHeight = key.outputHeight;
+    header.grid = key.grid;
+    header.spriteSize = spriteSize;
+    header.spriteCount = (unsigned int)sprites.size();
+    header.runCount = (unsigned int)runs.size();
+    header.reserved = 0;
+    header.checksum = SpriteAtlasChecksum(body, spriteBytes + runBytes);
+    memcpy(&buffer[0], &header, sizeof(header));
+
+    // Preview and fullscreen instances may share the file, so write aside,
+    // to a name of this process's own, and rename
+#ifdef _WIN32
+    unsigned long process = GetCurrentProcessId();
+#else
+    unsigned long process = (unsigned long)getpid();
+#endif
+    std::string temporary = std::string(path) + "." + std::to_string(process) + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    bool written = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        remove(temporary.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    if (!MoveFileExA(temporary.c_str(), path, MOVEFILE_REPLACE_EXISTING)) {
+#else
+    if (rename(temporary.c_str(), path) != 0) {
+#endif
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CubeSpriteAtlas::Load(const char* path, const CubeSpriteKey& wanted) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    std::vector<unsigned char> bytes;
+    unsigned char chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) bytes.insert(bytes.end(), chunk, chunk + got);
+    bool ok = !ferror(file);
+    fclose(file);
+    if (!ok || bytes.size() < sizeof(SpriteAtlasHeader)) return false;
+
+    SpriteAtlasHeader header;
+    memcpy(&header, &bytes[0], sizeof(header));
+    if (memcmp(header.magic, SPRITE_ATLAS_MAGIC, sizeof(header.magic)) != 0 || header.version != CUBE_SPRITE_ATLAS_VERSION) return false;
+    if (memcmp(&header.cubeSize, &wanted.cubeSize, sizeof(float)) != 0 || header.outputHeight != wanted.outputHeight ||
+        header.grid != wanted.grid || wanted.grid <= 0) {
+        return false;
+    }
+    size_t count = (size_t)wanted.grid * wanted.grid * wanted.grid;
+    size_t body = bytes.size() - sizeof(SpriteAtlasHeader);
+    if (header.spriteCount != count || header.spriteSize <= 0 || header.spriteSize > 65535 ||
+        body != count * sizeof(CubeSprite) + (size_t)header.runCount * sizeof(SpriteRun)) {
+        return false;
+    }
+    const unsigned char* data = &bytes[0] + sizeof(SpriteAtlasHeader);
+    if (SpriteAtlasChecksum(data, body) != header.checksum) return false;
+
+    std::vector<CubeSprite> loadedSprites(count);
+    std::vector<SpriteRun> loadedRuns(header.runCount);
+    memcpy(&loadedSprites[0], data, count * sizeof(CubeSprite));
+    if (header.runCount) memcpy(&loadedRuns[0], data + count * sizeof(CubeSprite), header.runCount * sizeof(SpriteRun));
+
+    // A checksum catches damage, not a writer with other ideas: every run must
+    // stay inside its sprite
+    for (size_t i = 0; i < count; i++) {
+        const CubeSprite& sprite = loadedSprites[i];
+        if (sprite.firstRun > header.runCount || sprite.runCount > header.runCount - sprite.firstRun) return false;
+        for (unsigned int k = 0; k < sprite.runCount; k++) {
+            const SpriteRun& run = loadedRuns[sprite.firstRun + k];
+            if (run.face >= 6 || run.y >= header.spriteSize || run.x + run.length > header.spriteSize) return false;
+        }
+    }
+
+    key = wanted;
+    spriteSize = header.spriteSize;
+    sprites.swap(loadedSprites);
+    runs.swap(loadedRuns);
+    MeasureSprites();
+    return true;
+}
+
+CubeSpriteAtlasLoader::CubeSpriteAtlasLoader() : ready(false), fromCache(false) {
+    key.cubeSize = 0.0f;
+    key.outputHeight = 0;
+    key.grid = 0;
+}
+
+CubeSpriteAtlasLoader::~CubeSpriteAtlasLoader() {
+    if (thread.joinable()) thread.join();
+}
+
+void CubeSpriteAtlasLoader::Start(const CubeSpriteKey& wanted, const std::string& cachePath) {
+    if (thread.joinable()) return;
+    key = wanted;
+    thread = std::thread([this, cachePath]() {
+        fromCache = !cachePath.empty() && atlas.Load(cachePath.c_str(), key);
+        if (!fromCache) {
+            atlas.Build(key);
+            if (!cachePath.empty()) atlas.Save(cachePath.c_str());
+        }
+        ready.store(true, std::memory_order_release);
+    });
+}
+
+ImpostorRenderBackend::ImpostorRenderBackend()
+    : atlas(NULL), cleared(false), clearColor(0), wholeDirty(true), outputIndex(-1), spritesDrawn(0), exactDraws(0) {
+}
+
+void ImpostorRenderBackend::Touch(const RasterRect& rect) {
+    if (rect.left >= rect.right || rect.top >= rect.bottom) return;
+    drawn.push_back(rect);
+    if (!wholeDirty) dirty.push_back(rect);
+}
+
+void ImpostorRenderBackend::Execute(const RenderCommandList& commands, const DisplayOutput& output) {
+    for (RenderCommandCursor cursor(commands, output); cursor.Current(); cursor.Advance()) {
+        const RenderCommand& command = *cursor.Current();
+        switch (command.type) {
+        case RENDER_CLEAR:
+            dirty.clear();
+            if (!cleared || outputIndex != output.index || framebuffer.Width() != output.width ||
+                framebuffer.Height() != output.height || clearColor != command.argument) {
+                framebuffer.Resize(output.width, output.height);
+                framebuffer.Clear(command.argument);
+                clearColor = command.argument;
+                outputIndex = output.index;
+                cleared = true;
+                wholeDirty = true;
+                RasterRect whole = { 0, 0, output.width, output.height };
+                dirty.push_back(whole);
+            } else {
+                // Everything else still holds the clear color
+                wholeDirty = false;
+                for (size_t r = 0; r < drawn.size(); r++) {
+                    framebuffer.ClearRect(drawn[r], clearColor);
+                    dirty.push_back(drawn[r]);
+                }
+            }
+            drawn.clear();
+            break;
+        case RENDER_SET_VIEW:
+            break;  // Sprites and ProjectCubeDraw both use RenderScene's projection
+        case RENDER_DRAW_MESH:
+            {
+                const CubeDraw& draw = commands.Draw(command.argument);
+                RasterRect rect;
+                if (atlas && atlas->Covers(draw, output)) {
+                    atlas->Blit(framebuffer, draw, output, rect, rowStarts);
+                    spritesDrawn++;
+                } else {
+                    RasterTriangle triangles[12];
+                    int count = ProjectCubeDraw(draw, output, triangles);
+                    float minX = (float)output.width, minY = (float)output.height, maxX = 0.0f, maxY = 0.0f;
+                    for (int t = 0; t < count; t++) {
+                        RasterizeTriangle(framebuffer, triangles[t]);
+                        for (int v = 0; v < 3; v++) {
+                            minX = std::min(minX, triangles[t].v[v].x);
+                            minY = std::min(minY, triangles[t].v[v].y);
+                            maxX = std::max(maxX, triangles[t].v[v].x);
+                            maxY = std::max(maxY, triangles[t].v[v].y);
+                        }
+                    }
+                    rect.left = std::max((int)floorf(minX), 0);
+                    rect.top = std::max((int)floorf(minY), 0);
+                    rect.right = std::min((int)ceilf(maxX) + 1, output.width);
+                    rect.bottom = std::min((int)ceilf(maxY) + 1, output.height);
+                    exactDraws++;
+                }
+                Touch(rect);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
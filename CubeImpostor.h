@@ -0,0 +1,168 @@
+#pragma once
+
+#include "CubeRenderBackend.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Impostor rendering: the cube drawn from sprites rendered ahead of time, so a
+// frame costs a few row fills per cube instead of projecting and rasterizing.
+//
+// What the cube looks like in the middle of an output depends only on its size
+// in pixels, which the projection fixes from the cube size and the output's
+// height, and on its orientation up to the cube's 24 rotational symmetries.
+// Turned by the symmetry that leaves it closest to unrotated, every orientation
+// lies within 62.8 degrees of the identity, in the cube of Rodrigues vectors
+// (axis times tan(angle / 2)) with coordinates up to tan(22.5 degrees). A sprite
+// atlas samples that cube on a grid and rasterizes each sample once with the
+// software rasterizer, keeping each row as runs of one face.
+//
+// Drawing a cube finds the sample nearest its reduced orientation and fills the
+// sprite's runs, each face lit for the cube's actual orientation and tinted by
+// its color, so face colors come out as ProjectCubeDraw's. Away from the middle
+// of the view, perspective shows the cube along a slanted ray: the sprite is
+// picked for the cube turned to face the viewer and stretched along the ray's
+// direction on screen, which follows the true picture to within a pixel or so.
+// What remains is the orientation grid's step, a few percent of the cube's
+// pixels along its edges (BouncingCubeBench impostor measures it). Sprites are
+// not depth-tested: overlapping cubes are painted in draw order.
+
+const unsigned int CUBE_SPRITE_ATLAS_VERSION = 1;
+
+// Samples per Rodrigues axis, so SPRITE_GRID^3 sprites. Neighbouring samples
+// are 7.9 degrees apart at the identity and closer further out, so no
+// orientation is more than 7 degrees from its sprite's.
+const int SPRITE_GRID = 12;
+
+// What an atlas was built for; a cached atlas is only used for the same key
+struct CubeSpriteKey {
+    float cubeSize;  // CubeSettings::cubeSize
+    int outputHeight;  // Pixels; with the cube size this fixes the cube's size on screen
+    int grid;  // SPRITE_GRID unless a caller wants a coarser or finer atlas
+};
+
+// One row of one face of a sprite, in pixels from the sprite's top-left corner
+struct SpriteRun {
+    unsigned short x, y, length;
+    unsigned short face;  // CUBE_MESH_FACES index, lit per cube when drawn
+};
+
+struct CubeSprite {
+    unsigned int firstRun, runCount;  // Into the atlas's runs, top row first
+};
+
+class CubeSpriteAtlas {
+public:
+    CubeSpriteAtlas();
+
+    // Render every sprite for `key`: grid^3 small rasterizations, a fraction of
+    // a second at the default grid
+    void Build(const CubeSpriteKey& key);
+
+    // Versioned binary file, written aside and renamed like world snapshots.
+    // False on any I/O error.
+    bool Save(const char* path) const;
+
+    // False, leaving the atlas as it was, if `path` is missing, from another
+    // version, built for another key, truncated or fails its checksum
+    bool Load(const char* path, const CubeSpriteKey& key);
+
+    bool Empty() const { return sprites.empty(); }
+    const CubeSpriteKey& Key() const { return key; }
+    size_t SpriteCount() const { return sprites.size(); }
+    size_t RunCount() const { return runs.size(); }
+    size_t Bytes() const { return sprites.size() * sizeof(CubeSprite) + runs.size() * sizeof(SpriteRun); }
+    int SpriteSize() const { return spriteSize; }  // Edge of the square every sprite fits in
+
+    // Whether this atlas can stand in for `draw` in `output`: same cube size
+    // and output height, and not pulsed by a celebration
+    bool Covers(const CubeDraw& draw, const DisplayOutput& output) const;
+
+    // Draw the sprite nearest `draw` into `framebuffer`, centered where the
+    // cube's center projects. `drawn` gets the pixels written, clipped to the
+    // framebuffer; empty if none were. `rowStarts` is scratch space, the
+    // caller's so several threads can blit from one atlas. Covers(draw, output)
+    // must hold.
+    void Blit(SoftwareFramebuffer& framebuffer, const CubeDraw& draw, const DisplayOutput& output, RasterRect& drawn,
+              std::vector<unsigned int>& rowStarts) const;
+
+private:
+    void MeasureSprites();
+    size_t SpriteIndex(const float reduced[16]) const;  // Of the sample nearest a reduced rotation
+
+    CubeSpriteKey key;
+    int spriteSize;
+    std::vector<CubeSprite> sprites;
+    std::vector<SpriteRun> runs;
+    std::vector<RasterRect> bounds;  // Per sprite, the pixels its runs cover
+};
+
+// Loads an atlas from its cache file, or builds and caches it, on a thread of
+// its own so startup never waits for it
+class CubeSpriteAtlasLoader {
+public:
+    CubeSpriteAtlasLoader();
+    ~CubeSpriteAtlasLoader();
+
+    void Start(const CubeSpriteKey& key, const std::string& cachePath);
+
+    // The atlas once it is ready, NULL until then. Any thread.
+    const CubeSpriteAtlas* Ready() const { return ready.load(std::memory_order_acquire) ? &atlas : NULL; }
+
+    const CubeSpriteKey& Key() const { return key; }
+    bool LoadedFromCache() const { return fromCache; }  // Valid once Ready
+
+private:
+    CubeSpriteAtlasLoader(const CubeSpriteAtlasLoader&);
+    CubeSpriteAtlasLoader& operator=(const CubeSpriteAtlasLoader&);
+
+    CubeSpriteKey key;
+    CubeSpriteAtlas atlas;
+    std::thread thread;
+    std::atomic<bool> ready;
+    bool fromCache;
+};
+
+// Replays command lists into memory like SoftwareRenderBackend, but draws
+// every cube an atlas covers as a sprite; the rest, and every cube until an
+// atlas is set, are rasterized exactly.
+//
+// Frames after the first only clear what the last frame drew, so the cost of
+// a frame is the cubes' pixels, not the output's. DirtyRects says what changed
+// for a present that copies only those parts to the screen.
+class ImpostorRenderBackend : public RenderBackend {
+public:
+    ImpostorRenderBackend();
+
+    // NULL rasterizes everything. The atlas must outlive its use here.
+    void SetAtlas(const CubeSpriteAtlas* atlas) { this->atlas = atlas; }
+
+    void Execute(const RenderCommandList& commands, const DisplayOutput& output);
+    const SoftwareFramebuffer& Framebuffer() const { return framebuffer; }
+
+    // Parts of the framebuffer the last Execute changed: the whole of it after
+    // a resize, a new clear color or Invalidate
+    const std::vector<RasterRect>& DirtyRects() const { return dirty; }
+
+    // The next Execute clears and reports the whole framebuffer, e.g. because
+    // the window it is presented to was uncovered
+    void Invalidate() { cleared = false; }
+
+    long long SpritesDrawn() const { return spritesDrawn; }
+    long long ExactDraws() const { return exactDraws; }
+
+private:
+    void Touch(const RasterRect& rect);
+
+    SoftwareFramebuffer framebuffer;
+    const CubeSpriteAtlas* atlas;
+    bool cleared;  // The framebuffer holds clearColor everywhere outside `drawn`
+    unsigned int clearColor;
+    std::vector<RasterRect> drawn;  // What the cubes of the last frame covered
+    std::vector<RasterRect> dirty;
+    bool wholeDirty;
+    int outputIndex;  // DisplayOutput::index the framebuffer holds; one backend serves one output at a time
+    long long spritesDrawn, exactDraws;
+    std::vector<unsigned int> rowStarts;  // Scratch for CubeSpriteAtlas::Blit
+};
@@ -0,0 +1,67 @@
+#include "CubeMesh.h"
+#include <cmath>
+
+const float CUBE_MESH_FACES[6][5][3] = {
+    { { 0, 0, 1 }, { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 } },
+    { { 0, 0, -1 }, { -1, -1, -1 }, { -1, 1, -1 }, { 1, 1, -1 }, { 1, -1, -1 } },
+    { { 0, 1, 0 }, { -1, 1, -1 }, { -1, 1, 1 }, { 1, 1, 1 }, { 1, 1, -1 } },
+    { { 0, -1, 0 }, { -1, -1, -1 }, { 1, -1, -1 }, { 1, -1, 1 }, { -1, -1, 1 } },
+    { { 1, 0, 0 }, { 1, -1, -1 }, { 1, 1, -1 }, { 1, 1, 1 }, { 1, -1, 1 } },
+    { { -1, 0, 0 }, { -1, -1, -1 }, { -1, -1, 1 }, { -1, 1, 1 }, { -1, 1, -1 } },
+};
+
+void BuildCubeMesh(float halfSize, CubeMeshVertex vertices[CUBE_MESH_VERTEX_COUNT],
+                   unsigned short indices[CUBE_MESH_INDEX_COUNT]) {
+    for (int face = 0; face < 6; face++) {
+        const float* n = CUBE_MESH_FACES[face][0];
+        for (int k = 0; k < 4; k++) {
+            const float* p = CUBE_MESH_FACES[face][k + 1];
+            CubeMeshVertex& v = vertices[face * 4 + k];
+            v.x = p[0] * halfSize;
+            v.y = p[1] * halfSize;
+            v.z = p[2] * halfSize;
+            v.nx = n[0];
+            v.ny = n[1];
+            v.nz = n[2];
+        }
+        static const unsigned short QUAD[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i = 0; i < 6; i++) indices[face * 6 + i] = (unsigned short)(face * 4 + QUAD[i]);
+    }
+}
+
+void DescribeCubeDraw(const Cube& cube, float cubeSize, CubeDraw& draw) {
+    draw.x = cube.x;
+    draw.y = cube.y;
+    GetCubeRotationMatrix(cube, draw.rotation);
+    draw.halfSize = cubeSize;
+    draw.reach = GetCubeSizeInPixels(cubeSize);
+    draw.r = CUBE_R(cube.color) / 255.0f;
+    draw.g = CUBE_G(cube.color) / 255.0f;
+    draw.b = CUBE_B(cube.color) / 255.0f;
+    draw.scale = 1.0f;
+    if (cube.celebratingCorner) {
+        float pulse = (sin(cube.celebrationTimer * 0.3f) + 1.0f) / 2.0f;
+        draw.r = draw.r * 0.5f + pulse * 0.5f;
+        draw.g = draw.g * 0.5f + pulse * 0.5f;
+        draw.b = draw.b * 0.5f + pulse * 0.5f;
+        draw.scale = 1.0f + pulse * 0.2f;
+    }
+}
+
+void CubeDrawOffset(const CubeDraw& draw, const DisplayOutput& output, float& relX, float& relY) {
+    relX = (draw.x - output.view.left) * output.viewScaleX - 2.0f * output.aspect;
+    relY = 2.0f - (draw.y - output.view.top) * output.viewScaleY;
+}
+
+void PlaceCubeDraw(const CubeDraw& draw, const DisplayOutput& output, float modelView[16]) {
+    // glTranslatef, glMultMatrixf(rotation), glScalef on an identity modelview.
+    // The rotation has no translation, so the product is exact: rotation
+    // columns scaled, translation in the last column.
+    for (int i = 0; i < 16; i++) modelView[i] = draw.rotation[i];
+    for (int column = 0; column < 3; column++) {
+        for (int row = 0; row < 3; row++) modelView[column * 4 + row] *= draw.scale;
+    }
+    CubeDrawOffset(draw, output, modelView[12], modelView[13]);
+    modelView[14] = -5.0f;
+    modelView[15] = 1.0f;
+}
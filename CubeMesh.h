@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CubeCore.h"
+#include "CubeTopology.h"
+
+// The cube as retained geometry: DrawCubeImmediate's six quads as an indexed
+// triangle mesh built once per cube size, and the per-cube transform and color
+// that place one instance of it in an output. A renderer uploads the mesh once
+// and then only sends a CubeDraw per cube per frame.
+
+const int CUBE_MESH_VERTEX_COUNT = 24;  // Four corners per face, each with the face normal
+const int CUBE_MESH_INDEX_COUNT = 36;  // Two triangles per face
+
+// DrawCubeImmediate's faces in its glBegin(GL_QUADS) order: normal, then four corners
+// as multiples of the cube scale
+extern const float CUBE_MESH_FACES[6][5][3];
+
+struct CubeMeshVertex {
+    float x, y, z;
+    float nx, ny, nz;
+};
+
+// Corners at +-halfSize (the 3D cube scale), quads split along their first
+// diagonal as (0, 1, 2) and (0, 2, 3)
+void BuildCubeMesh(float halfSize, CubeMeshVertex vertices[CUBE_MESH_VERTEX_COUNT],
+                   unsigned short indices[CUBE_MESH_INDEX_COUNT]);
+
+// One cube as a renderer draws it, before it is placed in any output: where
+// it is on the desktop, how it is turned and pulsed, and its color
+struct CubeDraw {
+    float x, y;  // Desktop pixels
+    float rotation[16];  // GetCubeRotationMatrix
+    float scale;  // Celebration pulse, 1 otherwise
+    float halfSize;  // 3D cube scale, the mesh's corners are at +-halfSize
+    float reach;  // GetCubeSizeInPixels: how far from (x, y) the cube can cover
+    float r, g, b;
+};
+
+// The transform and color DrawCubeImmediate uses for `cube`, pulsed while
+// celebrating
+void DescribeCubeDraw(const Cube& cube, float cubeSize, CubeDraw& draw);
+
+// The modelview matrix (column-major, for glLoadMatrixf) DrawCubeImmediate
+// leaves GL with for `draw` in `output`: translated into the output, rotated
+// and scaled
+void PlaceCubeDraw(const CubeDraw& draw, const DisplayOutput& output, float modelView[16]);
+
+// Where (x, y) lands in `output`'s view, in the units PlaceCubeDraw translates by
+void CubeDrawOffset(const CubeDraw& draw, const DisplayOutput& output, float& relX, float& relY);
@@ -0,0 +1,169 @@
+#include "CubeParallel.h"
+#include <chrono>
+
+static unsigned long long PackRange(size_t begin, size_t end) {
+    return ((unsigned long long)begin << 32) | (unsigned long long)end;
+}
+
+static size_t RangeBegin(unsigned long long packed) { return (size_t)(packed >> 32); }
+static size_t RangeEnd(unsigned long long packed) { return (size_t)(packed & 0xFFFFFFFFULL); }
+
+CubeWorkerPool::CubeWorkerPool(int threads)
+    : ranges(threads > 0 ? threads : 1), generation(0), stopping(false), task(NULL), remaining(0), busy(0) {
+    for (size_t i = 0; i < ranges.size(); i++) ranges[i].packed.store(0);
+    for (int i = 1; i < ThreadCount(); i++) {
+        workers.push_back(std::thread(&CubeWorkerPool::WorkerLoop, this, i));
+    }
+}
+
+CubeWorkerPool::~CubeWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+}
+
+void CubeWorkerPool::ParallelFor(size_t chunks, const std::function<void(size_t)>& job) {
+    if (chunks == 0) return;
+    if (workers.empty() || chunks == 1) {
+        for (size_t c = 0; c < chunks; c++) job(c);
+        return;
+    }
+
+    // Contiguous shares keep each thread on neighbouring memory until it steals
+    int threads = ThreadCount();
+    for (int t = 0; t < threads; t++) {
+        size_t begin = chunks * t / threads;
+        size_t end = chunks * (t + 1) / threads;
+        ranges[t].packed.store(PackRange(begin, end));
+    }
+    task = &job;
+    remaining.store(chunks);
+    busy.store(threads - 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+    }
+    wake.notify_all();
+
+    RunChunks(0);
+
+    // Workers may still be finishing a stolen chunk, or scanning for one; the
+    // next ParallelFor must not hand them new ranges until they are idle
+    while (remaining.load() != 0 || busy.load() != 0) std::this_thread::yield();
+    task = NULL;
+}
+
+void CubeWorkerPool::WorkerLoop(int self) {
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        RunChunks(self);
+        busy.fetch_sub(1);
+    }
+}
+
+void CubeWorkerPool::RunChunks(int self) {
+    size_t chunk;
+    while (true) {
+        while (PopFront(self, chunk)) {
+            (*task)(chunk);
+            remaining.fetch_sub(1);
+        }
+        if (!StealInto(self)) return;
+    }
+}
+
+bool CubeWorkerPool::PopFront(int self, size_t& chunk) {
+    std::atomic<unsigned long long>& slot = ranges[self].packed;
+    unsigned long long current = slot.load();
+    while (RangeBegin(current) < RangeEnd(current)) {
+        if (slot.compare_exchange_weak(current, PackRange(RangeBegin(current) + 1, RangeEnd(current)))) {
+            chunk = RangeBegin(current);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CubeWorkerPool::StealInto(int self) {
+    int threads = ThreadCount();
+    for (int offset = 1; offset < threads; offset++) {
+        int victim = (self + offset) % threads;
+        std::atomic<unsigned long long>& slot = ranges[victim].packed;
+        unsigned long long current = slot.load();
+        while (RangeBegin(current) < RangeEnd(current)) {
+            size_t begin = RangeBegin(current);
+            size_t end = RangeEnd(current);
+            size_t split = begin + (end - begin) / 2;  // Victim keeps [begin, split)
+            if (slot.compare_exchange_weak(current, PackRange(begin, split))) {
+                // Our own range is empty, so no thief can be racing for it
+                ranges[self].packed.store(PackRange(split, end));
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+CubeParallelUpdater::CubeParallelUpdater(CubeWorkerPool& workerPool, size_t chunk)
+    : pool(workerPool), chunkSize((chunk + CUBE_SOA_LANES - 1) / CUBE_SOA_LANES * CUBE_SOA_LANES) {
+    phaseTimes.integrate = phaseTimes.bounce = phaseTimes.countdown = 0;
+}
+
+size_t CubeParallelUpdater::Update(CubeSoA& cubes, const WorldBounds& bounds, const CubeSettings& settings, std::vector<CubeBounce>& bounces) {
+    const float CUBE_SIZE = GetCubeSizeInPixels(settings.cubeSize);
+    size_t count = cubes.Size();
+    size_t chunks = (count + chunkSize - 1) / chunkSize;
+    if (chunkBounces.size() < chunks) chunkBounces.resize(chunks);
+    chunkCorners.assign(chunks, 0);
+
+    // Same schedule UpdateCubeSoA keeps through RotateCubeSoA
+    bool normalize = ++cubes.stepsSinceNormalize >= ORIENTATION_NORMALIZE_INTERVAL;
+    if (normalize) cubes.stepsSinceNormalize = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    pool.ParallelFor(chunks, [&](size_t c) {
+        size_t begin = c * chunkSize;
+        size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+        chunkBounces[c].clear();
+        IntegrateCubeSoARange(cubes, begin, end, bounds, CUBE_SIZE, chunkBounces[c]);
+        RotateCubeSoARange(cubes, begin, end, normalize);
+    });
+    phaseTimes.integrate += SecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    pool.ParallelFor(chunks, [&](size_t c) {
+        const std::vector<CubeBounce>& list = chunkBounces[c];
+        if (!list.empty()) chunkCorners[c] = ResolveCubeSoABounces(cubes, bounds, settings, &list[0], list.size());
+    });
+    phaseTimes.bounce += SecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    pool.ParallelFor(chunks, [&](size_t c) {
+        size_t begin = c * chunkSize;
+        size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+        CountDownCubeSoARange(cubes, begin, end);
+    });
+    phaseTimes.countdown += SecondsSince(start);
+
+    // Chunk order is cube order, which is the order UpdateCubeSoA reports in
+    size_t corners = 0;
+    bounces.clear();
+    for (size_t c = 0; c < chunks; c++) {
+        corners += chunkCorners[c];
+        bounces.insert(bounces.end(), chunkBounces[c].begin(), chunkBounces[c].end());
+    }
+    return corners;
+}
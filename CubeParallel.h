@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CubeSoA.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool and a chunked, multithreaded UpdateCubeSoA.
+//
+// Every cube's update depends only on that cube (bounce jitter comes from its
+// own CubeRandom stream), and per-chunk results are merged in chunk order, so
+// the outcome is bit-identical to UpdateCubeSoA for any thread count.
+
+// Cubes per chunk: a multiple of CUBE_SOA_LANES, small enough to balance and
+// large enough that scheduling costs vanish next to the kernel
+const size_t CUBE_PARALLEL_CHUNK = 4096;
+
+class CubeWorkerPool {
+public:
+    // `threads` includes the calling thread, which works during ParallelFor
+    explicit CubeWorkerPool(int threads);
+    ~CubeWorkerPool();
+
+    int ThreadCount() const { return (int)ranges.size(); }
+
+    // Run task(chunk) for every chunk in [0, chunks) and return when all are
+    // done. Each thread starts on a contiguous share and steals half of another
+    // thread's remaining share when its own runs out.
+    void ParallelFor(size_t chunks, const std::function<void(size_t)>& task);
+
+private:
+    CubeWorkerPool(const CubeWorkerPool&);
+    CubeWorkerPool& operator=(const CubeWorkerPool&);
+
+    // A thread's remaining chunks [begin, end), packed as (begin << 32) | end so
+    // the owner (taking from the front) and thieves (taking the back half) can
+    // both claim work with a single compare-and-swap. Padded to a cache line so
+    // threads polling their own range do not contend.
+    struct ChunkRange {
+        std::atomic<unsigned long long> packed;
+        char padding[64 - sizeof(std::atomic<unsigned long long>)];
+    };
+
+    void WorkerLoop(int self);
+    void RunChunks(int self);
+    bool PopFront(int self, size_t& chunk);
+    bool StealInto(int self);
+
+    std::vector<ChunkRange> ranges;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    unsigned long long generation;  // Bumped for every ParallelFor
+    bool stopping;
+
+    const std::function<void(size_t)>* task;
+    std::atomic<size_t> remaining;  // Chunks not yet finished
+    std::atomic<int> busy;  // Worker threads still looking for chunks
+};
+
+// Seconds spent in each phase of UpdateCubeSoA, accumulated across frames
+struct CubePhaseTimes {
+    double integrate;  // Integrate, collide and rotate
+    double bounce;     // Jitter, new spin and corner checks for cubes that hit a wall
+    double countdown;  // Celebration timers
+};
+
+class CubeParallelUpdater {
+public:
+    explicit CubeParallelUpdater(CubeWorkerPool& pool, size_t chunkSize = CUBE_PARALLEL_CHUNK);
+
+    // UpdateCubeSoA on the pool. Same cubes, same bounce list, same return value.
+    size_t Update(CubeSoA& cubes, const WorldBounds& bounds, const CubeSettings& settings, std::vector<CubeBounce>& bounces);
+
+    CubePhaseTimes phaseTimes;
+
+private:
+    CubeWorkerPool& pool;
+    size_t chunkSize;
+    std::vector<std::vector<CubeBounce> > chunkBounces;
+    std::vector<size_t> chunkCorners;
+};
@@ -0,0 +1,54 @@
+#include "CubePresent.h"
+
+OutputFrame DescribeOutputFrame(const Cube& drawn, bool drawCube) {
+    OutputFrame frame = {};
+    frame.cubeVisible = drawCube && drawn.active;
+    if (!frame.cubeVisible) return frame;  // Every blank frame is the same frame
+    frame.x = drawn.x;
+    frame.y = drawn.y;
+    for (int i = 0; i < 4; i++) frame.orientation[i] = drawn.orientation[i];
+    frame.color = drawn.color;
+    frame.celebrationTimer = drawn.celebratingCorner ? drawn.celebrationTimer : 0;
+    return frame;
+}
+
+// Field by field: padding and -0.0f must not matter
+bool SameOutputFrame(const OutputFrame& a, const OutputFrame& b) {
+    if (a.cubeVisible != b.cubeVisible) return false;
+    if (!a.cubeVisible) return true;
+    for (int i = 0; i < 4; i++) {
+        if (a.orientation[i] != b.orientation[i]) return false;
+    }
+    return a.x == b.x && a.y == b.y && a.color == b.color && a.celebrationTimer == b.celebrationTimer;
+}
+
+PresentTracker::PresentTracker() : topology(NULL), generation(0) {
+}
+
+void PresentTracker::Sync(const DisplayTopology& current) {
+    if (topology == &current && generation == current.Generation() && outputs.size() == current.OutputCount()) return;
+    topology = &current;
+    generation = current.Generation();
+    OutputState fresh = {};
+    outputs.assign(current.OutputCount(), fresh);
+}
+
+bool PresentTracker::ShouldPresent(size_t output, const OutputFrame& frame) {
+    OutputState& state = outputs[output];
+    if (state.valid && SameOutputFrame(state.shown, frame)) {
+        state.skipped++;
+        return false;
+    }
+    return true;
+}
+
+void PresentTracker::Presented(size_t output, const OutputFrame& frame) {
+    OutputState& state = outputs[output];
+    state.shown = frame;
+    state.valid = true;
+    state.presented++;
+}
+
+void PresentTracker::Invalidate(size_t output) {
+    if (output < outputs.size()) outputs[output].valid = false;
+}
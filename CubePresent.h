@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CubeTopology.h"
+#include <cstddef>
+#include <vector>
+
+// Per-output present bookkeeping, so the frame loop can leave alone an output
+// whose next frame would look exactly like the one it last presented: a
+// monitor the cube is not on stays black, and does not need making current,
+// clearing or swapping every tick. When the cube leaves a monitor that monitor
+// is presented once more, blank, and then skipped until the cube comes back.
+
+// Everything about a frame that decides what one output shows
+struct OutputFrame {
+    bool cubeVisible;
+    float x, y;
+    float orientation[4];
+    unsigned int color;
+    int celebrationTimer;  // 0 unless celebrating; DrawCubeImmediate pulses with it
+};
+
+// The frame RenderScene would draw from `drawn`, cube shown only if `drawCube`
+OutputFrame DescribeOutputFrame(const Cube& drawn, bool drawCube);
+
+// Whether the two frames would put the same image on screen
+bool SameOutputFrame(const OutputFrame& a, const OutputFrame& b);
+
+class PresentTracker {
+public:
+    PresentTracker();
+
+    // Follow `topology`: on a new layout every output is presented afresh and
+    // the counters start over
+    void Sync(const DisplayTopology& topology);
+
+    // Whether `output` must render and present `frame`. False means its screen
+    // already shows it; that counts as a skipped frame.
+    bool ShouldPresent(size_t output, const OutputFrame& frame);
+
+    // Record that `output` put `frame` on screen
+    void Presented(size_t output, const OutputFrame& frame);
+
+    // Forget what `output` shows, e.g. after its window was uncovered
+    void Invalidate(size_t output);
+
+    size_t OutputCount() const { return outputs.size(); }
+    long long PresentedFrames(size_t output) const { return outputs[output].presented; }
+    long long SkippedFrames(size_t output) const { return outputs[output].skipped; }
+
+private:
+    struct OutputState {
+        OutputFrame shown;
+        bool valid;  // `shown` is on screen
+        long long presented, skipped;
+    };
+
+    std::vector<OutputState> outputs;
+    const DisplayTopology* topology;
+    unsigned int generation;
+};
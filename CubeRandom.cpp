@@ -0,0 +1,29 @@
+#include "CubeRandom.h"
+
+static const unsigned long long GOLDEN_GAMMA = 0x9E3779B97F4A7C15ULL;
+
+// SplitMix64 finalizer: a bijective avalanche of all 64 bits
+static unsigned long long Mix64(unsigned long long z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+unsigned long long CubeRandomKey(unsigned long long seed, unsigned int cubeId) {
+    return Mix64(Mix64(seed) + (cubeId + 1ULL) * GOLDEN_GAMMA);
+}
+
+CubeRandom CubeRandomStream(unsigned long long key, unsigned long long eventNumber) {
+    CubeRandom rng;
+    rng.state = Mix64(key ^ Mix64(eventNumber + GOLDEN_GAMMA));
+    return rng;
+}
+
+unsigned int CubeRandomBits(CubeRandom& rng) {
+    rng.state += GOLDEN_GAMMA;
+    return (unsigned int)(Mix64(rng.state) >> 32);
+}
+
+float CubeRandomUnit(CubeRandom& rng) {
+    return (CubeRandomBits(rng) >> 8) * (1.0f / 16777216.0f);  // 24 bits, exact in a float
+}
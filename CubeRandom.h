@@ -0,0 +1,26 @@
+#pragma once
+
+// Counter-based random numbers for the simulation. Every draw is a pure function
+// of (seed, cube id, event number, draw index), so any cube's bounces can be
+// replayed on any thread, in any order, with bit-identical results. There is no
+// hidden shared state like rand()'s.
+//
+// A cube's stream key comes from CubeRandomKey(seed, cubeId). Each random event
+// (the reset, then every wall bounce) takes the next event number and opens a
+// short SplitMix64 sequence for its handful of draws.
+
+struct CubeRandom {
+    unsigned long long state;
+};
+
+// Per-cube key derived from the run seed and the cube's id
+unsigned long long CubeRandomKey(unsigned long long seed, unsigned int cubeId);
+
+// Stream for one random event of the cube with the given key
+CubeRandom CubeRandomStream(unsigned long long key, unsigned long long eventNumber);
+
+// Next 32 random bits of the stream
+unsigned int CubeRandomBits(CubeRandom& rng);
+
+// Next value in [0, 1)
+float CubeRandomUnit(CubeRandom& rng);
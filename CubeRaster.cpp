@@ -0,0 +1,453 @@
+#include "CubeRaster.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CUBE_RASTER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CUBE_RASTER_SSE2 1
+#endif
+
+SoftwareFramebuffer::SoftwareFramebuffer() : width(0), height(0), stride(0), depthTop(0), depthBottom(-1) {
+}
+
+void SoftwareFramebuffer::Resize(int newWidth, int newHeight) {
+    if (newWidth == width && newHeight == height) return;
+    width = newWidth > 0 ? newWidth : 0;
+    height = newHeight > 0 ? newHeight : 0;
+    stride = (width + RASTER_LANES - 1) / RASTER_LANES * RASTER_LANES;
+    color.assign((size_t)stride * height, RASTER_OPAQUE);
+    depth.assign((size_t)stride * height, 1.0f);
+    depthTop = 0;
+    depthBottom = -1;
+}
+
+// Fill with non-temporal stores: a 4K or 8K frame is far bigger than the
+// caches, so reading each line in just to overwrite it would double the traffic
+static void FillWords(unsigned int* words, size_t count, unsigned int value) {
+    size_t i = 0;
+#if defined(CUBE_RASTER_AVX2) || defined(CUBE_RASTER_SSE2)
+    for (; i < count && ((size_t)(words + i) & 15) != 0; i++) words[i] = value;
+    __m128i fill = _mm_set1_epi32((int)value);
+    for (; i + 4 <= count; i += 4) _mm_stream_si128((__m128i*)(words + i), fill);
+    _mm_sfence();
+#endif
+    for (; i < count; i++) words[i] = value;
+}
+
+void SoftwareFramebuffer::Clear(unsigned int rgba) {
+    if (color.empty()) return;
+    FillWords(&color[0], color.size(), rgba);
+
+    // Depth only needs resetting where a triangle has been since the last clear
+    if (depthTop <= depthBottom) {
+        float far = 1.0f;
+        unsigned int farBits;
+        memcpy(&farBits, &far, sizeof(farBits));
+        FillWords((unsigned int*)DepthRow(depthTop), (size_t)(depthBottom - depthTop + 1) * stride, farBits);
+    }
+    depthTop = 0;
+    depthBottom = -1;
+}
+
+void SoftwareFramebuffer::ClearRect(const RasterRect& rect, unsigned int rgba) {
+    int count = rect.right - rect.left;
+    if (count <= 0) return;
+    for (int y = rect.top; y < rect.bottom; y++) {
+        std::fill(Row(y) + rect.left, Row(y) + rect.right, rgba);
+        std::fill(DepthRow(y) + rect.left, DepthRow(y) + rect.right, 1.0f);
+    }
+}
+
+void SoftwareFramebuffer::MarkDepthRows(int top, int bottom) {
+    if (depthTop > depthBottom) {
+        depthTop = top;
+        depthBottom = bottom;
+    } else {
+        depthTop = std::min(depthTop, top);
+        depthBottom = std::max(depthBottom, bottom);
+    }
+}
+
+// gluPerspective(45.0, aspect, 0.1, 100.0) from RenderScene
+static const float PROJECTION_FOVY_DEGREES = 45.0f;
+static const float PROJECTION_NEAR = 0.1f;
+static const float PROJECTION_FAR = 100.0f;
+
+static unsigned char LitChannel(float base, float intensity) {
+    float lit = base * intensity;
+    if (lit > 1.0f) lit = 1.0f;
+    return (unsigned char)(lit * 255.0f + 0.5f);
+}
+
+int ProjectCube(const Cube& cube, const DisplayOutput& output, float cubeSize, RasterTriangle triangles[12]) {
+    CubeDraw draw;
+    DescribeCubeDraw(cube, cubeSize, draw);
+    return ProjectCubeDraw(draw, output, triangles);
+}
+
+void ProjectCubeCenter(const CubeDraw& draw, const DisplayOutput& output, float& x, float& y) {
+    float relX, relY;
+    CubeDrawOffset(draw, output, relX, relY);
+    float f = 1.0f / tanf(PROJECTION_FOVY_DEGREES * 0.5f * 3.14159265f / 180.0f);
+    x = (f / output.aspect * relX / 5.0f + 1.0f) * 0.5f * output.width;
+    y = (1.0f - f * relY / 5.0f) * 0.5f * output.height;
+}
+
+float CubeFaceIntensity(const float rotation[16], int face, float scale) {
+    // GL_NORMALIZE is off, so the celebration scale-up dims the light
+    // exactly as it does through WGL
+    const float* n = CUBE_MESH_FACES[face][0];
+    float normalZ = (rotation[2] * n[0] + rotation[6] * n[1] + rotation[10] * n[2]) / scale;
+    return RASTER_AMBIENT + RASTER_DIFFUSE * (normalZ > 0.0f ? normalZ : 0.0f);
+}
+
+unsigned int LitCubeColor(float r, float g, float b, float intensity) {
+    return CUBE_RGB(LitChannel(r, intensity), LitChannel(g, intensity), LitChannel(b, intensity)) | RASTER_OPAQUE;
+}
+
+int ProjectCubeDraw(const CubeDraw& draw, const DisplayOutput& output, RasterTriangle triangles[12]) {
+    int faces[12];
+    return ProjectCubeDraw(draw, output, triangles, faces);
+}
+
+int ProjectCubeDraw(const CubeDraw& draw, const DisplayOutput& output, RasterTriangle triangles[12], int faces[12]) {
+    if (output.width <= 0 || output.height <= 0) return 0;
+    float aspect = output.aspect;
+    float relX, relY;
+    CubeDrawOffset(draw, output, relX, relY);
+    const float* rotation = draw.rotation;
+    float r = draw.r, g = draw.g, b = draw.b;
+    float scale = draw.scale;
+
+    float f = 1.0f / tanf(PROJECTION_FOVY_DEGREES * 0.5f * 3.14159265f / 180.0f);
+    float depthScale = (PROJECTION_FAR + PROJECTION_NEAR) / (PROJECTION_NEAR - PROJECTION_FAR);
+    float depthOffset = 2.0f * PROJECTION_FAR * PROJECTION_NEAR / (PROJECTION_NEAR - PROJECTION_FAR);
+
+    int count = 0;
+    for (int face = 0; face < 6; face++) {
+        RasterVertex corners[4];
+        bool visible = true;
+        for (int k = 0; k < 4; k++) {
+            const float* v = CUBE_MESH_FACES[face][k + 1];
+            float s = draw.halfSize * scale;
+            float ex = rotation[0] * v[0] * s + rotation[4] * v[1] * s + rotation[8] * v[2] * s + relX;
+            float ey = rotation[1] * v[0] * s + rotation[5] * v[1] * s + rotation[9] * v[2] * s + relY;
+            float ez = rotation[2] * v[0] * s + rotation[6] * v[1] * s + rotation[10] * v[2] * s - 5.0f;
+            if (-ez <= PROJECTION_NEAR) {
+                visible = false;
+                break;
+            }
+            float w = -ez;
+            float ndcX = f / aspect * ex / w;
+            float ndcY = f * ey / w;
+            float ndcZ = (depthScale * ez + depthOffset) / w;
+            corners[k].x = (ndcX + 1.0f) * 0.5f * output.width;
+            corners[k].y = (1.0f - ndcY) * 0.5f * output.height;
+            corners[k].z = (ndcZ + 1.0f) * 0.5f;
+        }
+        if (!visible) continue;
+
+        // Counter-clockwise on screen is front-facing in GL; with y pointing
+        // down that is a negative cross product
+        float cross = (corners[1].x - corners[0].x) * (corners[2].y - corners[0].y) -
+                      (corners[1].y - corners[0].y) * (corners[2].x - corners[0].x);
+        if (cross >= 0.0f) continue;
+
+        unsigned int color = LitCubeColor(r, g, b, CubeFaceIntensity(rotation, face, scale));
+
+        faces[count] = faces[count + 1] = face;
+        RasterTriangle& first = triangles[count++];
+        first.v[0] = corners[0];
+        first.v[1] = corners[1];
+        first.v[2] = corners[2];
+        first.color = color;
+        RasterTriangle& second = triangles[count++];
+        second.v[0] = corners[0];
+        second.v[1] = corners[2];
+        second.v[2] = corners[3];
+        second.color = color;
+    }
+    return count;
+}
+
+// One triangle edge. Coverage comes from the sign of
+//   dx * (py - y0) - dy * (px - x0)
+// evaluated from the same endpoint in the same direction whichever triangle
+// asks, then negated if the triangle runs the other way. Two triangles sharing
+// an edge therefore see bit-identical values at every pixel, and the top-left
+// rule hands each pixel on the edge to exactly one of them.
+struct RasterEdge {
+    float x0, y0, dx, dy;
+    bool flip;     // The triangle runs from (x0 + dx, y0 + dy) to (x0, y0)
+    bool topLeft;  // Pixels exactly on a top or left edge belong to this triangle
+};
+
+struct RasterSetup {
+    RasterEdge edges[3];
+    float zOriginX, zOriginY, z0, zx, zy;  // Depth plane through the first vertex
+    int left, top, right, bottom;  // Pixel bounding box; left is block aligned
+};
+
+static void SetupEdge(const RasterVertex& from, const RasterVertex& to, RasterEdge& edge) {
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    edge.topLeft = (dy == 0.0f && dx > 0.0f) || dy < 0.0f;
+    edge.flip = to.y < from.y || (to.y == from.y && to.x < from.x);
+    const RasterVertex& start = edge.flip ? to : from;
+    edge.x0 = start.x;
+    edge.y0 = start.y;
+    edge.dx = edge.flip ? -dx : dx;
+    edge.dy = edge.flip ? -dy : dy;
+}
+
+static bool SetupTriangle(const RasterRect& clip, const RasterTriangle& triangle, RasterSetup& setup) {
+    const RasterVertex* a = &triangle.v[0];
+    const RasterVertex* b = &triangle.v[1];
+    const RasterVertex* c = &triangle.v[2];
+    float area = (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+    if (area == 0.0f || area != area) return false;
+
+    // Pixels whose centers can fall inside, clipped
+    float minX = std::min(a->x, std::min(b->x, c->x));
+    float maxX = std::max(a->x, std::max(b->x, c->x));
+    float minY = std::min(a->y, std::min(b->y, c->y));
+    float maxY = std::max(a->y, std::max(b->y, c->y));
+    float clipLeft = (float)clip.left, clipTop = (float)clip.top;
+    float clipRight = (float)clip.right, clipBottom = (float)clip.bottom;
+    setup.left = (int)ceilf(std::min(std::max(minX - 0.5f, clipLeft), clipRight));
+    setup.top = (int)ceilf(std::min(std::max(minY - 0.5f, clipTop), clipBottom));
+    setup.right = (int)floorf(std::max(std::min(maxX - 0.5f, clipRight - 1.0f), clipLeft - 1.0f));
+    setup.bottom = (int)floorf(std::max(std::min(maxY - 0.5f, clipBottom - 1.0f), clipTop - 1.0f));
+    if (setup.left > setup.right || setup.top > setup.bottom) return false;
+
+    // Blocks start on a lane boundary so they never straddle two rows
+    setup.left = setup.left / RASTER_LANES * RASTER_LANES;
+
+    float zb = b->z - a->z, zc = c->z - a->z;
+    setup.zOriginX = a->x;
+    setup.zOriginY = a->y;
+    setup.z0 = a->z;
+    setup.zx = (zb * (c->y - a->y) - zc * (b->y - a->y)) / area;
+    setup.zy = (zc * (b->x - a->x) - zb * (c->x - a->x)) / area;
+
+    // Inside is where all three edge values are positive
+    if (area < 0.0f) std::swap(b, c);
+    SetupEdge(*b, *c, setup.edges[0]);
+    SetupEdge(*c, *a, setup.edges[1]);
+    SetupEdge(*a, *b, setup.edges[2]);
+    return true;
+}
+
+// Columns of one row worth visiting, found analytically so the kernel skips
+// most of the bounding box. [first, last] is widened by a pixel either side so
+// rounding never drops a pixel the exact per-pixel test would keep; first is
+// block aligned. [innerFirst, innerLast] is narrowed so far inside every edge
+// that the per-pixel test could not come out negative there, letting whole
+// blocks skip it.
+struct RasterSpan {
+    int first, last;
+    int innerFirst, innerLast;  // Empty if innerFirst > innerLast
+};
+
+static bool RowSpan(const RasterSetup& s, float py, RasterSpan& span) {
+    float low = (float)s.left, high = (float)s.right + 1.0f;
+    float innerLow = low, innerHigh = high;
+    for (int k = 0; k < 3; k++) {
+        const RasterEdge& e = s.edges[k];
+        float row = e.dx * (py - e.y0);
+        float slope = e.dy;
+        if (e.flip) {
+            row = -row;
+            slope = -slope;
+        }
+        // The edge value at pixel center px is row - slope * (px - x0), and
+        // must not be negative. Its rounding error is far below `tolerance`.
+        float reach = std::max(fabsf(low - e.x0), fabsf(high - e.x0));
+        float tolerance = 1e-5f * (fabsf(row) + fabsf(slope) * reach);
+        if (slope == 0.0f) {
+            if (row < 0.0f) return false;
+            if (row <= tolerance) innerHigh = -1.0f;
+        } else if (slope > 0.0f) {
+            high = std::min(high, e.x0 + row / slope + 1.0f);
+            innerHigh = std::min(innerHigh, e.x0 + (row - tolerance) / slope - 1.0f);
+        } else {
+            low = std::max(low, e.x0 + row / slope - 1.0f);
+            innerLow = std::max(innerLow, e.x0 + (row - tolerance) / slope + 1.0f);
+        }
+    }
+    if (low > high) return false;
+    span.first = (int)low / RASTER_LANES * RASTER_LANES;
+    span.last = std::min((int)high, s.right);
+    span.innerFirst = (int)ceilf(std::min(std::max(innerLow - 0.5f, (float)s.left), (float)s.right + 1.0f));
+    span.innerLast = (int)floorf(std::max(std::min(innerHigh - 0.5f, (float)s.right), (float)s.left - 1.0f));
+    return true;
+}
+
+static void FillTriangle(SoftwareFramebuffer& framebuffer, const RasterTriangle& triangle, const RasterSetup& s) {
+    const RasterEdge* e = s.edges;
+
+#if defined(CUBE_RASTER_AVX2)
+    const __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 last = _mm256_set1_ps(s.right + 0.5f);
+    const __m256 x0[3] = { _mm256_set1_ps(e[0].x0), _mm256_set1_ps(e[1].x0), _mm256_set1_ps(e[2].x0) };
+    const __m256 dy[3] = { _mm256_set1_ps(e[0].dy), _mm256_set1_ps(e[1].dy), _mm256_set1_ps(e[2].dy) };
+    __m256 flip[3], topLeft[3];
+    for (int k = 0; k < 3; k++) {
+        flip[k] = _mm256_castsi256_ps(_mm256_set1_epi32(e[k].flip ? (int)0x80000000 : 0));
+        topLeft[k] = _mm256_castsi256_ps(_mm256_set1_epi32(e[k].topLeft ? -1 : 0));
+    }
+    const __m256 zx = _mm256_set1_ps(s.zx);
+    const __m256 color = _mm256_castsi256_ps(_mm256_set1_epi32((int)triangle.color));
+    for (int y = s.top; y <= s.bottom; y++) {
+        float py = y + 0.5f;
+        __m256 rows[3];
+        for (int k = 0; k < 3; k++) rows[k] = _mm256_set1_ps(e[k].dx * (py - e[k].y0));
+        float rowZ = s.z0 + s.zy * (py - s.zOriginY);
+        unsigned int* colorRow = framebuffer.Row(y);
+        float* depthRow = framebuffer.DepthRow(y);
+        RasterSpan span;
+        if (!RowSpan(s, py, span)) continue;
+        for (int x = span.first; x <= span.last; x += 8) {
+            __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), lanes);
+            __m256 mask = _mm256_cmp_ps(px, last, _CMP_LE_OQ);
+            bool interior = x >= span.innerFirst && x + 7 <= span.innerLast;
+            for (int k = 0; k < 3 && !interior; k++) {
+                __m256 value = _mm256_sub_ps(rows[k], _mm256_mul_ps(dy[k], _mm256_sub_ps(px, x0[k])));
+                value = _mm256_xor_ps(value, flip[k]);
+                __m256 inside = _mm256_or_ps(_mm256_cmp_ps(value, zero, _CMP_GT_OQ),
+                                             _mm256_and_ps(_mm256_cmp_ps(value, zero, _CMP_EQ_OQ), topLeft[k]));
+                mask = _mm256_and_ps(mask, inside);
+            }
+            if (!_mm256_movemask_ps(mask)) continue;
+
+            __m256 z = _mm256_add_ps(_mm256_set1_ps(rowZ), _mm256_mul_ps(zx, _mm256_sub_ps(px, _mm256_set1_ps(s.zOriginX))));
+            __m256 oldZ = _mm256_loadu_ps(depthRow + x);
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(z, oldZ, _CMP_LT_OQ));
+            _mm256_storeu_ps(depthRow + x, _mm256_blendv_ps(oldZ, z, mask));
+            __m256 oldColor = _mm256_loadu_ps((const float*)(colorRow + x));
+            _mm256_storeu_ps((float*)(colorRow + x), _mm256_blendv_ps(oldColor, color, mask));
+        }
+    }
+#elif defined(CUBE_RASTER_SSE2)
+    const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 last = _mm_set1_ps(s.right + 0.5f);
+    const __m128 x0[3] = { _mm_set1_ps(e[0].x0), _mm_set1_ps(e[1].x0), _mm_set1_ps(e[2].x0) };
+    const __m128 dy[3] = { _mm_set1_ps(e[0].dy), _mm_set1_ps(e[1].dy), _mm_set1_ps(e[2].dy) };
+    __m128 flip[3], topLeft[3];
+    for (int k = 0; k < 3; k++) {
+        flip[k] = _mm_castsi128_ps(_mm_set1_epi32(e[k].flip ? (int)0x80000000 : 0));
+        topLeft[k] = _mm_castsi128_ps(_mm_set1_epi32(e[k].topLeft ? -1 : 0));
+    }
+    const __m128 zx = _mm_set1_ps(s.zx);
+    const __m128 color = _mm_castsi128_ps(_mm_set1_epi32((int)triangle.color));
+    for (int y = s.top; y <= s.bottom; y++) {
+        float py = y + 0.5f;
+        __m128 rows[3];
+        for (int k = 0; k < 3; k++) rows[k] = _mm_set1_ps(e[k].dx * (py - e[k].y0));
+        float rowZ = s.z0 + s.zy * (py - s.zOriginY);
+        unsigned int* colorRow = framebuffer.Row(y);
+        float* depthRow = framebuffer.DepthRow(y);
+        RasterSpan span;
+        if (!RowSpan(s, py, span)) continue;
+        for (int x = span.first; x <= span.last; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+            __m128 mask = _mm_cmple_ps(px, last);
+            bool interior = x >= span.innerFirst && x + 3 <= span.innerLast;
+            for (int k = 0; k < 3 && !interior; k++) {
+                __m128 value = _mm_sub_ps(rows[k], _mm_mul_ps(dy[k], _mm_sub_ps(px, x0[k])));
+                value = _mm_xor_ps(value, flip[k]);
+                __m128 inside = _mm_or_ps(_mm_cmpgt_ps(value, zero), _mm_and_ps(_mm_cmpeq_ps(value, zero), topLeft[k]));
+                mask = _mm_and_ps(mask, inside);
+            }
+            if (!_mm_movemask_ps(mask)) continue;
+
+            __m128 z = _mm_add_ps(_mm_set1_ps(rowZ), _mm_mul_ps(zx, _mm_sub_ps(px, _mm_set1_ps(s.zOriginX))));
+            __m128 oldZ = _mm_loadu_ps(depthRow + x);
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(z, oldZ));
+            _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, oldZ)));
+            __m128 oldColor = _mm_loadu_ps((const float*)(colorRow + x));
+            _mm_storeu_ps((float*)(colorRow + x), _mm_or_ps(_mm_and_ps(mask, color), _mm_andnot_ps(mask, oldColor)));
+        }
+    }
+#else
+    for (int y = s.top; y <= s.bottom; y++) {
+        float py = y + 0.5f;
+        float rowZ = s.z0 + s.zy * (py - s.zOriginY);
+        unsigned int* colorRow = framebuffer.Row(y);
+        float* depthRow = framebuffer.DepthRow(y);
+        RasterSpan span;
+        if (!RowSpan(s, py, span)) continue;
+        for (int x = span.first; x <= span.last; x++) {
+            float px = x + 0.5f;
+            bool inside = true;
+            for (int k = 0; k < 3; k++) {
+                float value = e[k].dx * (py - e[k].y0) - e[k].dy * (px - e[k].x0);
+                if (e[k].flip) value = -value;
+                inside = inside && (value > 0.0f || (value == 0.0f && e[k].topLeft));
+            }
+            float z = rowZ + s.zx * (px - s.zOriginX);
+            if (inside && z < depthRow[x]) {
+                depthRow[x] = z;
+                colorRow[x] = triangle.color;
+            }
+        }
+    }
+#endif
+}
+
+void RasterizeTriangle(SoftwareFramebuffer& framebuffer, const RasterTriangle& triangle) {
+    RasterRect whole = { 0, 0, framebuffer.Width(), framebuffer.Height() };
+    RasterSetup s;
+    if (!SetupTriangle(whole, triangle, s)) return;
+    framebuffer.MarkDepthRows(s.top, s.bottom);
+    FillTriangle(framebuffer, triangle, s);
+}
+
+void RasterizeTriangle(SoftwareFramebuffer& framebuffer, const RasterTriangle& triangle, const RasterRect& clip) {
+    RasterSetup s;
+    if (SetupTriangle(clip, triangle, s)) FillTriangle(framebuffer, triangle, s);
+}
+
+void RenderSceneSoftware(SoftwareFramebuffer& framebuffer, const DisplayOutput& output, const Cube& cube,
+                         float cubeSize, bool drawCube) {
+    framebuffer.Resize(output.width, output.height);
+    framebuffer.Clear(RASTER_OPAQUE);
+    if (!cube.active || !drawCube) return;
+    RasterTriangle triangles[12];
+    int count = ProjectCube(cube, output, cubeSize, triangles);
+    for (int t = 0; t < count; t++) RasterizeTriangle(framebuffer, triangles[t]);
+}
+
+bool WriteFramebufferPPM(const char* path, const SoftwareFramebuffer& framebuffer) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool written = fprintf(file, "P6\n%d %d\n255\n", framebuffer.Width(), framebuffer.Height()) > 0;
+    std::vector<unsigned char> rgb((size_t)framebuffer.Width() * 3);
+    for (int y = 0; y < framebuffer.Height() && written; y++) {
+        const unsigned int* row = framebuffer.Row(y);
+        for (int x = 0; x < framebuffer.Width(); x++) {
+            rgb[x * 3 + 0] = (unsigned char)CUBE_R(row[x]);
+            rgb[x * 3 + 1] = (unsigned char)CUBE_G(row[x]);
+            rgb[x * 3 + 2] = (unsigned char)CUBE_B(row[x]);
+        }
+        written = rgb.empty() || fwrite(&rgb[0], 1, rgb.size(), file) == rgb.size();
+    }
+    return fclose(file) == 0 && written;
+}
+
+const char* RasterKernelName() {
+#if defined(CUBE_RASTER_AVX2)
+    return "avx2";
+#elif defined(CUBE_RASTER_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
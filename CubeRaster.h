@@ -0,0 +1,118 @@
+#pragma once
+
+#include "CubeMesh.h"
+#include "CubeTopology.h"
+#include <cstddef>
+#include <vector>
+
+// CPU rasterizer for the cube scene, so frames can be rendered, checked and
+// timed without a GPU or window system.
+//
+// It draws what RenderScene/DrawCubeImmediate draw through GL: the same 45-degree
+// projection, the same placement of the cube in each output, and the same
+// fixed-function lighting InitOpenGL sets up (GL_LIGHT0 as a directional light
+// along +z, color material, no specular). Every face of the cube is flat, so
+// lighting is worked out once per face rather than per pixel.
+//
+// Triangles are set up as three half-space edge functions plus a depth plane,
+// then walked over their bounding box in blocks of SSE2/AVX2 lanes, testing
+// coverage and depth for a whole block at once.
+
+// InitOpenGL's GL_LIGHT0, plus the GL default global ambient
+const float RASTER_AMBIENT = 0.2f + 0.2f;
+const float RASTER_DIFFUSE = 0.8f;
+
+// Pixels per SIMD block; framebuffer rows are padded to a multiple of this
+const int RASTER_LANES = 8;
+
+// Pixels are RGBA bytes in memory order, so CUBE_RGB(r, g, b) | RASTER_OPAQUE
+// is a pixel
+const unsigned int RASTER_OPAQUE = 0xFF000000u;
+
+// Pixel rectangle, right and bottom exclusive
+struct RasterRect {
+    int left, top, right, bottom;
+};
+
+class SoftwareFramebuffer {
+public:
+    SoftwareFramebuffer();
+
+    void Resize(int width, int height);
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int Stride() const { return stride; }  // Pixels from one row to the next
+
+    // Fill color and reset depth to the far plane, like glClear
+    void Clear(unsigned int rgba);
+
+    // Clear just this part. Callers splitting the frame into tiles clear each
+    // tile themselves; Clear's depth bookkeeping does not track this.
+    void ClearRect(const RasterRect& rect, unsigned int rgba);
+
+    // Rows whose depth RasterizeTriangle may have written, so Clear can skip
+    // resetting the rest
+    void MarkDepthRows(int top, int bottom);
+
+    unsigned int* Row(int y) { return &color[(size_t)y * stride]; }
+    const unsigned int* Row(int y) const { return &color[(size_t)y * stride]; }
+    float* DepthRow(int y) { return &depth[(size_t)y * stride]; }
+
+private:
+    int width, height, stride;
+    std::vector<unsigned int> color;
+    std::vector<float> depth;  // Window-space z in [0, 1], smaller is nearer
+    int depthTop, depthBottom;  // Rows written since the last clear; none if top > bottom
+};
+
+// A vertex in window coordinates: pixels from the top-left corner, depth in [0, 1]
+struct RasterVertex {
+    float x, y, z;
+};
+
+struct RasterTriangle {
+    RasterVertex v[3];
+    unsigned int color;
+};
+
+// Triangles a cube occupies in the output's framebuffer, front faces only (at
+// most 3 faces, so 6 triangles), lit and colored as DrawCubeImmediate lights them
+int ProjectCube(const Cube& cube, const DisplayOutput& output, float cubeSize, RasterTriangle triangles[12]);
+
+// The same for a cube already described as a draw
+int ProjectCubeDraw(const CubeDraw& draw, const DisplayOutput& output, RasterTriangle triangles[12]);
+
+// The same, also giving the CUBE_MESH_FACES index each triangle belongs to
+int ProjectCubeDraw(const CubeDraw& draw, const DisplayOutput& output, RasterTriangle triangles[12], int faces[12]);
+
+// Where the center of `draw` lands in the output's framebuffer, in pixels
+void ProjectCubeCenter(const CubeDraw& draw, const DisplayOutput& output, float& x, float& y);
+
+// How brightly InitOpenGL's light shows face `face` of a cube rotated by
+// `rotation` (GetCubeRotationMatrix) and scaled by `scale`
+float CubeFaceIntensity(const float rotation[16], int face, float scale);
+
+// The pixel a face of color (r, g, b) comes out as at that intensity
+unsigned int LitCubeColor(float r, float g, float b, float intensity);
+
+// Depth-tested fill of a triangle of either winding. Pixels are sampled at
+// their centers; shared edges follow the top-left rule, so a mesh covers each
+// pixel exactly once.
+void RasterizeTriangle(SoftwareFramebuffer& framebuffer, const RasterTriangle& triangle);
+
+// The same, writing only pixels inside `clip` (which must lie within the
+// framebuffer and start on a multiple of RASTER_LANES). Pixels come out exactly
+// as the unclipped call would leave them, so several threads can draw one frame
+// in disjoint tiles. Not tracked by Clear; pair with ClearRect.
+void RasterizeTriangle(SoftwareFramebuffer& framebuffer, const RasterTriangle& triangle, const RasterRect& clip);
+
+// RenderScene for one output: size the framebuffer to it, clear to black and
+// draw the cube if it is on this output
+void RenderSceneSoftware(SoftwareFramebuffer& framebuffer, const DisplayOutput& output, const Cube& cube,
+                         float cubeSize, bool drawCube);
+
+// Binary PPM (P6) of the framebuffer, alpha dropped. False on any I/O error.
+bool WriteFramebufferPPM(const char* path, const SoftwareFramebuffer& framebuffer);
+
+// "avx2", "sse2" or "scalar", whichever block kernel this build uses
+const char* RasterKernelName();
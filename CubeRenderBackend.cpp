@@ -0,0 +1,185 @@
+#include "CubeRenderBackend.h"
+
+#include <algorithm>
+
+RenderCommandList::RenderCommandList() : drawEverywhere(false), binned(false) {
+}
+
+void RenderCommandList::Reset(bool everywhere) {
+    commands.clear();
+    draws.clear();
+    stateCommands.clear();
+    drawEverywhere = everywhere;
+    binned = false;
+}
+
+void RenderCommandList::Clear(unsigned int rgba) {
+    RenderCommand command = { RENDER_CLEAR, rgba };
+    stateCommands.push_back((unsigned int)commands.size());
+    commands.push_back(command);
+}
+
+void RenderCommandList::SetView() {
+    RenderCommand command = { RENDER_SET_VIEW, 0 };
+    stateCommands.push_back((unsigned int)commands.size());
+    commands.push_back(command);
+}
+
+void RenderCommandList::DrawMesh(const CubeDraw& draw) {
+    RenderCommand command = { RENDER_DRAW_MESH, (unsigned int)draws.size() };
+    commands.push_back(command);
+    draws.push_back(draw);
+}
+
+bool RenderCommandList::Reaches(const CubeDraw& draw, const DisplayOutput& output) const {
+    return drawEverywhere ||
+           (draw.x + draw.reach >= output.bounds.left && draw.x - draw.reach <= output.bounds.right &&
+            draw.y + draw.reach >= output.bounds.top && draw.y - draw.reach <= output.bounds.bottom);
+}
+
+void RenderCommandList::Bin(const DisplayTopology& topology) {
+    // Every draw reaches every output in mirror mode, nothing to sort
+    binned = false;
+    if (drawEverywhere) return;
+
+    binScratch.clear();
+    size_t outputs = topology.OutputCount();
+    binStart.assign(outputs + 1, 0);
+    for (size_t i = 0; i < commands.size(); i++) {
+        if (commands[i].type != RENDER_DRAW_MESH) continue;
+        const CubeDraw& draw = draws[commands[i].argument];
+        topology.OutputsTouching(draw.x, draw.y, draw.reach, touching);
+        for (size_t t = 0; t < touching.size(); t++) {
+            binScratch.push_back(std::make_pair(touching[t], (unsigned int)i));
+            binStart[touching[t] + 1]++;
+        }
+    }
+
+    // Counting sort by output; each bin keeps command order
+    for (size_t o = 0; o < outputs; o++) binStart[o + 1] += binStart[o];
+    binCommands.resize(binScratch.size());
+    for (size_t k = 0; k < binScratch.size(); k++) binCommands[binStart[binScratch[k].first]++] = binScratch[k].second;
+    for (size_t o = outputs; o > 0; o--) binStart[o] = binStart[o - 1];
+    binStart[0] = 0;
+    binned = true;
+}
+
+const unsigned int* RenderCommandList::BinBegin(int index) const {
+    if (!binned || index < 0 || index + 1 >= (int)binStart.size()) return NULL;
+    return binCommands.empty() ? NULL : &binCommands[0] + binStart[index];
+}
+
+const unsigned int* RenderCommandList::BinEnd(int index) const {
+    if (!binned || index < 0 || index + 1 >= (int)binStart.size()) return NULL;
+    return binCommands.empty() ? NULL : &binCommands[0] + binStart[index + 1];
+}
+
+RenderCommandCursor::RenderCommandCursor(const RenderCommandList& list, const DisplayOutput& output)
+    : list(list), output(output), binned(false), bin(NULL), binEnd(NULL), next(0), current(NULL) {
+    binned = list.Binned() && output.index >= 0 && output.index < (int)list.BinCount();
+    if (binned) {
+        bin = list.BinBegin(output.index);
+        binEnd = list.BinEnd(output.index);
+    }
+    Advance();
+}
+
+void RenderCommandCursor::Advance() {
+    current = NULL;
+    if (binned) {
+        // Merge the state commands with the output's draws, both in command order
+        const std::vector<unsigned int>& state = list.StateCommands();
+        bool haveState = next < state.size();
+        bool haveDraw = bin != binEnd;
+        if (haveState && (!haveDraw || state[next] < *bin)) {
+            current = &list.Command(state[next++]);
+        } else if (haveDraw) {
+            current = &list.Command(*bin++);
+        }
+        return;
+    }
+    while (next < list.Size()) {
+        const RenderCommand& command = list.Command(next++);
+        if (command.type == RENDER_DRAW_MESH && !list.Reaches(list.Draw(command.argument), output)) continue;
+        current = &command;
+        return;
+    }
+}
+
+void BuildCubeFrame(RenderCommandList& list, const Cube* cubes, size_t count, float cubeSize, bool drawEverywhere) {
+    list.Reset(drawEverywhere);
+    list.Clear(RASTER_OPAQUE);
+    list.SetView();
+    for (size_t i = 0; i < count; i++) {
+        if (!cubes[i].active) continue;
+        CubeDraw draw;
+        DescribeCubeDraw(cubes[i], cubeSize, draw);
+        list.DrawMesh(draw);
+    }
+}
+
+void SoftwareRenderBackend::Execute(const RenderCommandList& commands, const DisplayOutput& output) {
+    for (RenderCommandCursor cursor(commands, output); cursor.Current(); cursor.Advance()) {
+        const RenderCommand& command = *cursor.Current();
+        switch (command.type) {
+        case RENDER_CLEAR:
+            framebuffer.Resize(output.width, output.height);
+            framebuffer.Clear(command.argument);
+            break;
+        case RENDER_SET_VIEW:
+            break;  // ProjectCubeDraw always uses RenderScene's projection
+        case RENDER_DRAW_MESH:
+            {
+                RasterTriangle triangles[12];
+                int count = ProjectCubeDraw(commands.Draw(command.argument), output, triangles);
+                for (int t = 0; t < count; t++) RasterizeTriangle(framebuffer, triangles[t]);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+RecordingRenderBackend::RecordingRenderBackend() {
+    Reset();
+}
+
+void RecordingRenderBackend::Reset() {
+    replays = 0;
+    for (int t = 0; t < RENDER_COMMAND_TYPES; t++) commands[t] = 0;
+    culled = 0;
+    visited = 0;
+    hash = 14695981039346656037ULL;
+}
+
+static void HashBytes(unsigned long long& hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+// Only what the replay runs goes into the hash, so a binned replay and a
+// tested one of the same frame hash the same
+void RecordingRenderBackend::Execute(const RenderCommandList& list, const DisplayOutput& output) {
+    replays++;
+    HashBytes(hash, &output.bounds, sizeof(output.bounds));
+    long long reached = 0;
+    RenderCommandCursor cursor(list, output);
+    for (; cursor.Current(); cursor.Advance()) {
+        const RenderCommand& command = *cursor.Current();
+        HashBytes(hash, &command.type, sizeof(command.type));
+        if (command.type != RENDER_DRAW_MESH) {
+            commands[command.type]++;
+            HashBytes(hash, &command.argument, sizeof(command.argument));
+            continue;
+        }
+        reached++;
+        HashBytes(hash, &list.Draw(command.argument), sizeof(CubeDraw));
+    }
+    commands[RENDER_DRAW_MESH] += (long long)list.DrawCount();
+    culled += (long long)list.DrawCount() - reached;
+    visited += cursor.Binned() ? reached : (long long)list.DrawCount();
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "CubeMesh.h"
+#include "CubeRaster.h"
+#include "CubeTopology.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Rendering as data. A frame is described once, in desktop coordinates, as a
+// list of commands; every output then replays the same list through a
+// backend, which maps the desktop into that output and leaves out draws that
+// do not reach it. The app's two GL paths (CubeGL.h), the software rasterizer
+// and a recorder for benchmarks all take the same list, so what to draw is
+// decided in one place whatever draws it.
+//
+// Once built, a list can be binned against the topology: each draw is sorted
+// into the outputs it reaches through the topology's grid, and a replay into
+// one of those outputs then visits only its own draws. A frame then costs
+// about one grid lookup per draw plus what each output actually shows,
+// rather than a test of every draw against every output.
+
+enum RenderCommandType {
+    RENDER_CLEAR,  // Color and depth; the argument is the RGBA color
+    RENDER_SET_VIEW,  // Viewport and RenderScene's perspective for the output being replayed into
+    RENDER_DRAW_MESH,  // The cube mesh; the argument indexes RenderCommandList::Draw
+    RENDER_COMMAND_TYPES
+};
+
+struct RenderCommand {
+    RenderCommandType type;
+    unsigned int argument;
+};
+
+class RenderCommandList {
+public:
+    RenderCommandList();
+
+    // Start a new frame. With `drawEverywhere` (mirror mode) every draw
+    // reaches every output.
+    void Reset(bool drawEverywhere);
+
+    void Clear(unsigned int rgba);
+    void SetView();
+    void DrawMesh(const CubeDraw& draw);
+
+    size_t Size() const { return commands.size(); }
+    const RenderCommand& Command(size_t i) const { return commands[i]; }
+    const CubeDraw& Draw(unsigned int index) const { return draws[index]; }
+    size_t DrawCount() const { return draws.size(); }
+    bool DrawEverywhere() const { return drawEverywhere; }
+
+    // Whether the draw covers any of `output`, the square test the frame loop
+    // uses to decide which monitors show the cube
+    bool Reaches(const CubeDraw& draw, const DisplayOutput& output) const;
+
+    // Sort the draws into the outputs of `topology` they reach. Until the next
+    // Reset, replays into that topology's outputs visit only their own draws;
+    // the list must not be replayed into any other topology's outputs.
+    void Bin(const DisplayTopology& topology);
+    bool Binned() const { return binned; }
+    size_t BinCount() const { return binned ? binStart.size() - 1 : 0; }  // Outputs binned for
+
+    // Draws binned to output `index`, as indices of their draw commands in
+    // order; NULL if the list is not binned for it
+    const unsigned int* BinBegin(int index) const;
+    const unsigned int* BinEnd(int index) const;
+
+    // Indices of every command but the draws, in order
+    const std::vector<unsigned int>& StateCommands() const { return stateCommands; }
+
+private:
+    std::vector<RenderCommand> commands;
+    std::vector<CubeDraw> draws;
+    bool drawEverywhere;
+
+    std::vector<unsigned int> stateCommands;
+    bool binned;
+    std::vector<unsigned int> binStart;  // Per output and one past the last, into binCommands
+    std::vector<unsigned int> binCommands;
+    std::vector<std::pair<int, unsigned int> > binScratch;  // (output, draw command) pairs while binning
+    std::vector<int> touching;
+};
+
+// The commands a replay into one output runs, in order: every command except
+// the draws that do not reach it. Uses the list's bins where it has them for
+// the output and tests each draw otherwise.
+class RenderCommandCursor {
+public:
+    RenderCommandCursor(const RenderCommandList& list, const DisplayOutput& output);
+
+    // The command at the cursor, NULL past the end
+    const RenderCommand* Current() const { return current; }
+    void Advance();
+
+    // Whether it walks the output's bin rather than every command
+    bool Binned() const { return binned; }
+
+private:
+    const RenderCommandList& list;
+    const DisplayOutput& output;
+    bool binned;
+    const unsigned int* bin;  // Binned: the output's draw commands still to come
+    const unsigned int* binEnd;
+    size_t next;  // Binned: into StateCommands, otherwise into the list
+    const RenderCommand* current;
+};
+
+// RenderScene's frame: clear to black, set the view, draw every active cube
+void BuildCubeFrame(RenderCommandList& list, const Cube* cubes, size_t count, float cubeSize, bool drawEverywhere);
+
+class RenderBackend {
+public:
+    virtual ~RenderBackend() {}
+
+    // Replay `commands` into `output`
+    virtual void Execute(const RenderCommandList& commands, const DisplayOutput& output) = 0;
+};
+
+// RenderSceneSoftware through the command list, into a framebuffer sized to
+// the last output replayed
+class SoftwareRenderBackend : public RenderBackend {
+public:
+    void Execute(const RenderCommandList& commands, const DisplayOutput& output);
+    const SoftwareFramebuffer& Framebuffer() const { return framebuffer; }
+
+private:
+    SoftwareFramebuffer framebuffer;
+};
+
+// Draws nothing: counts what each replay would have drawn and fingerprints
+// the commands, so building and walking command lists can be checked and
+// timed with no renderer behind them
+class RecordingRenderBackend : public RenderBackend {
+public:
+    RecordingRenderBackend();
+
+    void Execute(const RenderCommandList& commands, const DisplayOutput& output);
+    void Reset();
+
+    long long Replays() const { return replays; }
+    long long Commands(RenderCommandType type) const { return commands[type]; }
+    long long DrawsCulled() const { return culled; }  // Draw commands that did not reach their output
+    long long DrawsVisited() const { return visited; }  // Reached or not, draws a replay had to look at
+
+    // FNV-1a over every command replayed and the output it went to: equal
+    // recordings saw equal frames
+    unsigned long long Hash() const { return hash; }
+
+private:
+    long long replays;
+    long long commands[RENDER_COMMAND_TYPES];
+    long long culled;
+    long long visited;
+    unsigned long long hash;
+};
@@ -0,0 +1,150 @@
+#include "CubeRenderThreads.h"
+
+static const unsigned int NO_SLOT = 0xFFFFFFFFu;
+
+static unsigned int LatestSlot(unsigned long long word) { return (unsigned int)(word >> 32); }
+static unsigned int LatestReaders(unsigned long long word) { return (unsigned int)word; }
+
+SceneExchange::SceneExchange(int maxReaders)
+    : slots(maxReaders + 2), latest((unsigned long long)NO_SLOT << 32), latestFrame(0), writing(-1), frames(0) {
+    for (size_t s = 0; s < slots.size(); s++) {
+        slots[s].scene.frame = 0;
+        slots[s].released.store(0);
+        slots[s].acquired = 0;
+        slots[s].retired = true;
+    }
+}
+
+SceneSnapshot& SceneExchange::BeginPublish() {
+    // A retired slot is free once every reader that took it has released it;
+    // the counters restart for its next turn as latest
+    for (size_t s = 0; s < slots.size(); s++) {
+        Slot& slot = slots[s];
+        if (slot.retired && slot.released.load() == slot.acquired) {
+            slot.released.store(0);
+            slot.acquired = 0;
+            writing = (int)s;
+            break;
+        }
+    }
+    return slots[writing].scene;
+}
+
+void SceneExchange::Publish() {
+    Slot& slot = slots[writing];
+    slot.scene.frame = ++frames;
+    slot.retired = false;
+    unsigned long long previous = latest.exchange((unsigned long long)writing << 32);
+    latestFrame.store(frames);
+    unsigned int replaced = LatestSlot(previous);
+    if (replaced != NO_SLOT) {
+        slots[replaced].acquired = LatestReaders(previous);
+        slots[replaced].retired = true;
+    }
+}
+
+const SceneSnapshot* SceneExchange::Acquire() {
+    unsigned int slot = LatestSlot(latest.fetch_add(1));
+    return slot == NO_SLOT ? NULL : &slots[slot].scene;
+}
+
+void SceneExchange::Release(const SceneSnapshot* scene) {
+    for (size_t s = 0; s < slots.size(); s++) {
+        if (&slots[s].scene == scene) {
+            slots[s].released.fetch_add(1);
+            return;
+        }
+    }
+}
+
+SoftwareOutputRenderer::SoftwareOutputRenderer(const DisplayOutput& output, float cubeSize, bool drawEverywhere)
+    : output(output), cubeSize(cubeSize), drawEverywhere(drawEverywhere) {
+}
+
+bool SoftwareOutputRenderer::Begin() {
+    framebuffer.Resize(output.width, output.height);
+    return true;
+}
+
+void SoftwareOutputRenderer::Render(const SceneSnapshot& scene) {
+    const float HALF_SIZE = GetCubeSizeInPixels(cubeSize);
+    framebuffer.Clear(RASTER_OPAQUE);
+    for (size_t i = 0; i < scene.cubes.size(); i++) {
+        const Cube& cube = scene.cubes[i];
+        if (!cube.active) continue;
+        bool touches = cube.x + HALF_SIZE >= output.bounds.left && cube.x - HALF_SIZE <= output.bounds.right &&
+                       cube.y + HALF_SIZE >= output.bounds.top && cube.y - HALF_SIZE <= output.bounds.bottom;
+        if (!drawEverywhere && !touches) continue;
+        RasterTriangle triangles[12];
+        int count = ProjectCube(cube, output, cubeSize, triangles);
+        for (int t = 0; t < count; t++) RasterizeTriangle(framebuffer, triangles[t]);
+    }
+}
+
+void SoftwareOutputRenderer::End() {
+}
+
+OutputRenderThreads::OutputRenderThreads() : stopping(false) {
+}
+
+OutputRenderThreads::~OutputRenderThreads() {
+    Stop();
+}
+
+void OutputRenderThreads::Start(const std::vector<OutputRenderer*>& renderers) {
+    Stop();
+    exchange.reset(new SceneExchange((int)renderers.size()));
+    std::vector<OutputCounters> fresh(renderers.size());
+    counters.swap(fresh);
+    for (size_t o = 0; o < counters.size(); o++) {
+        counters[o].rendered.store(0);
+        counters[o].dropped.store(0);
+        counters[o].lastFrame.store(0);
+    }
+    stopping = false;
+    for (size_t o = 0; o < renderers.size(); o++) {
+        threads.push_back(std::thread(&OutputRenderThreads::RenderLoop, this, (int)o, renderers[o]));
+    }
+}
+
+void OutputRenderThreads::Stop() {
+    if (threads.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    threads.clear();
+    exchange.reset();
+}
+
+void OutputRenderThreads::PublishScene() {
+    exchange->Publish();
+    // The lock only orders this wakeup against a thread about to sleep
+    { std::lock_guard<std::mutex> lock(mutex); }
+    wake.notify_all();
+}
+
+void OutputRenderThreads::RenderLoop(int output, OutputRenderer* renderer) {
+    OutputCounters& counter = counters[output];
+    if (!renderer->Begin()) return;
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || exchange->LatestFrame() != seen; });
+            if (stopping) break;
+        }
+        const SceneSnapshot* scene = exchange->Acquire();
+        if (scene) {
+            renderer->Render(*scene);
+            counter.dropped.fetch_add((long long)(scene->frame - seen - 1));
+            seen = scene->frame;
+            counter.lastFrame.store(seen);
+            counter.rendered.fetch_add(1);
+        }
+        exchange->Release(scene);
+    }
+    renderer->End();
+}
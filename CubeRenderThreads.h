@@ -0,0 +1,157 @@
+#pragma once
+
+#include "CubeRaster.h"
+#include "CubeRenderBackend.h"
+#include "CubeTopology.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One render thread per output, fed by the simulation through immutable
+// scene snapshots.
+//
+// The simulation thread fills a free snapshot slot and publishes it; each
+// render thread takes the latest published slot, draws it and hands it back.
+// Both sides are wait-free: publishing and taking a scene are a bounded number
+// of atomic operations whatever the other threads do, so a slow output just
+// skips the scenes published while it was busy. The only lock is the one
+// render threads sleep on until there is something new.
+//
+// What a thread draws with is an OutputRenderer, so the same threading runs the
+// app's WGL contexts and, headless, the software rasterizer.
+
+struct SceneSnapshot {
+    unsigned long long frame;  // 1 for the first scene published, then counting up
+    std::vector<Cube> cubes;  // Ready to draw, already interpolated
+    RenderCommandList commands;  // The same frame as commands, for renderers that replay it
+};
+
+// Wait-free handoff of the latest SceneSnapshot from one writer to any number
+// of readers, at most `maxReaders` of them holding a scene at a time.
+//
+// The latest slot and a count of the readers that took it share one atomic
+// word, so taking a scene is a single fetch-and-add. When the writer publishes
+// over a slot it swaps the word out and keeps the final count; the slot is free
+// again once that many readers have handed it back. Each reader holds at most
+// one slot, so maxReaders + 2 slots always leave the writer a free one. The
+// count has 32 bits: a scene can be taken 2^32 - 1 times before the next publish.
+class SceneExchange {
+public:
+    explicit SceneExchange(int maxReaders);
+
+    // Writer: fill the slot BeginPublish returns (it may hold an old scene to
+    // reuse), then Publish makes it the latest
+    SceneSnapshot& BeginPublish();
+    void Publish();
+
+    // Frame number of the latest published scene, 0 before the first
+    unsigned long long LatestFrame() const { return latestFrame.load(); }
+
+    // Reader: the latest scene, NULL before the first. It stays unchanged until
+    // handed back with Release (NULL is fine too).
+    const SceneSnapshot* Acquire();
+    void Release(const SceneSnapshot* scene);
+
+    int MaxReaders() const { return (int)slots.size() - 2; }
+
+private:
+    SceneExchange(const SceneExchange&);
+    SceneExchange& operator=(const SceneExchange&);
+
+    // Readers release into their slot's counter, padded so they do not contend
+    struct Slot {
+        SceneSnapshot scene;
+        std::atomic<unsigned int> released;
+        unsigned int acquired;  // Writer only: readers that took the slot while it was latest
+        bool retired;  // Writer only: published and replaced since
+        char padding[64];
+    };
+
+    std::vector<Slot> slots;
+    std::atomic<unsigned long long> latest;  // (slot << 32) | readers that took it
+    std::atomic<unsigned long long> latestFrame;
+    int writing;  // Writer only
+    unsigned long long frames;  // Writer only
+};
+
+// Draws one output from its render thread. Begin and End run on that thread,
+// before its first Render and after its last, so a GL context can stay current
+// for the thread's whole life.
+class OutputRenderer {
+public:
+    virtual ~OutputRenderer() {}
+
+    // False stops the thread before it renders anything
+    virtual bool Begin() = 0;
+    virtual void Render(const SceneSnapshot& scene) = 0;
+    virtual void End() = 0;
+};
+
+// OutputRenderer on the CPU rasterizer: the cubes touching `output` (or all of
+// them with `drawEverywhere`, as in mirror mode), drawn as RenderScene draws them
+class SoftwareOutputRenderer : public OutputRenderer {
+public:
+    SoftwareOutputRenderer(const DisplayOutput& output, float cubeSize, bool drawEverywhere);
+
+    bool Begin();
+    void Render(const SceneSnapshot& scene);
+    void End();
+
+    const SoftwareFramebuffer& Framebuffer() const { return framebuffer; }
+
+private:
+    DisplayOutput output;
+    float cubeSize;
+    bool drawEverywhere;
+    SoftwareFramebuffer framebuffer;
+};
+
+class OutputRenderThreads {
+public:
+    OutputRenderThreads();
+    ~OutputRenderThreads();
+
+    // A thread for each renderer, rendering every scene published from now on.
+    // The renderers must outlive Stop.
+    void Start(const std::vector<OutputRenderer*>& renderers);
+
+    // Wake the threads, let them finish the scene in hand, End and join
+    void Stop();
+
+    bool Running() const { return !threads.empty(); }
+    size_t OutputCount() const { return threads.size(); }
+
+    // Simulation thread: fill the returned scene, then publish it to every
+    // output. Only valid while running.
+    SceneSnapshot& BeginScene() { return exchange->BeginPublish(); }
+    void PublishScene();
+
+    // Per output, since Start
+    long long FramesRendered(size_t output) const { return counters[output].rendered.load(); }
+    long long FramesDropped(size_t output) const { return counters[output].dropped.load(); }
+
+    // Frame number each output last rendered, 0 if none yet
+    unsigned long long LastFrame(size_t output) const { return counters[output].lastFrame.load(); }
+
+private:
+    OutputRenderThreads(const OutputRenderThreads&);
+    OutputRenderThreads& operator=(const OutputRenderThreads&);
+
+    struct OutputCounters {
+        std::atomic<long long> rendered, dropped;
+        std::atomic<unsigned long long> lastFrame;
+        char padding[64 - 3 * sizeof(std::atomic<long long>)];
+    };
+
+    void RenderLoop(int output, OutputRenderer* renderer);
+
+    std::unique_ptr<SceneExchange> exchange;
+    std::vector<std::thread> threads;
+    std::vector<OutputCounters> counters;
+    std::mutex mutex;  // Only for sleeping on `wake`
+    std::condition_variable wake;
+    bool stopping;
+};
@@ -0,0 +1,282 @@
+#include "CubeReplay.h"
+#include "CubeEvents.h"
+#include <cstdio>
+#include <cstring>
+
+static const char REPLAY_MAGIC[8] = { 'C', 'U', 'B', 'E', 'R', 'P', 'L', 'Y' };
+
+// Low two bits of every token
+enum ReplayRecord {
+    RECORD_FRAME = 0,
+    RECORD_HASH = 1,
+    RECORD_TOPOLOGY = 2,
+};
+
+long long AdvanceCubeFrame(Cube& cube, Cube& previous, FixedStepClock& clock, const DisplayTopology& topology,
+                           const CubeSettings& settings, double elapsed) {
+    long long steps = TickFixedStep(clock, elapsed);
+    long long caughtUp = 0;
+    if (steps > CATCH_UP_THRESHOLD_STEPS) {
+        caughtUp = steps - 1;
+        if (topology.Shape()) {
+            AdvanceCubeDesktop(cube, *topology.Shape(), settings, caughtUp);
+        } else {
+            AdvanceCube(cube, topology.PhysicsBounds(), settings, caughtUp);
+        }
+        steps = 1;
+    }
+    for (long long i = 0; i < steps; i++) {
+        previous = cube;
+        if (topology.Shape()) {
+            StepCubeDesktop(cube, *topology.Shape(), settings);
+        } else {
+            StepCube(cube, topology.PhysicsBounds(), settings);
+        }
+    }
+    return caughtUp + steps;
+}
+
+static void HashBytes(unsigned long long& hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+unsigned long long HashCube(const Cube& cube) {
+    // Field by field, so struct padding never leaks into the hash
+    unsigned long long hash = 14695981039346656037ULL;
+    const float floats[] = {
+        cube.x, cube.y, cube.vx, cube.vy, cube.rotationAxisX, cube.rotationAxisY, cube.rotationAxisZ, cube.rotationSpeed,
+        cube.orientation[0], cube.orientation[1], cube.orientation[2], cube.orientation[3],
+    };
+    HashBytes(hash, floats, sizeof(floats));
+    const int ints[] = { cube.stepsSinceNormalize, cube.celebratingCorner ? cube.celebrationTimer : 0, cube.active ? 1 : 0 };
+    HashBytes(hash, ints, sizeof(ints));
+    HashBytes(hash, &cube.randomEvents, sizeof(cube.randomEvents));
+    return hash;
+}
+
+static void PutVarint(std::vector<unsigned char>& out, unsigned long long value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+static unsigned long long ZigZag(long long value) {
+    return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+}
+
+static long long UnZigZag(unsigned long long value) {
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+static void PutFixed64(std::vector<unsigned char>& out, unsigned long long value) {
+    for (int b = 0; b < 8; b++) out.push_back((unsigned char)(value >> (b * 8)));
+}
+
+// Bounds-checked reader over a recording
+struct ReplayReader {
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+    bool failed;
+
+    unsigned long long Varint() {
+        unsigned long long value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (offset >= size) break;
+            unsigned char byte = data[offset++];
+            value |= (unsigned long long)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        failed = true;
+        return 0;
+    }
+
+    unsigned long long Fixed64() {
+        if (size - offset < 8) {
+            failed = true;
+            return 0;
+        }
+        unsigned long long value = 0;
+        for (int b = 0; b < 8; b++) value |= (unsigned long long)data[offset++] << (b * 8);
+        return value;
+    }
+};
+
+ReplayRecorder::ReplayRecorder()
+    : recording(false), hashInterval(0), previousTicks(0), totalSteps(0), nextHashStep(0) {
+}
+
+void ReplayRecorder::Begin(const Cube& cube, const CubeSettings& settings, unsigned long long seed, const DisplayTopology& topology,
+                           long long counterFrequency, int hashIntervalSteps) {
+    recording = true;
+    hashInterval = hashIntervalSteps > 0 ? hashIntervalSteps : PHYSICS_STEPS_PER_SECOND;
+    previousTicks = 0;
+    totalSteps = 0;
+    nextHashStep = hashInterval;
+
+    bytes.assign(REPLAY_MAGIC, REPLAY_MAGIC + sizeof(REPLAY_MAGIC));
+    PutVarint(bytes, CUBE_REPLAY_VERSION);
+    PutVarint(bytes, (unsigned long long)counterFrequency);
+    PutVarint(bytes, (unsigned long long)hashInterval);
+    unsigned int sizeBits;
+    memcpy(&sizeBits, &settings.cubeSize, sizeof(sizeBits));
+    PutVarint(bytes, sizeBits);
+    PutVarint(bytes, settings.enableCelebration ? 1 : 0);
+
+    // The starting cube travels as a one-cube snapshot, which also covers a
+    // cube resumed from disk rather than freshly reset
+    CubeSoA start;
+    start.Resize(1);
+    start.SetCube(0, cube);
+    start.stepsSinceNormalize = cube.stepsSinceNormalize;
+    CubeSnapshotInfo info = { seed, topology.LayoutHash(), topology.PhysicsBounds(), settings.cubeSize };
+    std::vector<unsigned char> image(CubeSnapshotBytes(1));
+    SaveCubeSnapshot(&image[0], start, info);
+    PutVarint(bytes, image.size());
+    bytes.insert(bytes.end(), image.begin(), image.end());
+}
+
+void ReplayRecorder::RecordTopology(const DisplayTopology& topology) {
+    if (!recording) return;
+    PutVarint(bytes, ((unsigned long long)topology.OutputCount() << 2) | RECORD_TOPOLOGY);
+    PutVarint(bytes, ZigZag(topology.PrimaryIndex()));
+    PutVarint(bytes, topology.MirrorMode() ? 1 : 0);
+
+    // Monitors usually share edges with their neighbours, so deltas stay small
+    WorldBounds last = { 0, 0, 0, 0 };
+    for (size_t m = 0; m < topology.OutputCount(); m++) {
+        const WorldBounds& bounds = topology.Output(m).bounds;
+        PutVarint(bytes, ZigZag((long long)bounds.left - last.left));
+        PutVarint(bytes, ZigZag((long long)bounds.top - last.top));
+        PutVarint(bytes, ZigZag((long long)bounds.right - last.right));
+        PutVarint(bytes, ZigZag((long long)bounds.bottom - last.bottom));
+        last = bounds;
+    }
+}
+
+void ReplayRecorder::RecordFrame(long long ticks, long long steps, const Cube& cube) {
+    if (!recording) return;
+    PutVarint(bytes, (ZigZag(ticks - previousTicks) << 2) | RECORD_FRAME);
+    previousTicks = ticks;
+
+    totalSteps += steps;
+    if (totalSteps >= nextHashStep) {
+        PutVarint(bytes, ((unsigned long long)totalSteps << 2) | RECORD_HASH);
+        PutFixed64(bytes, HashCube(cube));
+        nextHashStep = (totalSteps / hashInterval + 1) * hashInterval;
+    }
+}
+
+bool ReplayRecorder::WriteFile(const char* path) const {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool written = bytes.empty() || fwrite(&bytes[0], 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+bool ReadReplayFile(const char* path, std::vector<unsigned char>& bytes) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    bytes.clear();
+    unsigned char chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) bytes.insert(bytes.end(), chunk, chunk + got);
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+bool PlayReplay(const unsigned char* data, size_t size, ReplayResult& result) {
+    memset(&result, 0, sizeof(result));
+    result.firstMismatchFrame = -1;
+    if (size < sizeof(REPLAY_MAGIC) || memcmp(data, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0) return false;
+
+    ReplayReader in = { data, size, sizeof(REPLAY_MAGIC), false };
+    if (in.Varint() != CUBE_REPLAY_VERSION) return false;
+    long long frequency = (long long)in.Varint();
+    in.Varint();  // Hash interval, implied by the hash records themselves
+    CubeSettings settings;
+    unsigned int sizeBits = (unsigned int)in.Varint();
+    memcpy(&settings.cubeSize, &sizeBits, sizeof(sizeBits));
+    settings.enableCelebration = in.Varint() != 0;
+    size_t imageBytes = (size_t)in.Varint();
+    if (in.failed || frequency <= 0 || imageBytes > size - in.offset) return false;
+
+    CubeSoA start;
+    if (!LoadCubeSnapshot(data + in.offset, imageBytes, start, result.start) || start.Size() != 1) return false;
+    in.offset += imageBytes;
+    Cube cube;
+    start.GetCube(0, cube);
+    Cube previous = cube;
+
+    DisplayTopology topology;
+    FixedStepClock clock;
+    InitFixedStepClock(clock, PHYSICS_STEPS_PER_SECOND);
+    long long ticks = 0;
+    long long totalTicks = 0;
+    std::vector<WorldBounds> monitors;
+
+    while (in.offset < size) {
+        unsigned long long token = in.Varint();
+        if (in.failed) return false;
+        switch ((int)(token & 3)) {
+        case RECORD_FRAME:
+            if (result.layouts == 0) return false;
+            ticks += UnZigZag(token >> 2);
+            totalTicks += ticks;
+            result.steps += AdvanceCubeFrame(cube, previous, clock, topology, settings, (double)ticks / frequency);
+            result.frames++;
+            break;
+
+        case RECORD_HASH:
+            {
+                long long steps = (long long)(token >> 2);
+                unsigned long long hash = in.Fixed64();
+                if (in.failed) return false;
+                result.hashesChecked++;
+                if (result.firstMismatchFrame < 0 && (steps != result.steps || hash != HashCube(cube))) {
+                    result.firstMismatchFrame = result.frames;
+                }
+            }
+            break;
+
+        case RECORD_TOPOLOGY:
+            {
+                size_t count = (size_t)(token >> 2);
+                int primary = (int)UnZigZag(in.Varint());
+                bool mirrorMode = in.Varint() != 0;
+                if (count == 0 || count > (size - in.offset) / 4) return false;
+                monitors.assign(count, WorldBounds());
+                WorldBounds last = { 0, 0, 0, 0 };
+                for (size_t m = 0; m < count; m++) {
+                    monitors[m].left = (int)(last.left + UnZigZag(in.Varint()));
+                    monitors[m].top = (int)(last.top + UnZigZag(in.Varint()));
+                    monitors[m].right = (int)(last.right + UnZigZag(in.Varint()));
+                    monitors[m].bottom = (int)(last.bottom + UnZigZag(in.Varint()));
+                    last = monitors[m];
+                }
+                if (in.failed) return false;
+                topology.Build(monitors, primary, mirrorMode, GetCubeSizeInPixels(settings.cubeSize));
+                if (result.layouts > 0) {
+                    KeepCubeOnDesktop(cube, topology);
+                    previous = cube;
+                }
+                result.layouts++;
+            }
+            break;
+
+        default:
+            return false;
+        }
+    }
+
+    result.simulatedSeconds = (double)totalTicks / frequency;
+    result.finalCube = cube;
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CubeClock.h"
+#include "CubeSnapshot.h"
+#include "CubeTopology.h"
+#include <cstddef>
+#include <vector>
+
+// Deterministic record and replay of a screensaver run.
+//
+// Given the starting cube, the settings, the monitor layouts and the raw timer
+// ticks of every presented frame, the physics is fully determined, so that is
+// all a recording holds, plus a hash of the cube every so often to prove a
+// replay took the same path. Playback re-simulates headlessly with the same
+// AdvanceCubeFrame the app runs and checks every hash.
+//
+// Encoding: a header, then a stream of varint tokens whose low two bits give
+// the record kind. Frames, by far the most common record, store only the
+// zigzag-coded change in tick count since the previous frame, which is a byte
+// or two at a steady refresh rate.
+
+const unsigned int CUBE_REPLAY_VERSION = 1;
+
+// Ticks that owe more physics steps than this (session lock, sleep, display
+// off) are caught up in closed form instead of step by step
+const long long CATCH_UP_THRESHOLD_STEPS = PHYSICS_STEPS_PER_SECOND;
+
+// The physics of one presented frame, `elapsed` seconds after the last one:
+// steps come from the fixed-step clock, long gaps are caught up in closed form,
+// and `previous` is left one step behind `cube` for render interpolation.
+// Returns the number of steps the cube moved.
+long long AdvanceCubeFrame(Cube& cube, Cube& previous, FixedStepClock& clock, const DisplayTopology& topology,
+                           const CubeSettings& settings, double elapsed);
+
+// Hash of the cube's full simulation state
+unsigned long long HashCube(const Cube& cube);
+
+class ReplayRecorder {
+public:
+    ReplayRecorder();
+
+    // Start a recording from this state. `seed` is the run's --seed (or the
+    // seed of the world it resumed) and `topology` its layout, kept with the
+    // starting cube so a report can be traced back to the run that reproduces
+    // it. `counterFrequency` is ticks per second of the timer RecordFrame is
+    // fed from.
+    void Begin(const Cube& cube, const CubeSettings& settings, unsigned long long seed, const DisplayTopology& topology,
+               long long counterFrequency, int hashIntervalSteps);
+    bool Recording() const { return recording; }
+
+    // The layout frames from now on run against; the first one must come before
+    // the first frame. Playback applies KeepCubeOnDesktop after every layout
+    // but the first, as the app does on WM_DISPLAYCHANGE.
+    void RecordTopology(const DisplayTopology& topology);
+
+    // One presented frame: `ticks` elapsed, AdvanceCubeFrame ran `steps` steps
+    // and left `cube`
+    void RecordFrame(long long ticks, long long steps, const Cube& cube);
+
+    const std::vector<unsigned char>& Bytes() const { return bytes; }
+    bool WriteFile(const char* path) const;
+
+private:
+    std::vector<unsigned char> bytes;
+    bool recording;
+    int hashInterval;
+    long long previousTicks;
+    long long totalSteps;
+    long long nextHashStep;
+};
+
+struct ReplayResult {
+    long long frames;
+    long long steps;
+    long long layouts;
+    long long hashesChecked;
+    long long firstMismatchFrame;  // -1 if every hash matched
+    double simulatedSeconds;
+    Cube finalCube;
+    CubeSnapshotInfo start;  // Seed, layout hash and bounds the recording began with
+};
+
+// Re-simulate a recording. False if it is malformed; otherwise check
+// result.firstMismatchFrame for divergence.
+bool PlayReplay(const unsigned char* data, size_t size, ReplayResult& result);
+
+bool ReadReplayFile(const char* path, std::vector<unsigned char>& bytes);
@@ -0,0 +1,99 @@
+#include "CubeScheduler.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+SteadySchedulerClock::SteadySchedulerClock(double spinSeconds) : spinSeconds(spinSeconds) {
+}
+
+double SteadySchedulerClock::Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SteadySchedulerClock::SleepUntil(double seconds) {
+    double sleep = seconds - spinSeconds - Now();
+    if (sleep > 0) std::this_thread::sleep_for(std::chrono::duration<double>(sleep));
+    while (Now() < seconds) std::this_thread::yield();
+}
+
+SimulatedSchedulerClock::SimulatedSchedulerClock(double wakeLatency, double wakeJitter, unsigned long long seed)
+    : now(0), wakeLatency(wakeLatency), wakeJitter(wakeJitter), key(CubeRandomKey(seed, 0)), sleeps(0) {
+}
+
+void SimulatedSchedulerClock::SleepUntil(double seconds) {
+    CubeRandom rng = CubeRandomStream(key, sleeps++);
+    double woke = seconds + wakeLatency + wakeJitter * CubeRandomUnit(rng);
+    if (woke > now) now = woke;
+}
+
+FrameScheduler::FrameScheduler(SchedulerClock& clock) : clock(clock) {
+}
+
+void FrameScheduler::SetOutputs(const std::vector<double>& periods) {
+    outputs.clear();
+    missedLog.clear();
+    double now = clock.Now();
+    for (size_t i = 0; i < periods.size(); i++) {
+        Output output = { periods[i], now, 1, 0, 0, 0, 0 };
+        outputs.push_back(output);
+    }
+}
+
+double FrameScheduler::NextDeadline() const {
+    double next = HUGE_VAL;
+    for (size_t i = 0; i < outputs.size(); i++) {
+        double deadline = Deadline(outputs[i]);
+        if (deadline < next) next = deadline;
+    }
+    return next;
+}
+
+void FrameScheduler::Collect(double now, std::vector<int>& due) {
+    due.clear();
+    for (size_t i = 0; i < outputs.size(); i++) {
+        Output& output = outputs[i];
+        double deadline = Deadline(output);
+        if (deadline > now + SCHEDULER_EARLY_SECONDS) continue;
+        due.push_back((int)i);
+
+        double lateness = now > deadline ? now - deadline : 0.0;
+        output.served++;
+        output.totalLateness += lateness;
+        if (lateness > output.maxLateness) output.maxLateness = lateness;
+
+        // Deadlines that went by before this one was served get no frame
+        long long passed = (long long)floor(lateness / output.period);
+        if (passed > 0) {
+            output.missed += passed;
+            if (missedLog.size() < SCHEDULER_MISSED_LOG) {
+                MissedDeadline miss = { (int)i, deadline, now, passed };
+                missedLog.push_back(miss);
+            }
+        }
+        output.index += passed + 1;
+    }
+}
+
+void FrameScheduler::Wait(std::vector<int>& due) {
+    double next = NextDeadline();
+    if (next > clock.Now() && next != HUGE_VAL) clock.SleepUntil(next);
+    Collect(clock.Now(), due);
+}
+
+void FrameScheduler::Restart() {
+    double now = clock.Now();
+    for (size_t i = 0; i < outputs.size(); i++) {
+        outputs[i].start = now;
+        outputs[i].index = 1;
+    }
+}
+
+double FrameScheduler::MeanLateness(size_t output) const {
+    const Output& o = outputs[output];
+    return o.served > 0 ? o.totalLateness / o.served : 0.0;
+}
+
+void FrameScheduler::TakeMissed(std::vector<MissedDeadline>& out) {
+    out.swap(missedLog);
+    missedLog.clear();
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "CubeRandom.h"
+#include <cstddef>
+#include <vector>
+
+// Deadline-based frame pacing, one cadence per output.
+//
+// Each output has a target period (1 / its refresh rate) and a deadline
+// locked to a fixed phase: the k-th frame is due at start + k * period, never
+// at "last wakeup + period", so lateness does not accumulate into drift. The
+// host sleeps until the earliest deadline of all outputs, then asks which
+// outputs are due and renders just those. An output served so late that one
+// or more of its deadlines went by without a frame counts those frames as
+// missed and logs the miss.
+//
+// Time comes from a SchedulerClock: the real monotonic clock in the app, a
+// simulated one with modelled wakeup latency in the bench, so pacing can be
+// checked exactly and quickly on any machine.
+
+class SchedulerClock {
+public:
+    virtual ~SchedulerClock() {}
+
+    // Seconds on a monotonic clock
+    virtual double Now() = 0;
+
+    // Return at or after `seconds`
+    virtual void SleepUntil(double seconds) = 0;
+};
+
+// std::chrono::steady_clock. Sleeps in the OS until shortly before the
+// deadline and yields the rest of the way, since OS sleeps overshoot.
+class SteadySchedulerClock : public SchedulerClock {
+public:
+    explicit SteadySchedulerClock(double spinSeconds = 0.001);
+
+    double Now();
+    void SleepUntil(double seconds);
+
+private:
+    double spinSeconds;
+};
+
+// Time that only moves when told to. Every sleep wakes `wakeLatency` plus a
+// random [0, wakeJitter) late, like an OS timer; Advance stands in for work.
+class SimulatedSchedulerClock : public SchedulerClock {
+public:
+    SimulatedSchedulerClock(double wakeLatency, double wakeJitter, unsigned long long seed);
+
+    double Now() { return now; }
+    void SleepUntil(double seconds);
+    void Advance(double seconds) { now += seconds; }
+
+private:
+    double now;
+    double wakeLatency, wakeJitter;
+    unsigned long long key;
+    unsigned long long sleeps;
+};
+
+// Deadlines of `output` that passed without a frame
+struct MissedDeadline {
+    int output;
+    double deadline;  // The first one missed
+    double served;  // When the output was finally served
+    long long frames;  // How many deadlines went by
+};
+
+// Early wakeups within this of a deadline count as on time rather than costing
+// another sleep
+const double SCHEDULER_EARLY_SECONDS = 0.0002;
+
+// Most missed deadlines kept between TakeMissed calls; the counters see them all
+const size_t SCHEDULER_MISSED_LOG = 256;
+
+class FrameScheduler {
+public:
+    explicit FrameScheduler(SchedulerClock& clock);
+
+    // Replace the outputs, one per period in seconds, all starting now with
+    // their first deadline one period away. Counters start over.
+    void SetOutputs(const std::vector<double>& periods);
+
+    size_t OutputCount() const { return outputs.size(); }
+    double Period(size_t output) const { return outputs[output].period; }
+
+    // Earliest deadline of any output
+    double NextDeadline() const;
+
+    // Outputs due by `now`, ascending, into `due`. Each moves to its first
+    // deadline after `now`.
+    void Collect(double now, std::vector<int>& due);
+
+    // Sleep until the next deadline, then Collect
+    void Wait(std::vector<int>& due);
+
+    // Start the deadlines over from now, e.g. after the display was off, so the
+    // gap is not reported as missed frames
+    void Restart();
+
+    long long FramesServed(size_t output) const { return outputs[output].served; }
+    long long FramesMissed(size_t output) const { return outputs[output].missed; }
+
+    // Seconds from deadline to Collect, over every frame served
+    double MeanLateness(size_t output) const;
+    double MaxLateness(size_t output) const { return outputs[output].maxLateness; }
+
+    // Misses since the last call, oldest first
+    void TakeMissed(std::vector<MissedDeadline>& out);
+
+private:
+    struct Output {
+        double period;
+        double start;
+        long long index;  // Of the next deadline: start + index * period
+        long long served, missed;
+        double totalLateness, maxLateness;
+    };
+
+    double Deadline(const Output& output) const { return output.start + output.index * output.period; }
+
+    SchedulerClock& clock;
+    std::vector<Output> outputs;
+    std::vector<MissedDeadline> missedLog;
+};
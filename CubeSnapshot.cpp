@@ -0,0 +1,236 @@
+#include "CubeSnapshot.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char SNAPSHOT_MAGIC[8] = { 'C', 'U', 'B', 'E', 'S', 'N', 'A', 'P' };
+static const size_t SNAPSHOT_ALIGN = 32;
+static const size_t SNAPSHOT_HEADER_BYTES = 96;  // sizeof(SnapshotHeader) rounded up to SNAPSHOT_ALIGN
+
+struct SnapshotHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int headerBytes;
+    unsigned long long cubeCount;
+    unsigned long long seed;
+    unsigned long long layoutHash;
+    int bounds[4];  // left, top, right, bottom
+    float cubeSize;
+    int stepsSinceNormalize;
+    unsigned long long checksum;  // Of every byte after the header
+};
+static_assert(sizeof(SnapshotHeader) <= SNAPSHOT_HEADER_BYTES, "snapshot header outgrew its reserved space");
+
+// Every CubeSoA array in file order, with its element size
+static const int SNAPSHOT_COLUMNS = 20;
+
+static void SnapshotColumns(const CubeSoA& cubes, const void* columns[SNAPSHOT_COLUMNS], size_t sizes[SNAPSHOT_COLUMNS]) {
+    const float* floats[16] = {
+        cubes.x, cubes.y, cubes.vx, cubes.vy, cubes.axisX, cubes.axisY, cubes.axisZ, cubes.rotationSpeed,
+        cubes.orientationW, cubes.orientationX, cubes.orientationY, cubes.orientationZ,
+        cubes.spinW, cubes.spinX, cubes.spinY, cubes.spinZ,
+    };
+    for (int i = 0; i < 16; i++) {
+        columns[i] = floats[i];
+        sizes[i] = sizeof(float);
+    }
+    columns[16] = cubes.celebrationTimer;
+    sizes[16] = sizeof(int);
+    columns[17] = cubes.color;
+    sizes[17] = sizeof(unsigned int);
+    columns[18] = cubes.randomKey;
+    sizes[18] = sizeof(unsigned long long);
+    columns[19] = cubes.randomEvents;
+    sizes[19] = sizeof(unsigned long long);
+}
+
+static size_t PadToAlignment(size_t bytes) {
+    return (bytes + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+// Four independent multiply-xor lanes, so hashing keeps up with memcpy
+static unsigned long long SnapshotChecksum(const unsigned char* data, size_t bytes) {
+    unsigned long long lanes[4] = { 1, 2, 3, 4 };
+    const unsigned long long PRIME = 0x9E3779B97F4A7C15ULL;
+    size_t words = bytes / 8;
+    size_t w = 0;
+    for (; w + 4 <= words; w += 4) {
+        unsigned long long v[4];
+        memcpy(v, data + w * 8, sizeof(v));
+        for (int k = 0; k < 4; k++) lanes[k] = (lanes[k] ^ v[k]) * PRIME;
+    }
+    for (; w < words; w++) {
+        unsigned long long v;
+        memcpy(&v, data + w * 8, sizeof(v));
+        lanes[0] = (lanes[0] ^ v) * PRIME;
+    }
+    unsigned long long hash = bytes;
+    for (int k = 0; k < 4; k++) hash = (hash ^ (lanes[k] >> 29) ^ lanes[k]) * PRIME;
+    return hash;
+}
+
+size_t CubeSnapshotBytes(size_t cubeCount) {
+    static const size_t sizes[SNAPSHOT_COLUMNS] = {
+        4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, sizeof(int), sizeof(unsigned int),
+        sizeof(unsigned long long), sizeof(unsigned long long),
+    };
+    size_t bytes = SNAPSHOT_HEADER_BYTES;
+    for (int c = 0; c < SNAPSHOT_COLUMNS; c++) bytes += PadToAlignment(cubeCount * sizes[c]);
+    return bytes;
+}
+
+void SaveCubeSnapshot(void* buffer, const CubeSoA& cubes, const CubeSnapshotInfo& info) {
+    unsigned char* out = (unsigned char*)buffer;
+    size_t count = cubes.Size();
+    size_t bytes = CubeSnapshotBytes(count);
+    memset(out, 0, SNAPSHOT_HEADER_BYTES);
+
+    const void* columns[SNAPSHOT_COLUMNS];
+    size_t sizes[SNAPSHOT_COLUMNS];
+    SnapshotColumns(cubes, columns, sizes);
+    size_t offset = SNAPSHOT_HEADER_BYTES;
+    for (int c = 0; c < SNAPSHOT_COLUMNS; c++) {
+        size_t used = count * sizes[c];
+        size_t padded = PadToAlignment(used);
+        if (used > 0) memcpy(out + offset, columns[c], used);
+        memset(out + offset + used, 0, padded - used);
+        offset += padded;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = CUBE_SNAPSHOT_VERSION;
+    header.headerBytes = (unsigned int)SNAPSHOT_HEADER_BYTES;
+    header.cubeCount = count;
+    header.seed = info.seed;
+    header.layoutHash = info.layoutHash;
+    header.bounds[0] = info.bounds.left;
+    header.bounds[1] = info.bounds.top;
+    header.bounds[2] = info.bounds.right;
+    header.bounds[3] = info.bounds.bottom;
+    header.cubeSize = info.cubeSize;
+    header.stepsSinceNormalize = cubes.stepsSinceNormalize;
+    header.checksum = SnapshotChecksum(out + SNAPSHOT_HEADER_BYTES, bytes - SNAPSHOT_HEADER_BYTES);
+    memcpy(out, &header, sizeof(header));
+}
+
+bool LoadCubeSnapshot(const void* data, size_t bytes, CubeSoA& cubes, CubeSnapshotInfo& info) {
+    const unsigned char* in = (const unsigned char*)data;
+    SnapshotHeader header;
+    if (bytes < SNAPSHOT_HEADER_BYTES) return false;
+    memcpy(&header, in, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) return false;
+    if (header.version != CUBE_SNAPSHOT_VERSION || header.headerBytes != SNAPSHOT_HEADER_BYTES) return false;
+
+    // Reject counts whose size would overflow before comparing against the file
+    const unsigned long long MAX_CUBES = 1ULL << 32;
+    if (header.cubeCount > MAX_CUBES) return false;
+    size_t count = (size_t)header.cubeCount;
+    if (CubeSnapshotBytes(count) != bytes) return false;
+    if (SnapshotChecksum(in + SNAPSHOT_HEADER_BYTES, bytes - SNAPSHOT_HEADER_BYTES) != header.checksum) return false;
+
+    cubes.Resize(count);
+    const void* columns[SNAPSHOT_COLUMNS];
+    size_t sizes[SNAPSHOT_COLUMNS];
+    SnapshotColumns(cubes, columns, sizes);
+    size_t offset = SNAPSHOT_HEADER_BYTES;
+    for (int c = 0; c < SNAPSHOT_COLUMNS; c++) {
+        size_t used = count * sizes[c];
+        if (used > 0) memcpy(const_cast<void*>(columns[c]), in + offset, used);
+        offset += PadToAlignment(used);
+    }
+    cubes.stepsSinceNormalize = header.stepsSinceNormalize;
+
+    info.seed = header.seed;
+    info.layoutHash = header.layoutHash;
+    info.bounds.left = header.bounds[0];
+    info.bounds.top = header.bounds[1];
+    info.bounds.right = header.bounds[2];
+    info.bounds.bottom = header.bounds[3];
+    info.cubeSize = header.cubeSize;
+    return true;
+}
+
+// Beside `path`, unique to this process: the preview and fullscreen instances
+// may save at the same time and must not write into one another's file
+static std::string TemporaryPath(const char* path) {
+#ifdef _WIN32
+    unsigned long process = GetCurrentProcessId();
+#else
+    unsigned long process = (unsigned long)getpid();
+#endif
+    return std::string(path) + "." + std::to_string(process) + ".tmp";
+}
+
+bool WriteCubeSnapshot(const char* path, const CubeSoA& cubes, const CubeSnapshotInfo& info) {
+    std::vector<unsigned char> buffer(CubeSnapshotBytes(cubes.Size()));
+    SaveCubeSnapshot(&buffer[0], cubes, info);
+
+    // A reader must never see a half-written file, so write aside and rename
+    std::string temporary = TemporaryPath(path);
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    bool written = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        remove(temporary.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    if (!MoveFileExA(temporary.c_str(), path, MOVEFILE_REPLACE_EXISTING)) {
+#else
+    if (rename(temporary.c_str(), path) != 0) {
+#endif
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ReadCubeSnapshot(const char* path, CubeSoA& cubes, CubeSnapshotInfo& info) {
+    bool loaded = false;
+#ifdef _WIN32
+    // Sharing delete lets another instance's save replace the file while it is mapped here
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view) {
+                loaded = LoadCubeSnapshot(view, (size_t)size.QuadPart, cubes, info);
+                UnmapViewOfFile(view);
+            }
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(path, O_RDONLY);
+    if (file < 0) return false;
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        size_t size = (size_t)status.st_size;
+        void* view = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view != MAP_FAILED) {
+            madvise(view, size, MADV_SEQUENTIAL);
+            loaded = LoadCubeSnapshot(view, size, cubes, info);
+            munmap(view, size);
+        }
+    }
+    close(file);
+#endif
+    return loaded;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CubeSoA.h"
+
+// Versioned binary snapshots of the whole world, so the next activation (or
+// the preview and fullscreen instances, which share the file) carries on where
+// the last one stopped instead of restarting the cube on the primary monitor.
+//
+// Layout: a fixed header, then one column per CubeSoA array, each starting on a
+// 32-byte boundary. Loading maps the file and copies whole columns, so a 1M-cube
+// world resumes at memcpy speed. Integers and floats are stored little-endian
+// as in memory; a reader on any other layout rejects the file by its magic.
+
+const unsigned int CUBE_SNAPSHOT_VERSION = 1;
+
+struct CubeSnapshotInfo {
+    unsigned long long seed;        // Run seed the cubes' random keys came from
+    unsigned long long layoutHash;  // DisplayTopology::LayoutHash when saved
+    WorldBounds bounds;             // Physics bounds when saved
+    float cubeSize;                 // CubeSettings::cubeSize when saved
+};
+
+// Write atomically: a temporary file renamed over `path`. False on any I/O error.
+bool WriteCubeSnapshot(const char* path, const CubeSoA& cubes, const CubeSnapshotInfo& info);
+
+// Map `path` and load it. False, leaving `cubes` and `info` untouched, if the
+// file is missing, from another version, truncated or fails its checksum.
+bool ReadCubeSnapshot(const char* path, CubeSoA& cubes, CubeSnapshotInfo& info);
+
+// The same format in memory, for callers that move it some other way
+size_t CubeSnapshotBytes(size_t cubeCount);
+void SaveCubeSnapshot(void* buffer, const CubeSoA& cubes, const CubeSnapshotInfo& info);
+bool LoadCubeSnapshot(const void* data, size_t bytes, CubeSoA& cubes, CubeSnapshotInfo& info);
@@ -0,0 +1,484 @@
+#include "CubeSoA.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CUBE_SOA_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CUBE_SOA_SSE2 1
+#endif
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static void* AlignedAlloc(size_t bytes) {
+#ifdef _WIN32
+    return _aligned_malloc(bytes, 32);
+#else
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, 32, bytes) != 0) return NULL;
+    return ptr;
+#endif
+}
+
+static void AlignedFree(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+template <typename T>
+static void GrowArray(T*& array, size_t oldCount, size_t newCapacity) {
+    T* grown = static_cast<T*>(AlignedAlloc(newCapacity * sizeof(T)));
+    memset(grown, 0, newCapacity * sizeof(T));
+    if (array) {
+        memcpy(grown, array, oldCount * sizeof(T));
+        AlignedFree(array);
+    }
+    array = grown;
+}
+
+CubeSoA::CubeSoA()
+    : x(NULL), y(NULL), vx(NULL), vy(NULL), axisX(NULL), axisY(NULL), axisZ(NULL),
+      rotationSpeed(NULL), orientationW(NULL), orientationX(NULL), orientationY(NULL), orientationZ(NULL),
+      spinW(NULL), spinX(NULL), spinY(NULL), spinZ(NULL), celebrationTimer(NULL), color(NULL),
+      randomKey(NULL), randomEvents(NULL),
+      stepsSinceNormalize(0), count(0), capacity(0) {
+}
+
+CubeSoA::~CubeSoA() {
+    AlignedFree(x);
+    AlignedFree(y);
+    AlignedFree(vx);
+    AlignedFree(vy);
+    AlignedFree(axisX);
+    AlignedFree(axisY);
+    AlignedFree(axisZ);
+    AlignedFree(rotationSpeed);
+    AlignedFree(orientationW);
+    AlignedFree(orientationX);
+    AlignedFree(orientationY);
+    AlignedFree(orientationZ);
+    AlignedFree(spinW);
+    AlignedFree(spinX);
+    AlignedFree(spinY);
+    AlignedFree(spinZ);
+    AlignedFree(celebrationTimer);
+    AlignedFree(color);
+    AlignedFree(randomKey);
+    AlignedFree(randomEvents);
+}
+
+void CubeSoA::Resize(size_t newCount) {
+    if (newCount > capacity) {
+        size_t newCapacity = (newCount + CUBE_SOA_LANES - 1) / CUBE_SOA_LANES * CUBE_SOA_LANES;
+        GrowArray(x, count, newCapacity);
+        GrowArray(y, count, newCapacity);
+        GrowArray(vx, count, newCapacity);
+        GrowArray(vy, count, newCapacity);
+        GrowArray(axisX, count, newCapacity);
+        GrowArray(axisY, count, newCapacity);
+        GrowArray(axisZ, count, newCapacity);
+        GrowArray(rotationSpeed, count, newCapacity);
+        GrowArray(orientationW, count, newCapacity);
+        GrowArray(orientationX, count, newCapacity);
+        GrowArray(orientationY, count, newCapacity);
+        GrowArray(orientationZ, count, newCapacity);
+        GrowArray(spinW, count, newCapacity);
+        GrowArray(spinX, count, newCapacity);
+        GrowArray(spinY, count, newCapacity);
+        GrowArray(spinZ, count, newCapacity);
+        GrowArray(celebrationTimer, count, newCapacity);
+        GrowArray(color, count, newCapacity);
+        GrowArray(randomKey, count, newCapacity);
+        GrowArray(randomEvents, count, newCapacity);
+        capacity = newCapacity;
+    }
+    count = newCount;
+}
+
+void CubeSoA::SetCube(size_t i, const Cube& cube) {
+    x[i] = cube.x;
+    y[i] = cube.y;
+    vx[i] = cube.vx;
+    vy[i] = cube.vy;
+    axisX[i] = cube.rotationAxisX;
+    axisY[i] = cube.rotationAxisY;
+    axisZ[i] = cube.rotationAxisZ;
+    rotationSpeed[i] = cube.rotationSpeed;
+    orientationW[i] = cube.orientation[0];
+    orientationX[i] = cube.orientation[1];
+    orientationY[i] = cube.orientation[2];
+    orientationZ[i] = cube.orientation[3];
+    spinW[i] = cube.spin[0];
+    spinX[i] = cube.spin[1];
+    spinY[i] = cube.spin[2];
+    spinZ[i] = cube.spin[3];
+    celebrationTimer[i] = cube.celebratingCorner ? cube.celebrationTimer : 0;
+    color[i] = cube.color;
+    randomKey[i] = cube.randomKey;
+    randomEvents[i] = cube.randomEvents;
+}
+
+void CubeSoA::GetCube(size_t i, Cube& cube) const {
+    cube.x = x[i];
+    cube.y = y[i];
+    cube.z = 0.0f;
+    cube.vx = vx[i];
+    cube.vy = vy[i];
+    cube.vz = 0.0f;
+    cube.rotationAxisX = axisX[i];
+    cube.rotationAxisY = axisY[i];
+    cube.rotationAxisZ = axisZ[i];
+    cube.rotationSpeed = rotationSpeed[i];
+    cube.orientation[0] = orientationW[i];
+    cube.orientation[1] = orientationX[i];
+    cube.orientation[2] = orientationY[i];
+    cube.orientation[3] = orientationZ[i];
+    cube.spin[0] = spinW[i];
+    cube.spin[1] = spinX[i];
+    cube.spin[2] = spinY[i];
+    cube.spin[3] = spinZ[i];
+    cube.stepsSinceNormalize = stepsSinceNormalize;
+    cube.celebratingCorner = celebrationTimer[i] > 0;
+    cube.celebrationTimer = celebrationTimer[i];
+    cube.color = color[i];
+    cube.randomKey = randomKey[i];
+    cube.randomEvents = randomEvents[i];
+    cube.active = true;
+}
+
+const char* CubeSoAKernelName() {
+#if defined(CUBE_SOA_AVX2)
+    return "avx2";
+#elif defined(CUBE_SOA_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+// Same comparisons and clamps as StepCube, one cube at a time
+static void IntegrateRange(CubeSoA& cubes, size_t begin, size_t end, const WorldBounds& bounds,
+                           float cubeSizePixels, std::vector<CubeBounce>& bounces) {
+    for (size_t i = begin; i < end; i++) {
+        float px = cubes.x[i] + cubes.vx[i];
+        float py = cubes.y[i] + cubes.vy[i];
+        int walls = 0;
+
+        if (px - cubeSizePixels <= bounds.left) {
+            px = bounds.left + cubeSizePixels;
+            walls |= WALL_LEFT;
+        } else if (px + cubeSizePixels >= bounds.right) {
+            px = bounds.right - cubeSizePixels;
+            walls |= WALL_RIGHT;
+        }
+        if (py - cubeSizePixels <= bounds.top) {
+            py = bounds.top + cubeSizePixels;
+            walls |= WALL_TOP;
+        } else if (py + cubeSizePixels >= bounds.bottom) {
+            py = bounds.bottom - cubeSizePixels;
+            walls |= WALL_BOTTOM;
+        }
+
+        cubes.x[i] = px;
+        cubes.y[i] = py;
+        if (walls) {
+            if (walls & (WALL_LEFT | WALL_RIGHT)) cubes.vx[i] = -cubes.vx[i];
+            if (walls & (WALL_TOP | WALL_BOTTOM)) cubes.vy[i] = -cubes.vy[i];
+            CubeBounce bounce = { (unsigned int)i, walls };
+            bounces.push_back(bounce);
+        }
+    }
+}
+
+// Record lanes whose wall masks are set. Masks come from movemask, one bit per lane.
+static void CollectBounces(size_t base, int maskLow, int maskHigh, int wallLow, int wallHigh,
+                           int maskLowY, int maskHighY, std::vector<CubeBounce>& bounces) {
+    int any = maskLow | maskHigh | maskLowY | maskHighY;
+    while (any) {
+        int lane = 0;
+        while (!(any & (1 << lane))) lane++;
+        any &= ~(1 << lane);
+
+        int bit = 1 << lane;
+        int walls = 0;
+        if (maskLow & bit) walls |= wallLow;
+        if (maskHigh & bit) walls |= wallHigh;
+        if (maskLowY & bit) walls |= WALL_TOP;
+        if (maskHighY & bit) walls |= WALL_BOTTOM;
+        CubeBounce bounce = { (unsigned int)(base + lane), walls };
+        bounces.push_back(bounce);
+    }
+}
+
+void IntegrateCubeSoAScalar(CubeSoA& cubes, const WorldBounds& bounds, float cubeSizePixels, std::vector<CubeBounce>& bounces) {
+    IntegrateRange(cubes, 0, cubes.Size(), bounds, cubeSizePixels, bounces);
+}
+
+void IntegrateCubeSoA(CubeSoA& cubes, const WorldBounds& bounds, float cubeSizePixels, std::vector<CubeBounce>& bounces) {
+    IntegrateCubeSoARange(cubes, 0, cubes.Size(), bounds, cubeSizePixels, bounces);
+}
+
+void IntegrateCubeSoARange(CubeSoA& cubes, size_t begin, size_t end, const WorldBounds& bounds,
+                           float cubeSizePixels, std::vector<CubeBounce>& bounces) {
+    size_t count = end;
+    size_t i = begin;
+
+#if defined(CUBE_SOA_AVX2)
+    const __m256 size = _mm256_set1_ps(cubeSizePixels);
+    const __m256 left = _mm256_set1_ps((float)bounds.left);
+    const __m256 right = _mm256_set1_ps((float)bounds.right);
+    const __m256 top = _mm256_set1_ps((float)bounds.top);
+    const __m256 bottom = _mm256_set1_ps((float)bounds.bottom);
+    const __m256 clampLeft = _mm256_set1_ps(bounds.left + cubeSizePixels);
+    const __m256 clampRight = _mm256_set1_ps(bounds.right - cubeSizePixels);
+    const __m256 clampTop = _mm256_set1_ps(bounds.top + cubeSizePixels);
+    const __m256 clampBottom = _mm256_set1_ps(bounds.bottom - cubeSizePixels);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_load_ps(cubes.vx + i);
+        __m256 vy = _mm256_load_ps(cubes.vy + i);
+        __m256 px = _mm256_add_ps(_mm256_load_ps(cubes.x + i), vx);
+        __m256 py = _mm256_add_ps(_mm256_load_ps(cubes.y + i), vy);
+
+        __m256 hitLeft = _mm256_cmp_ps(_mm256_sub_ps(px, size), left, _CMP_LE_OQ);
+        __m256 hitRight = _mm256_andnot_ps(hitLeft, _mm256_cmp_ps(_mm256_add_ps(px, size), right, _CMP_GE_OQ));
+        __m256 hitTop = _mm256_cmp_ps(_mm256_sub_ps(py, size), top, _CMP_LE_OQ);
+        __m256 hitBottom = _mm256_andnot_ps(hitTop, _mm256_cmp_ps(_mm256_add_ps(py, size), bottom, _CMP_GE_OQ));
+
+        px = _mm256_blendv_ps(px, clampLeft, hitLeft);
+        px = _mm256_blendv_ps(px, clampRight, hitRight);
+        py = _mm256_blendv_ps(py, clampTop, hitTop);
+        py = _mm256_blendv_ps(py, clampBottom, hitBottom);
+        _mm256_store_ps(cubes.x + i, px);
+        _mm256_store_ps(cubes.y + i, py);
+
+        int maskLeft = _mm256_movemask_ps(hitLeft);
+        int maskRight = _mm256_movemask_ps(hitRight);
+        int maskTop = _mm256_movemask_ps(hitTop);
+        int maskBottom = _mm256_movemask_ps(hitBottom);
+        if (maskLeft | maskRight | maskTop | maskBottom) {
+            __m256 flipX = _mm256_and_ps(_mm256_or_ps(hitLeft, hitRight), signBit);
+            __m256 flipY = _mm256_and_ps(_mm256_or_ps(hitTop, hitBottom), signBit);
+            _mm256_store_ps(cubes.vx + i, _mm256_xor_ps(vx, flipX));
+            _mm256_store_ps(cubes.vy + i, _mm256_xor_ps(vy, flipY));
+            CollectBounces(i, maskLeft, maskRight, WALL_LEFT, WALL_RIGHT, maskTop, maskBottom, bounces);
+        }
+    }
+#elif defined(CUBE_SOA_SSE2)
+    const __m128 size = _mm_set1_ps(cubeSizePixels);
+    const __m128 left = _mm_set1_ps((float)bounds.left);
+    const __m128 right = _mm_set1_ps((float)bounds.right);
+    const __m128 top = _mm_set1_ps((float)bounds.top);
+    const __m128 bottom = _mm_set1_ps((float)bounds.bottom);
+    const __m128 clampLeft = _mm_set1_ps(bounds.left + cubeSizePixels);
+    const __m128 clampRight = _mm_set1_ps(bounds.right - cubeSizePixels);
+    const __m128 clampTop = _mm_set1_ps(bounds.top + cubeSizePixels);
+    const __m128 clampBottom = _mm_set1_ps(bounds.bottom - cubeSizePixels);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_load_ps(cubes.vx + i);
+        __m128 vy = _mm_load_ps(cubes.vy + i);
+        __m128 px = _mm_add_ps(_mm_load_ps(cubes.x + i), vx);
+        __m128 py = _mm_add_ps(_mm_load_ps(cubes.y + i), vy);
+
+        __m128 hitLeft = _mm_cmple_ps(_mm_sub_ps(px, size), left);
+        __m128 hitRight = _mm_andnot_ps(hitLeft, _mm_cmpge_ps(_mm_add_ps(px, size), right));
+        __m128 hitTop = _mm_cmple_ps(_mm_sub_ps(py, size), top);
+        __m128 hitBottom = _mm_andnot_ps(hitTop, _mm_cmpge_ps(_mm_add_ps(py, size), bottom));
+
+        // SSE2 has no blendv, so select with and/andnot/or
+        __m128 hitX = _mm_or_ps(hitLeft, hitRight);
+        __m128 hitY = _mm_or_ps(hitTop, hitBottom);
+        __m128 clampX = _mm_or_ps(_mm_and_ps(hitLeft, clampLeft), _mm_and_ps(hitRight, clampRight));
+        __m128 clampY = _mm_or_ps(_mm_and_ps(hitTop, clampTop), _mm_and_ps(hitBottom, clampBottom));
+        px = _mm_or_ps(_mm_andnot_ps(hitX, px), clampX);
+        py = _mm_or_ps(_mm_andnot_ps(hitY, py), clampY);
+        _mm_store_ps(cubes.x + i, px);
+        _mm_store_ps(cubes.y + i, py);
+
+        int maskLeft = _mm_movemask_ps(hitLeft);
+        int maskRight = _mm_movemask_ps(hitRight);
+        int maskTop = _mm_movemask_ps(hitTop);
+        int maskBottom = _mm_movemask_ps(hitBottom);
+        if (maskLeft | maskRight | maskTop | maskBottom) {
+            _mm_store_ps(cubes.vx + i, _mm_xor_ps(vx, _mm_and_ps(hitX, signBit)));
+            _mm_store_ps(cubes.vy + i, _mm_xor_ps(vy, _mm_and_ps(hitY, signBit)));
+            CollectBounces(i, maskLeft, maskRight, WALL_LEFT, WALL_RIGHT, maskTop, maskBottom, bounces);
+        }
+    }
+#endif
+
+    // Tail (and the whole range on targets without SIMD)
+    IntegrateRange(cubes, i, count, bounds, cubeSizePixels, bounces);
+}
+
+void RotateCubeSoA(CubeSoA& cubes) {
+    bool normalize = ++cubes.stepsSinceNormalize >= ORIENTATION_NORMALIZE_INTERVAL;
+    if (normalize) cubes.stepsSinceNormalize = 0;
+    RotateCubeSoARange(cubes, 0, cubes.Size(), normalize);
+}
+
+// Same product as MultiplyQuaternion(orientation, spin, orientation) and the same
+// normalization as NormalizeQuaternion, evaluated in the same order so the
+// vector and scalar paths round identically
+static void RotateScalarRange(CubeSoA& cubes, size_t begin, size_t end, bool normalize) {
+    for (size_t i = begin; i < end; i++) {
+        float q[4] = { cubes.orientationW[i], cubes.orientationX[i], cubes.orientationY[i], cubes.orientationZ[i] };
+        float spin[4] = { cubes.spinW[i], cubes.spinX[i], cubes.spinY[i], cubes.spinZ[i] };
+        float rotated[4];
+        MultiplyQuaternion(rotated, spin, q);
+        if (normalize) NormalizeQuaternion(rotated);
+        cubes.orientationW[i] = rotated[0];
+        cubes.orientationX[i] = rotated[1];
+        cubes.orientationY[i] = rotated[2];
+        cubes.orientationZ[i] = rotated[3];
+    }
+}
+
+void RotateCubeSoARange(CubeSoA& cubes, size_t begin, size_t end, bool normalize) {
+    size_t i = begin;
+
+#if defined(CUBE_SOA_AVX2)
+    const __m256 one = _mm256_set1_ps(1.0f);
+    for (; i + 8 <= end; i += 8) {
+        __m256 ow = _mm256_load_ps(cubes.orientationW + i);
+        __m256 ox = _mm256_load_ps(cubes.orientationX + i);
+        __m256 oy = _mm256_load_ps(cubes.orientationY + i);
+        __m256 oz = _mm256_load_ps(cubes.orientationZ + i);
+        __m256 sw = _mm256_load_ps(cubes.spinW + i);
+        __m256 sx = _mm256_load_ps(cubes.spinX + i);
+        __m256 sy = _mm256_load_ps(cubes.spinY + i);
+        __m256 sz = _mm256_load_ps(cubes.spinZ + i);
+
+        __m256 w = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(sw, ow), _mm256_mul_ps(sx, ox)), _mm256_mul_ps(sy, oy)), _mm256_mul_ps(sz, oz));
+        __m256 x = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sw, ox), _mm256_mul_ps(sx, ow)), _mm256_mul_ps(sy, oz)), _mm256_mul_ps(sz, oy));
+        __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(sw, oy), _mm256_mul_ps(sx, oz)), _mm256_mul_ps(sy, ow)), _mm256_mul_ps(sz, ox));
+        __m256 z = _mm256_add_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(sw, oz), _mm256_mul_ps(sx, oy)), _mm256_mul_ps(sy, ox)), _mm256_mul_ps(sz, ow));
+
+        if (normalize) {
+            __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w, w), _mm256_mul_ps(x, x)), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+            __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared));
+            w = _mm256_mul_ps(w, inv);
+            x = _mm256_mul_ps(x, inv);
+            y = _mm256_mul_ps(y, inv);
+            z = _mm256_mul_ps(z, inv);
+        }
+
+        _mm256_store_ps(cubes.orientationW + i, w);
+        _mm256_store_ps(cubes.orientationX + i, x);
+        _mm256_store_ps(cubes.orientationY + i, y);
+        _mm256_store_ps(cubes.orientationZ + i, z);
+    }
+#elif defined(CUBE_SOA_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= end; i += 4) {
+        __m128 ow = _mm_load_ps(cubes.orientationW + i);
+        __m128 ox = _mm_load_ps(cubes.orientationX + i);
+        __m128 oy = _mm_load_ps(cubes.orientationY + i);
+        __m128 oz = _mm_load_ps(cubes.orientationZ + i);
+        __m128 sw = _mm_load_ps(cubes.spinW + i);
+        __m128 sx = _mm_load_ps(cubes.spinX + i);
+        __m128 sy = _mm_load_ps(cubes.spinY + i);
+        __m128 sz = _mm_load_ps(cubes.spinZ + i);
+
+        __m128 w = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(sw, ow), _mm_mul_ps(sx, ox)), _mm_mul_ps(sy, oy)), _mm_mul_ps(sz, oz));
+        __m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sw, ox), _mm_mul_ps(sx, ow)), _mm_mul_ps(sy, oz)), _mm_mul_ps(sz, oy));
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(sw, oy), _mm_mul_ps(sx, oz)), _mm_mul_ps(sy, ow)), _mm_mul_ps(sz, ox));
+        __m128 z = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(sw, oz), _mm_mul_ps(sx, oy)), _mm_mul_ps(sy, ox)), _mm_mul_ps(sz, ow));
+
+        if (normalize) {
+            __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+            __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+            w = _mm_mul_ps(w, inv);
+            x = _mm_mul_ps(x, inv);
+            y = _mm_mul_ps(y, inv);
+            z = _mm_mul_ps(z, inv);
+        }
+
+        _mm_store_ps(cubes.orientationW + i, w);
+        _mm_store_ps(cubes.orientationX + i, x);
+        _mm_store_ps(cubes.orientationY + i, y);
+        _mm_store_ps(cubes.orientationZ + i, z);
+    }
+#endif
+
+    // Tail (and the whole range on targets without SIMD)
+    RotateScalarRange(cubes, i, end, normalize);
+}
+
+size_t ResolveCubeSoABounces(CubeSoA& cubes, const WorldBounds& bounds, const CubeSettings& settings,
+                             const CubeBounce* bounces, size_t bounceCount) {
+    const float CUBE_SIZE = GetCubeSizeInPixels(settings.cubeSize);
+    const float CORNER_THRESHOLD = CUBE_SIZE * 2;
+
+    // Bounces are rare, so jitter and corner checks stay scalar. Every cube draws
+    // from its own random stream, so the order they are handled in does not matter.
+    size_t corners = 0;
+    for (size_t b = 0; b < bounceCount; b++) {
+        unsigned int i = bounces[b].index;
+        int walls = bounces[b].walls;
+        int wallX = walls & (WALL_LEFT | WALL_RIGHT);
+        int wallY = walls & (WALL_TOP | WALL_BOTTOM);
+        bool hitCorner = false;
+
+        // StepCube handles the horizontal wall before reflecting vy
+        if (wallX && wallY) cubes.vy[i] = -cubes.vy[i];
+        if (wallX) {
+            CubeRandom rng = CubeRandomStream(cubes.randomKey[i], cubes.randomEvents[i]++);
+            ApplyBounceJitter(cubes.vx[i], cubes.vy[i], cubes.axisX[i], cubes.axisY[i], cubes.axisZ[i], cubes.rotationSpeed[i], wallX, rng);
+            hitCorner |= IsCornerBounce(cubes.x[i], cubes.y[i], bounds, wallX, CORNER_THRESHOLD);
+        }
+        if (wallX && wallY) cubes.vy[i] = -cubes.vy[i];
+        if (wallY) {
+            CubeRandom rng = CubeRandomStream(cubes.randomKey[i], cubes.randomEvents[i]++);
+            ApplyBounceJitter(cubes.vx[i], cubes.vy[i], cubes.axisX[i], cubes.axisY[i], cubes.axisZ[i], cubes.rotationSpeed[i], wallY, rng);
+            hitCorner |= IsCornerBounce(cubes.x[i], cubes.y[i], bounds, wallY, CORNER_THRESHOLD);
+        }
+
+        float spin[4];
+        CreateRotationQuaternion(spin, cubes.rotationSpeed[i], cubes.axisX[i], cubes.axisY[i], cubes.axisZ[i]);
+        cubes.spinW[i] = spin[0];
+        cubes.spinX[i] = spin[1];
+        cubes.spinY[i] = spin[2];
+        cubes.spinZ[i] = spin[3];
+
+        if (hitCorner) {
+            corners++;
+            if (settings.enableCelebration && cubes.celebrationTimer[i] <= 0) {
+                cubes.celebrationTimer[i] = CELEBRATION_DURATION;
+            }
+        }
+    }
+    return corners;
+}
+
+void CountDownCubeSoARange(CubeSoA& cubes, size_t begin, size_t end) {
+    // Branch-free so the compiler vectorizes it
+    int* timer = cubes.celebrationTimer;
+    for (size_t i = begin; i < end; i++) {
+        int t = timer[i] - 1;
+        timer[i] = t > 0 ? t : 0;
+    }
+}
+
+size_t UpdateCubeSoA(CubeSoA& cubes, const WorldBounds& bounds, const CubeSettings& settings, std::vector<CubeBounce>& bounces) {
+    bounces.clear();
+    IntegrateCubeSoA(cubes, bounds, GetCubeSizeInPixels(settings.cubeSize), bounces);
+
+    // Spin with this frame's axis before any bounce picks a new one, like StepCube
+    RotateCubeSoA(cubes);
+
+    size_t corners = bounces.empty() ? 0 : ResolveCubeSoABounces(cubes, bounds, settings, &bounces[0], bounces.size());
+    CountDownCubeSoARange(cubes, 0, cubes.Size());
+    return corners;
+}
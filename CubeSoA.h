@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CubeCore.h"
+#include <cstddef>
+#include <vector>
+
+// Structure-of-arrays store for many cubes. Every array is 32-byte aligned and
+// padded to a multiple of CUBE_SOA_LANES so the collision kernel can run whole
+// SSE/AVX registers without a scalar prologue.
+const size_t CUBE_SOA_LANES = 8;
+
+// One cube that touched a wall during UpdateCubeSoA
+struct CubeBounce {
+    unsigned int index;
+    int walls;  // CubeWall bits, at most one horizontal and one vertical
+};
+
+class CubeSoA {
+public:
+    CubeSoA();
+    ~CubeSoA();
+
+    void Resize(size_t count);
+    size_t Size() const { return count; }
+
+    // Copy to and from the AoS representation used by the single-cube path
+    void SetCube(size_t i, const Cube& cube);
+    void GetCube(size_t i, Cube& cube) const;
+
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* axisX;
+    float* axisY;
+    float* axisZ;
+    float* rotationSpeed;
+    float* orientationW;  // Orientation quaternion, one array per component
+    float* orientationX;
+    float* orientationY;
+    float* orientationZ;
+    float* spinW;  // Per-frame rotation quaternion, refreshed after bounces
+    float* spinX;
+    float* spinY;
+    float* spinZ;
+    int* celebrationTimer;  // > 0 while celebrating a corner
+    unsigned int* color;
+    unsigned long long* randomKey;  // See Cube::randomKey
+    unsigned long long* randomEvents;
+
+    // Frames since every orientation was renormalized. Shared by the whole store
+    // so the renormalization pass stays a single vectorizable loop.
+    int stepsSinceNormalize;
+
+private:
+    CubeSoA(const CubeSoA&);
+    CubeSoA& operator=(const CubeSoA&);
+
+    size_t count;
+    size_t capacity;
+};
+
+// Name of the collision kernel compiled into this build ("avx2", "sse2" or "scalar")
+const char* CubeSoAKernelName();
+
+// Integrate every cube by one frame and reflect it off the physics bounds in a
+// single vectorized pass. Cubes that touched a wall are appended to `bounces`.
+void IntegrateCubeSoA(CubeSoA& cubes, const WorldBounds& bounds, float cubeSizePixels, std::vector<CubeBounce>& bounces);
+
+// IntegrateCubeSoA over cubes [begin, end). `begin` must be a multiple of
+// CUBE_SOA_LANES so the vector loads stay aligned.
+void IntegrateCubeSoARange(CubeSoA& cubes, size_t begin, size_t end, const WorldBounds& bounds,
+                           float cubeSizePixels, std::vector<CubeBounce>& bounces);
+
+// Reference implementation of IntegrateCubeSoA without SIMD, used by the benchmark
+void IntegrateCubeSoAScalar(CubeSoA& cubes, const WorldBounds& bounds, float cubeSizePixels, std::vector<CubeBounce>& bounces);
+
+// Apply one frame of spin to every orientation, renormalizing periodically
+void RotateCubeSoA(CubeSoA& cubes);
+
+// RotateCubeSoA over cubes [begin, end), `begin` a multiple of CUBE_SOA_LANES.
+// The caller owns the renormalize schedule.
+void RotateCubeSoARange(CubeSoA& cubes, size_t begin, size_t end, bool normalize);
+
+// Bounce jitter, new spin and corner celebration for cubes IntegrateCubeSoA
+// reported. Returns the number of corner hits.
+size_t ResolveCubeSoABounces(CubeSoA& cubes, const WorldBounds& bounds, const CubeSettings& settings,
+                             const CubeBounce* bounces, size_t bounceCount);
+
+// One frame of celebration countdown for cubes [begin, end)
+void CountDownCubeSoARange(CubeSoA& cubes, size_t begin, size_t end);
+
+// Full frame for every cube: IntegrateCubeSoA, RotateCubeSoA, bounce jitter and
+// corner celebration for the cubes that hit a wall, then celebration countdown.
+// Matches StepCube position/velocity/rotation-axis behavior cube for cube, since
+// each cube draws its jitter from its own counter-based random stream.
+// Returns the number of corner hits this frame.
+size_t UpdateCubeSoA(CubeSoA& cubes, const WorldBounds& bounds, const CubeSettings& settings, std::vector<CubeBounce>& bounces);
@@ -0,0 +1,216 @@
+#include "CubeTiles.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CUBE_TILES_SSE2 1
+#endif
+
+// Cubes projected per pool task
+static const size_t PROJECT_CHUNK = 64;
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TiledRenderer::TiledRenderer()
+    : binSeconds(0), tileSeconds(0), pixelsTouched(0), drawnOutputs(0), dirtyTracking(true), redrawAll(true),
+      imageSharing(true), layoutGeneration(0), layoutTopology(NULL) {
+}
+
+void TiledRenderer::SetImageSharing(bool enabled) {
+    if (enabled == imageSharing) return;
+    imageSharing = enabled;
+    layoutTopology = NULL;
+}
+
+void TiledRenderer::Layout(const DisplayTopology& topology) {
+    layoutTopology = &topology;
+    layoutGeneration = topology.Generation();
+    size_t outputs = topology.OutputCount();
+    framebuffers.resize(outputs);
+    present.resize(outputs);
+    source.resize(outputs);
+    firstTile.assign(outputs, 0);
+    tilesAcross.assign(outputs, 0);
+    tiles.clear();
+    drawnOutputs = 0;
+    for (size_t o = 0; o < outputs; o++) {
+        const DisplayOutput& output = topology.Output(o);
+        source[o] = imageSharing ? output.imageSource : (int)o;
+        if (source[o] != (int)o) {
+            framebuffers[o] = SoftwareFramebuffer();
+            std::vector<unsigned int>().swap(present[o]);
+            continue;
+        }
+        drawnOutputs++;
+        framebuffers[o].Resize(output.width, output.height);
+        present[o].assign((size_t)std::max(output.width, 1) * std::max(output.height, 1), 0);
+        firstTile[o] = (int)tiles.size();
+        tilesAcross[o] = (output.width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+        for (int top = 0; top < output.height; top += RASTER_TILE_SIZE) {
+            for (int left = 0; left < output.width; left += RASTER_TILE_SIZE) {
+                Tile tile;
+                tile.output = (int)o;
+                tile.rect.left = left;
+                tile.rect.top = top;
+                tile.rect.right = std::min(left + RASTER_TILE_SIZE, output.width);
+                tile.rect.bottom = std::min(top + RASTER_TILE_SIZE, output.height);
+                tiles.push_back(tile);
+            }
+        }
+    }
+    bins.resize(tiles.size());
+    tileDrawn.assign(tiles.size(), 0);
+    dirtyRects.resize(outputs);
+    redrawAll = true;
+}
+
+// Merge the dirty tiles, in output and row order, into runs along each row of
+// tiles, and runs spanning the same columns in adjacent rows into one rectangle
+void TiledRenderer::MergeDirtyTiles() {
+    for (size_t o = 0; o < dirtyRects.size(); o++) dirtyRects[o].clear();
+    pixelsTouched = 0;
+    for (size_t d = 0; d < dirtyTiles.size();) {
+        const Tile& first = tiles[dirtyTiles[d]];
+        RasterRect run = first.rect;
+        size_t next = d + 1;
+        while (next < dirtyTiles.size() && dirtyTiles[next] == dirtyTiles[next - 1] + 1 &&
+               tiles[dirtyTiles[next]].output == first.output && tiles[dirtyTiles[next]].rect.top == run.top) {
+            run.right = tiles[dirtyTiles[next]].rect.right;
+            next++;
+        }
+        d = next;
+        pixelsTouched += (long long)(run.right - run.left) * (run.bottom - run.top);
+
+        std::vector<RasterRect>& rects = dirtyRects[first.output];
+        bool merged = false;
+        for (size_t r = rects.size(); r-- > 0;) {
+            if (rects[r].bottom == run.top && rects[r].left == run.left && rects[r].right == run.right) {
+                rects[r].bottom = run.bottom;
+                merged = true;
+                break;
+            }
+        }
+        if (!merged) rects.push_back(run);
+    }
+}
+
+// RGBA to the BGRA a DIB section expects: swap the red and blue bytes
+static void ConvertTile(const SoftwareFramebuffer& framebuffer, unsigned int* present, const RasterRect& rect) {
+    int width = framebuffer.Width();
+    for (int y = rect.top; y < rect.bottom; y++) {
+        const unsigned int* in = framebuffer.Row(y);
+        unsigned int* out = present + (size_t)y * width;
+        int x = rect.left;
+#if defined(CUBE_TILES_SSE2)
+        const __m128i redBlue = _mm_set1_epi32(0x00FF00FF);
+        for (; x + 4 <= rect.right; x += 4) {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(in + x));
+            __m128i rb = _mm_and_si128(pixels, redBlue);
+            __m128i swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+            _mm_storeu_si128((__m128i*)(out + x), _mm_or_si128(_mm_andnot_si128(redBlue, pixels), _mm_and_si128(swapped, redBlue)));
+        }
+#endif
+        for (; x < rect.right; x++) {
+            unsigned int p = in[x];
+            out[x] = (p & 0xFF00FF00u) | ((p & 0xFF) << 16) | ((p >> 16) & 0xFF);
+        }
+    }
+}
+
+void TiledRenderer::Render(const DisplayTopology& topology, const Cube* cubes, size_t count, float cubeSize, CubeWorkerPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+    if (layoutTopology != &topology || layoutGeneration != topology.Generation()) Layout(topology);
+
+    // Project in parallel, each chunk into its own list. Each cube goes only
+    // to the outputs the topology's grid says it touches (all of them in
+    // mirror mode), not to every output in turn.
+    const float HALF_SIZE = GetCubeSizeInPixels(cubeSize);
+    bool everywhere = topology.MirrorMode();
+    size_t chunks = (count + PROJECT_CHUNK - 1) / PROJECT_CHUNK;
+    if (chunkTriangles.size() < chunks) chunkTriangles.resize(chunks);
+    if (chunkOutputs.size() < chunks) chunkOutputs.resize(chunks);
+    pool.ParallelFor(chunks, [&](size_t c) {
+        std::vector<BinnedTriangle>& list = chunkTriangles[c];
+        std::vector<int>& touched = chunkOutputs[c];
+        list.clear();
+        size_t end = std::min(count, (c + 1) * PROJECT_CHUNK);
+        for (size_t i = c * PROJECT_CHUNK; i < end; i++) {
+            const Cube& cube = cubes[i];
+            if (!cube.active) continue;
+            if (everywhere) {
+                touched.clear();
+                for (size_t o = 0; o < topology.OutputCount(); o++) touched.push_back((int)o);
+            } else {
+                topology.OutputsTouching(cube.x, cube.y, HALF_SIZE, touched);
+            }
+            for (size_t k = 0; k < touched.size(); k++) {
+                int o = touched[k];
+                if (source[o] != o) continue;
+                const DisplayOutput& output = topology.Output(o);
+                RasterTriangle projected[12];
+                int n = ProjectCube(cube, output, cubeSize, projected);
+                for (int t = 0; t < n; t++) {
+                    BinnedTriangle binned = { projected[t], o };
+                    list.push_back(binned);
+                }
+            }
+        }
+    });
+
+    // Bin in cube order so each tile draws its triangles in the order a
+    // single-threaded renderer would
+    triangles.clear();
+    for (size_t t = 0; t < bins.size(); t++) bins[t].clear();
+    for (size_t c = 0; c < chunks; c++) {
+        for (size_t k = 0; k < chunkTriangles[c].size(); k++) {
+            const BinnedTriangle& binned = chunkTriangles[c][k];
+            const RasterTriangle& t = binned.triangle;
+            const SoftwareFramebuffer& framebuffer = framebuffers[binned.output];
+            float minX = std::min(t.v[0].x, std::min(t.v[1].x, t.v[2].x));
+            float maxX = std::max(t.v[0].x, std::max(t.v[1].x, t.v[2].x));
+            float minY = std::min(t.v[0].y, std::min(t.v[1].y, t.v[2].y));
+            float maxY = std::max(t.v[0].y, std::max(t.v[1].y, t.v[2].y));
+            float width = (float)framebuffer.Width(), height = (float)framebuffer.Height();
+            if (!(maxX >= 0.0f && minX <= width && maxY >= 0.0f && minY <= height)) continue;
+            int left = (int)std::max(minX, 0.0f) / RASTER_TILE_SIZE;
+            int right = std::min((int)std::min(maxX, width - 1.0f), framebuffer.Width() - 1) / RASTER_TILE_SIZE;
+            int top = (int)std::max(minY, 0.0f) / RASTER_TILE_SIZE;
+            int bottom = std::min((int)std::min(maxY, height - 1.0f), framebuffer.Height() - 1) / RASTER_TILE_SIZE;
+
+            int index = (int)triangles.size();
+            triangles.push_back(binned);
+            int across = tilesAcross[binned.output];
+            for (int ty = top; ty <= bottom; ty++) {
+                for (int tx = left; tx <= right; tx++) bins[firstTile[binned.output] + ty * across + tx].push_back(index);
+            }
+        }
+    }
+    binSeconds = SecondsSince(start);
+
+    // A tile needs work if it has triangles now or had some last frame; the
+    // rest are still the cleared background
+    start = std::chrono::steady_clock::now();
+    dirtyTiles.clear();
+    for (size_t i = 0; i < tiles.size(); i++) {
+        bool drawn = !bins[i].empty();
+        if (redrawAll || drawn || tileDrawn[i]) dirtyTiles.push_back((int)i);
+        tileDrawn[i] = drawn;
+    }
+    redrawAll = !dirtyTracking;
+    MergeDirtyTiles();
+
+    pool.ParallelFor(dirtyTiles.size(), [&](size_t d) {
+        int i = dirtyTiles[d];
+        const Tile& tile = tiles[i];
+        SoftwareFramebuffer& framebuffer = framebuffers[tile.output];
+        framebuffer.ClearRect(tile.rect, RASTER_OPAQUE);
+        const std::vector<int>& bin = bins[i];
+        for (size_t k = 0; k < bin.size(); k++) RasterizeTriangle(framebuffer, triangles[bin[k]].triangle, tile.rect);
+        ConvertTile(framebuffer, &present[tile.output][0], tile.rect);
+    });
+    tileSeconds = SecondsSince(start);
+}
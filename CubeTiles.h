@@ -0,0 +1,100 @@
+#pragma once
+
+#include "CubeParallel.h"
+#include "CubeRaster.h"
+#include "CubeTopology.h"
+#include <cstddef>
+#include <vector>
+
+// Multithreaded software rendering of every output in one pass.
+//
+// Each frame the cubes are projected into the outputs they touch and their
+// triangles sorted into fixed-size screen tiles across all outputs. The tiles
+// then go to the worker pool: a thread clears its tile, rasterizes the tile's
+// triangles clipped to it and converts the tile to the 32-bit BGRA layout GDI
+// presents. No two threads touch the same pixel, so nothing is locked.
+//
+// Only tiles with triangles in this frame or the last are cleared, drawn and
+// converted; every other tile still holds the background it was left with.
+// Those dirty tiles, merged into rectangles, are all a partial present has to
+// copy to the screen.
+//
+// Outputs showing the same picture as a lower-numbered one (mirror mode on
+// monitors of the same resolution, or cloned displays; see
+// DisplayOutput::imageSource) get no tiles of their own: the picture is drawn
+// once and their framebuffer, present buffer and dirty rectangles are the
+// first one's.
+//
+// Triangles are binned in cube order, so every pixel sees the same sequence of
+// triangles as drawing each output whole, and frames come out bit-identical to
+// RenderSceneSoftware for any thread count.
+
+// Tile edge in pixels, a multiple of RASTER_LANES
+const int RASTER_TILE_SIZE = 64;
+
+class TiledRenderer {
+public:
+    TiledRenderer();
+
+    // One frame: clear every output of `topology` and draw each cube on the
+    // outputs it touches (on all of them in mirror mode), as AdvanceFrame does
+    // through RenderScene
+    void Render(const DisplayTopology& topology, const Cube* cubes, size_t count, float cubeSize, CubeWorkerPool& pool);
+
+    size_t OutputCount() const { return framebuffers.size(); }
+    const SoftwareFramebuffer& Framebuffer(size_t output) const { return framebuffers[source[output]]; }
+
+    // Top-down BGRA rows of `width` pixels each, ready for SetDIBitsToDevice
+    const unsigned int* Present(size_t output) const { return &present[source[output]][0]; }
+
+    // Outputs drawn by the last layout, the rest share one of their pictures
+    size_t DrawnOutputCount() const { return drawnOutputs; }
+
+    size_t TileCount() const { return tiles.size(); }
+
+    // Parts of `output` the last Render changed. After a layout change, or with
+    // dirty tracking off, that is the whole output.
+    const std::vector<RasterRect>& DirtyRects(size_t output) const { return dirtyRects[source[output]]; }
+
+    // On by default. Off clears and redraws every tile each frame.
+    void SetDirtyTracking(bool enabled) { dirtyTracking = enabled; }
+
+    // On by default. Off draws every output itself, shared picture or not.
+    void SetImageSharing(bool enabled);
+
+    // Seconds the last Render spent projecting and binning, and in the tiles
+    double binSeconds, tileSeconds;
+    long long pixelsTouched;  // Cleared, drawn and converted by the last Render
+
+private:
+    struct Tile {
+        int output;
+        RasterRect rect;
+    };
+
+    struct BinnedTriangle {
+        RasterTriangle triangle;
+        int output;
+    };
+
+    void Layout(const DisplayTopology& topology);
+    void MergeDirtyTiles();
+
+    std::vector<SoftwareFramebuffer> framebuffers;  // Empty for outputs sharing another's picture
+    std::vector<int> source;  // Per output, the output whose buffers it shows
+    size_t drawnOutputs;
+    std::vector<std::vector<unsigned int> > present;
+    std::vector<Tile> tiles;
+    std::vector<int> firstTile;  // Per output, index of its top-left tile
+    std::vector<int> tilesAcross;  // Per output
+    std::vector<std::vector<int> > bins;  // Per tile, indices into `triangles`
+    std::vector<BinnedTriangle> triangles;
+    std::vector<std::vector<BinnedTriangle> > chunkTriangles;
+    std::vector<std::vector<int> > chunkOutputs;  // Per chunk, scratch for OutputsTouching
+    std::vector<unsigned char> tileDrawn;  // Per tile, whether the last frame drew into it
+    std::vector<int> dirtyTiles;
+    std::vector<std::vector<RasterRect> > dirtyRects;  // Per output
+    bool dirtyTracking, redrawAll, imageSharing;
+    unsigned int layoutGeneration;
+    const DisplayTopology* layoutTopology;
+};
@@ -0,0 +1,204 @@
+#include "CubeTopology.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+// FNV-1a over the layout's integers
+static unsigned long long HashLayout(const std::vector<WorldBounds>& monitors, int primary, bool mirrorMode) {
+    unsigned long long hash = 14695981039346656037ULL;
+    std::vector<int> values;
+    values.push_back((int)monitors.size());
+    values.push_back(primary);
+    values.push_back(mirrorMode ? 1 : 0);
+    for (size_t m = 0; m < monitors.size(); m++) {
+        values.push_back(monitors[m].left);
+        values.push_back(monitors[m].top);
+        values.push_back(monitors[m].right);
+        values.push_back(monitors[m].bottom);
+    }
+    for (size_t i = 0; i < values.size(); i++) {
+        unsigned int v = (unsigned int)values[i];
+        for (int b = 0; b < 4; b++) {
+            hash ^= (v >> (b * 8)) & 0xFF;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+void SetOutputView(DisplayOutput& output, const WorldBounds& view) {
+    output.view = view;
+    int viewWidth = view.right - view.left;
+    int viewHeight = view.bottom - view.top;
+    output.viewScaleX = viewWidth > 0 ? 4.0f * output.aspect / viewWidth : 0.0f;
+    output.viewScaleY = viewHeight > 0 ? 4.0f / viewHeight : 0.0f;
+}
+
+DisplayTopology::DisplayTopology()
+    : primaryIndex(0), mirrorMode(false), generation(0), layoutHash(0), gridLeft(0), gridTop(0), gridRight(0),
+      gridBottom(0), cellSize(1), cellsX(0), cellsY(0) {
+    physicsBounds.left = physicsBounds.top = physicsBounds.right = physicsBounds.bottom = 0;
+}
+
+void DisplayTopology::Build(const std::vector<WorldBounds>& monitors, int primary, bool mirror, float cubeSizePixels) {
+    generation++;
+    mirrorMode = mirror;
+    outputs.clear();
+    primaryIndex = primary >= 0 && primary < (int)monitors.size() ? primary : 0;
+    physicsBounds.left = physicsBounds.top = physicsBounds.right = physicsBounds.bottom = 0;
+    layoutHash = HashLayout(monitors, primaryIndex, mirrorMode);
+
+    for (size_t m = 0; m < monitors.size(); m++) {
+        DisplayOutput output;
+        output.bounds = monitors[m];
+        output.width = monitors[m].right - monitors[m].left;
+        output.height = monitors[m].bottom - monitors[m].top;
+        output.aspect = output.height > 0 ? (float)output.width / output.height : 1.0f;
+        output.primary = (int)m == primaryIndex;
+        output.index = (int)m;
+        outputs.push_back(output);
+    }
+
+    for (size_t m = 0; m < outputs.size(); m++) {
+        DisplayOutput& output = outputs[m];
+        SetOutputView(output, mirrorMode ? outputs[primaryIndex].bounds : output.bounds);
+        output.imageSource = (int)m;
+        for (size_t s = 0; s < m; s++) {
+            const DisplayOutput& other = outputs[s];
+            if (other.imageSource == (int)s && other.width == output.width && other.height == output.height &&
+                other.view.left == output.view.left && other.view.top == output.view.top &&
+                other.view.right == output.view.right && other.view.bottom == output.view.bottom) {
+                output.imageSource = (int)s;
+                break;
+            }
+        }
+    }
+
+    std::vector<WorldBounds> none;
+    shape.Build(mirrorMode ? none : monitors, cubeSizePixels);
+    BuildGrid();
+    if (outputs.empty()) return;
+    physicsBounds = mirrorMode ? outputs[primaryIndex].bounds : shape.BoundingBox();
+}
+
+void DisplayTopology::BuildGrid() {
+    cellStart.clear();
+    cellOutputs.clear();
+    cellsX = cellsY = 0;
+    if (outputs.empty()) return;
+    gridLeft = gridTop = INT_MAX;
+    gridRight = gridBottom = INT_MIN;
+    for (size_t m = 0; m < outputs.size(); m++) {
+        const WorldBounds& b = outputs[m].bounds;
+        gridLeft = std::min(gridLeft, b.left);
+        gridTop = std::min(gridTop, b.top);
+        gridRight = std::max(gridRight, b.right);
+        gridBottom = std::max(gridBottom, b.bottom);
+    }
+
+    // Cells about the size of an average monitor, so each overlaps a handful
+    double area = ((double)gridRight - gridLeft + 1) * ((double)gridBottom - gridTop + 1);
+    cellSize = std::max(1, (int)ceil(sqrt(area / outputs.size())));
+    cellsX = (int)(((long long)gridRight - gridLeft) / cellSize + 1);
+    cellsY = (int)(((long long)gridBottom - gridTop) / cellSize + 1);
+
+    // Count, then fill: outputs go in ascending order within each cell
+    size_t cells = (size_t)cellsX * cellsY;
+    cellStart.assign(cells + 1, 0);
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t m = 0; m < outputs.size(); m++) {
+            const WorldBounds& b = outputs[m].bounds;
+            int i0 = CellColumn((float)b.left), i1 = CellColumn((float)b.right);
+            int j0 = CellRow((float)b.top), j1 = CellRow((float)b.bottom);
+            for (int j = j0; j <= j1; j++) {
+                for (int i = i0; i <= i1; i++) {
+                    size_t cell = (size_t)j * cellsX + i;
+                    if (pass == 0) {
+                        cellStart[cell + 1]++;
+                    } else {
+                        cellOutputs[cellStart[cell]++] = (int)m;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (size_t c = 0; c < cells; c++) cellStart[c + 1] += cellStart[c];
+            cellOutputs.resize(cellStart[cells]);
+        } else {
+            // Filling advanced each start to the next cell's
+            for (size_t c = cells; c > 0; c--) cellStart[c] = cellStart[c - 1];
+            cellStart[0] = 0;
+        }
+    }
+}
+
+// Grid column or row of a desktop coordinate, clamped to the grid
+int DisplayTopology::CellColumn(float x) const {
+    double column = floor(((double)x - gridLeft) / cellSize);
+    return column < 0 ? 0 : column >= cellsX ? cellsX - 1 : (int)column;
+}
+
+int DisplayTopology::CellRow(float y) const {
+    double row = floor(((double)y - gridTop) / cellSize);
+    return row < 0 ? 0 : row >= cellsY ? cellsY - 1 : (int)row;
+}
+
+const DesktopShape* DisplayTopology::Shape() const {
+    return mirrorMode || shape.Empty() ? NULL : &shape;
+}
+
+int DisplayTopology::OutputAt(float x, float y) const {
+    if (cellsX == 0 || !(x >= gridLeft && x < gridRight && y >= gridTop && y < gridBottom)) return -1;
+    size_t cell = (size_t)CellRow(y) * cellsX + CellColumn(x);
+    for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+        const WorldBounds& b = outputs[cellOutputs[k]].bounds;
+        if (x >= b.left && x < b.right && y >= b.top && y < b.bottom) return cellOutputs[k];
+    }
+    return -1;
+}
+
+void DisplayTopology::OutputsTouching(float x, float y, float halfSize, std::vector<int>& result) const {
+    result.clear();
+    if (cellsX == 0) return;
+    float left = x - halfSize, right = x + halfSize, top = y - halfSize, bottom = y + halfSize;
+    if (!(right >= gridLeft && left <= gridRight && bottom >= gridTop && top <= gridBottom)) return;
+    int i0 = CellColumn(left), i1 = CellColumn(right);
+    int j0 = CellRow(top), j1 = CellRow(bottom);
+    for (int j = j0; j <= j1; j++) {
+        for (int i = i0; i <= i1; i++) {
+            size_t cell = (size_t)j * cellsX + i;
+            for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                const WorldBounds& b = outputs[cellOutputs[k]].bounds;
+                if (right >= b.left && left <= b.right && bottom >= b.top && top <= b.bottom) {
+                    result.push_back(cellOutputs[k]);
+                }
+            }
+        }
+    }
+
+    // An output spanning several of the cells was found once per cell
+    if (i0 != i1 || j0 != j1) {
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+}
+
+void PlaceCubeOnPrimary(Cube& cube, const DisplayTopology& topology) {
+    if (topology.OutputCount() == 0) return;
+    const WorldBounds& primary = topology.Output(topology.PrimaryIndex()).bounds;
+    cube.x = (primary.left + primary.right) / 2.0f;
+    cube.y = (primary.top + primary.bottom) / 2.0f;
+    if (topology.Shape()) {
+        topology.Shape()->FindStart(primary, cube.x, cube.y);
+    }
+}
+
+bool KeepCubeOnDesktop(Cube& cube, const DisplayTopology& topology) {
+    const WorldBounds& bounds = topology.PhysicsBounds();
+    bool inside = topology.Shape()
+        ? topology.Shape()->Contains(cube.x, cube.y)
+        : cube.x >= bounds.left && cube.x <= bounds.right && cube.y >= bounds.top && cube.y <= bounds.bottom;
+    if (inside) return false;
+    PlaceCubeOnPrimary(cube, topology);
+    return true;
+}
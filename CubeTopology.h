@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CubeDesktop.h"
+#include <cstddef>
+#include <vector>
+
+// Everything the frame loop needs to know about the monitor layout, worked out
+// once when the layout changes instead of asked of the OS on every tick.
+//
+// Platform-free: the app fills it from EnumDisplayMonitors (and again on
+// WM_DISPLAYCHANGE), the bench fills it from synthetic layouts.
+
+struct DisplayOutput {
+    WorldBounds bounds;
+    int width, height;
+    float aspect;  // width / height, for the projection
+    bool primary;
+    int index;  // Position in the topology
+
+    // The desktop rectangle drawn into the output, scaled to fit: its own
+    // bounds, or the primary's in mirror mode so every output shows the cube
+    // where the primary does
+    WorldBounds view;
+
+    // How CubeDrawOffset maps desktop pixels into the view, worked out once
+    // per layout instead of per draw
+    float viewScaleX, viewScaleY;
+
+    // Lowest index of the outputs with the same view and size, and so the same
+    // picture; this output's own index if it is the first. Renderers can draw
+    // the picture once and show it on all of them.
+    int imageSource;
+};
+
+// Point `output` at the desktop rectangle `view` and work out the mapping into
+// it. Bounds, size and aspect must already be set.
+void SetOutputView(DisplayOutput& output, const WorldBounds& view);
+
+class DisplayTopology {
+public:
+    DisplayTopology();
+
+    // Rebuild for a new layout. `primary` indexes `monitors` (clamped to 0 if
+    // out of range). The desktop shape is only built outside mirror mode.
+    void Build(const std::vector<WorldBounds>& monitors, int primary, bool mirrorMode, float cubeSizePixels);
+
+    // Bumped by every Build so holders of derived state can tell it is stale
+    unsigned int Generation() const { return generation; }
+
+    // Hash of the monitor rectangles, their order and mirror mode. Saved state
+    // from a desktop with the same hash can be resumed as is.
+    unsigned long long LayoutHash() const { return layoutHash; }
+
+    size_t OutputCount() const { return outputs.size(); }
+    const DisplayOutput& Output(size_t i) const { return outputs[i]; }
+    int PrimaryIndex() const { return primaryIndex; }
+    bool MirrorMode() const { return mirrorMode; }
+
+    // The rectangle StepCube bounces in: the primary monitor in mirror mode,
+    // otherwise the bounding box of all monitors
+    const WorldBounds& PhysicsBounds() const { return physicsBounds; }
+
+    // The exact desktop outline for StepCubeDesktop, NULL in mirror mode
+    const DesktopShape* Shape() const;
+
+    // Index of the output containing (x, y), or -1 for dead desktop area. Left
+    // and top edges belong to a monitor, right and bottom edges do not.
+    int OutputAt(float x, float y) const;
+
+    // Outputs a square of half size `halfSize` around (x, y) touches, edges
+    // included, in ascending order. Replaces `result`. Safe to call from
+    // several threads at once.
+    void OutputsTouching(float x, float y, float halfSize, std::vector<int>& result) const;
+
+private:
+    std::vector<DisplayOutput> outputs;
+    int primaryIndex;
+    bool mirrorMode;
+    WorldBounds physicsBounds;
+    DesktopShape shape;
+    unsigned int generation;
+    unsigned long long layoutHash;
+
+    // Uniform grid of square cells over the bounding box of every monitor,
+    // about one cell per monitor however they are arranged. Each cell lists
+    // the outputs overlapping it, edges included, in ascending order in
+    // cellOutputs[cellStart[c]..cellStart[c + 1]).
+    int gridLeft, gridTop, gridRight, gridBottom;
+    int cellSize, cellsX, cellsY;
+    std::vector<int> cellStart;
+    std::vector<int> cellOutputs;
+
+    void BuildGrid();
+    int CellColumn(float x) const;
+    int CellRow(float y) const;
+};
+
+// Put the cube at the center of the primary monitor, or the nearest spot there
+// the desktop shape allows
+void PlaceCubeOnPrimary(Cube& cube, const DisplayTopology& topology);
+
+// After a layout change: move the cube to the primary monitor if its position
+// no longer exists on the desktop. Returns true if it was moved.
+bool KeepCubeOnDesktop(Cube& cube, const DisplayTopology& topology);